@@ -18,6 +18,7 @@
 #include <vector>
 #include <iostream>
 #include <cstring>
+#include <cmath>
 #include <stdio.h>
 
 #include "boost/smart_ptr/shared_ptr.hpp"
@@ -55,6 +56,12 @@ gridpack::powerflow::PFBus::PFBus(void)
   p_ignore = false;
   p_vMag_ptr = NULL;
   p_vAng_ptr = NULL;
+#ifdef LARGE_MATRIX
+  p_fixedLayout = true;
+#else
+  p_fixedLayout = false;
+#endif
+  p_qlimSide = 0;
 }
 
 /**
@@ -73,12 +80,11 @@ bool gridpack::powerflow::PFBus::matrixDiagSize(int *isize, int *jsize) const
 {
   if (p_mode == Jacobian) {
     if (!isIsolated()) {
-#ifdef LARGE_MATRIX
-      *isize = 2;
-      *jsize = 2;
-      return true;
-#else
-      if (getReferenceBus()) {
+      if (p_fixedLayout) {
+        *isize = 2;
+        *jsize = 2;
+        return true;
+      } else if (getReferenceBus()) {
         return false;
       } else if (p_isPV) {
         *isize = 1;
@@ -89,12 +95,22 @@ bool gridpack::powerflow::PFBus::matrixDiagSize(int *isize, int *jsize) const
         *jsize = 2;
         return true;
       }
-#endif
     } else {
       return false;
     }
   } else if (p_mode == YBus) {
     return YMBus::matrixDiagSize(isize,jsize);
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == DCMatrix) {
+    if (isIsolated() || getReferenceBus()) return false;
+    *isize = 1;
+    *jsize = 1;
+    return true;
+  } else if (p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX) {
+    if (isIsolated() || getReferenceBus() || p_isPV) return false;
+    *isize = 1;
+    *jsize = 1;
+    return true;
   }
   return true;
 }
@@ -118,6 +134,14 @@ bool gridpack::powerflow::PFBus::matrixDiagValues(ComplexType *values)
     } else  {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    double rval;
+    int nvals = decoupledDiagonalValues(&rval);
+    if (nvals == 0) return false;
+    values[0] = rval;
+    return true;
   }
   return false;
 }
@@ -131,6 +155,15 @@ bool gridpack::powerflow::PFBus::matrixDiagValues(RealType *values)
     } else  {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    int nvals = decoupledDiagonalValues(values);
+    if (nvals == 0) {
+      return false;
+    } else  {
+      return true;
+    }
   }
   return false;
 }
@@ -143,13 +176,15 @@ bool gridpack::powerflow::PFBus::matrixDiagValues(RealType *values)
  */
 bool gridpack::powerflow::PFBus::vectorSize(int *size) const
 {
+  if (p_mode == WarmStart) {
+    *size = 2;
+    return true;
+  }
   if (p_mode == RHS || p_mode == State) {
     if (!isIsolated()) {
-#ifdef LARGE_MATRIX
-      *size = 2;
-      return true;
-#else
-      if (getReferenceBus()) {
+      if (p_fixedLayout) {
+        *size = 2;
+      } else if (getReferenceBus()) {
         return false;
       } else if (p_isPV) {
         *size = 1;
@@ -157,12 +192,18 @@ bool gridpack::powerflow::PFBus::vectorSize(int *size) const
         *size = 2;
       }
       return true;
-#endif
     } else {
       return false;
     }
   } else if (p_mode == S_Cal){
     *size = 1;
+  } else if (p_mode == PMismatch || p_mode == DCInjection ||
+      p_mode == DCAngle || p_mode == DCBusIndex) {
+    if (isIsolated() || getReferenceBus()) return false;
+    *size = 1;
+  } else if (p_mode == QMismatch) {
+    if (isIsolated() || getReferenceBus() || p_isPV) return false;
+    *size = 1;
   } else {
     *size = 2;
   }
@@ -183,7 +224,7 @@ bool gridpack::powerflow::PFBus::vectorValues(ComplexType *values)
     gridpack::ComplexType ret(retr, reti);
     values[0] = ret;
     return true;
-  } else if (p_mode == State) {
+  } else if (p_mode == State || p_mode == WarmStart) {
     values[0] = p_v;
     values[1] = p_a;
     return true;
@@ -196,13 +237,30 @@ bool gridpack::powerflow::PFBus::vectorValues(ComplexType *values)
     } else {
       return true;
     }
+  } else if (p_mode == PMismatch || p_mode == QMismatch) {
+    double rval;
+    int nvals = decoupledMismatchValues(&rval);
+    if (nvals == 0) return false;
+    values[0] = rval;
+    return true;
+  } else if (p_mode == DCInjection || p_mode == DCAngle ||
+      p_mode == DCBusIndex) {
+    if (isIsolated() || getReferenceBus()) return false;
+    if (p_mode == DCInjection) {
+      values[0] = p_P0;
+    } else if (p_mode == DCAngle) {
+      values[0] = p_a;
+    } else {
+      values[0] = static_cast<double>(getOriginalIndex());
+    }
+    return true;
   }
   return false;
 }
 
 bool gridpack::powerflow::PFBus::vectorValues(RealType *values)
 {
-  if (p_mode == State) {
+  if (p_mode == State || p_mode == WarmStart) {
     values[0] = p_v;
     values[1] = p_a;
     return true;
@@ -215,6 +273,25 @@ bool gridpack::powerflow::PFBus::vectorValues(RealType *values)
       return true;
     }
   }
+  if (p_mode == PMismatch || p_mode == QMismatch) {
+    int nvals = decoupledMismatchValues(values);
+    if (nvals == 0) {
+      return false;
+    } else {
+      return true;
+    }
+  }
+  if (p_mode == DCInjection || p_mode == DCAngle || p_mode == DCBusIndex) {
+    if (isIsolated() || getReferenceBus()) return false;
+    if (p_mode == DCInjection) {
+      values[0] = p_P0;
+    } else if (p_mode == DCAngle) {
+      values[0] = p_a;
+    } else {
+      values[0] = static_cast<double>(getOriginalIndex());
+    }
+    return true;
+  }
   return false;
 }
 
@@ -287,6 +364,97 @@ bool gridpack::powerflow::PFBus::chkQlim(void)
   return false;
 }
 
+/**
+ * Use the same block layout for every bus in the Jacobian, RHS and State
+ * modes. Each bus contributes two rows; the rows of the reference bus are
+ * identity rows and the reactive power row of a PV bus is replaced by
+ * dV = 0. Bus types can then change without changing the matrix layout
+ * @param flag true if fixed layout is used
+ */
+void gridpack::powerflow::PFBus::setFixedLayout(bool flag)
+{
+  p_fixedLayout = flag;
+}
+
+/**
+ * Check whether the fixed block layout is used
+ * @return true if every bus contributes two rows
+ */
+bool gridpack::powerflow::PFBus::hasFixedLayout(void) const
+{
+  return p_fixedLayout;
+}
+
+/**
+ * Check the reactive power of a PV bus against the limits of its
+ * generators. The reactive injection is the value from the last evaluation
+ * of the RHS, so this should only be called on buses owned by this
+ * processor, after the RHS vector has been mapped
+ * @return 1 if generation is above the combined QMAX, -1 if it is below
+ *         the combined QMIN, 0 otherwise (including non-PV buses)
+ */
+int gridpack::powerflow::PFBus::getQlimViolation(void)
+{
+  if (!p_isPV || getReferenceBus() || isIsolated()) return 0;
+  double qmax = 0.0;
+  double qmin = 0.0;
+  bool usegen = false;
+  int i;
+  for (i=0; i<p_gstatus.size(); i++) {
+    if (p_gstatus[i] == 1) {
+      qmax += p_qmax[i];
+      qmin += p_qmin[i];
+      usegen = true;
+    }
+  }
+  if (!usegen) return 0;
+  double ql = 0.0;
+  for (i=0; i<p_lstatus.size(); i++) {
+    if (p_lstatus[i] == 1) ql += p_ql[i];
+  }
+  double qg = p_Qinj*p_sbase + ql;
+  if (qg > qmax) return 1;
+  if (qg < qmin) return -1;
+  return 0;
+}
+
+/**
+ * Turn a PV bus into a PQ bus with its generators held at their reactive
+ * power limit. Generators stay in service. The change is undone by
+ * clearQlim()
+ * @param side 1 to hold generation at QMAX, -1 to hold it at QMIN
+ */
+void gridpack::powerflow::PFBus::setQlim(int side)
+{
+  if (side == 0 || !p_isPV) return;
+  double pl = 0.0;
+  double ql = 0.0;
+  double qg = 0.0;
+  int i;
+  for (i=0; i<p_gstatus.size(); i++) {
+    if (p_gstatus[i] == 1) qg += (side > 0 ? p_qmax[i] : p_qmin[i]);
+  }
+  for (i=0; i<p_lstatus.size(); i++) {
+    if (p_lstatus[i] == 1) ql += p_ql[i];
+  }
+  p_Q0 = (qg - ql)/p_sbase;
+  p_isPV = false;
+  p_qlimSide = side;
+}
+
+/**
+ * Restore a bus switched by setQlim() to a PV bus. The scheduled reactive
+ * power is restored by the next call to setSBus()
+ * @return true if the bus had been switched
+ */
+bool gridpack::powerflow::PFBus::clearQlim(void)
+{
+  if (p_qlimSide == 0) return false;
+  p_isPV = true;
+  p_qlimSide = 0;
+  return true;
+}
+
 /**
  * Set the internal values of the voltage magnitude and phase angle. Need this
  * function to push values from vectors back onto buses 
@@ -296,14 +464,21 @@ void gridpack::powerflow::PFBus::setValues(gridpack::ComplexType *values)
 {
   double vt = p_v;
   double at = p_a;
-  p_a -= real(values[0]);
-#ifdef LARGE_MATRIX
-  p_v -= real(values[1]);
-#else
-  if (!p_isPV) {
-    p_v -= real(values[1]);
+  if (p_mode == PMismatch) {
+    p_a -= real(values[0]);
+  } else if (p_mode == DCInjection || p_mode == DCAngle) {
+    p_a = real(values[0]);
+  } else if (p_mode == WarmStart) {
+    p_v = real(values[0]);
+    p_a = real(values[1]);
+  } else if (p_mode == QMismatch) {
+    p_v -= real(values[0]);
+  } else {
+    p_a -= real(values[0]);
+    if (p_fixedLayout || !p_isPV) {
+      p_v -= real(values[1]);
+    }
   }
-#endif
   *p_vAng_ptr = p_a;
   *p_vMag_ptr = p_v;
 }
@@ -312,14 +487,21 @@ void gridpack::powerflow::PFBus::setValues(gridpack::RealType *values)
 {
   double vt = p_v;
   double at = p_a;
-  p_a -= values[0];
-#ifdef LARGE_MATRIX
-  p_v -= real(values[1]);
-#else
-  if (!p_isPV) {
-    p_v -= values[1];
+  if (p_mode == PMismatch) {
+    p_a -= values[0];
+  } else if (p_mode == DCInjection || p_mode == DCAngle) {
+    p_a = values[0];
+  } else if (p_mode == WarmStart) {
+    p_v = values[0];
+    p_a = values[1];
+  } else if (p_mode == QMismatch) {
+    p_v -= values[0];
+  } else {
+    p_a -= values[0];
+    if (p_fixedLayout || !p_isPV) {
+      p_v -= values[1];
+    }
   }
-#endif
   *p_vAng_ptr = p_a;
   *p_vMag_ptr = p_v;
 }
@@ -604,6 +786,8 @@ void gridpack::powerflow::PFBus::setGenStatus(std::string gen_id, bool status)
  */
 void gridpack::powerflow::PFBus::setIsPV(int status)
 {
+  // The saved status is the bus type before any reactive limit switching
+  clearQlim();
   p_saveisPV = p_isPV;
   p_isPV = status;
   p_v = p_voltage;
@@ -820,7 +1004,6 @@ bool gridpack::powerflow::PFBus::serialWrite(char *string, const int bufsize,
     int ngen=p_pFac.size();
     // Evalate p_Pinj and p_Qinj if bus is reference bus. This is skipped when
     // evaluating matrix elements.
-#ifndef LARGE_MATRIX
     if (getReferenceBus() || isIsolated()) {
       std::vector<boost::shared_ptr<BaseComponent> > branches;
       getNeighborBranches(branches);
@@ -841,7 +1024,6 @@ bool gridpack::powerflow::PFBus::serialWrite(char *string, const int bufsize,
       p_Pinj = P;
       p_Qinj = Q;
     }
-#endif
     double pl =0.0;
     double ql =0.0;
     for (i=0; i<p_pl.size(); i++) {
@@ -910,7 +1092,6 @@ void gridpack::powerflow::PFBus::saveData(
   int ngen=p_pFac.size();
   // Evalate p_Pinj and p_Qinj if bus is reference bus. This is skipped when
   // evaluating matrix elements.
-#ifndef LARGE_MATRIX
   if (getReferenceBus() || isIsolated()) {
     std::vector<boost::shared_ptr<BaseComponent> > branches;
     getNeighborBranches(branches);
@@ -931,7 +1112,6 @@ void gridpack::powerflow::PFBus::saveData(
     p_Pinj = P;
     p_Qinj = Q;
   }
-#endif
   double pl=0.0;
   double ql=0.0;
   for (i=0; i<p_pl.size(); i++) {
@@ -956,8 +1136,9 @@ void gridpack::powerflow::PFBus::saveData(
  * Modify parameters inside the bus module. This is designed to be
  * extensible
  * @param name character string describing parameter to be modified
- * @param busID generator bus number
- * @param genID specified genID
+ * (GENERATOR_PG, GENERATOR_QG, LOAD_PL or LOAD_QL)
+ * @param busID generator or load bus number
+ * @param genID specified genID (or load ID for loads)
  * @param value new value of parameter
  */
 void gridpack::powerflow::PFBus::setParam(std::string name, int busID, 
@@ -975,6 +1156,17 @@ void gridpack::powerflow::PFBus::setParam(std::string name, int busID,
         }
       }
     }
+    if (p_nload > 0 && (name == LOAD_PL || name == LOAD_QL)) {
+      for (int i = 0; i < p_nload; i++) {
+        if (p_lid[i] == genID) {
+          if (name == LOAD_PL) {
+            p_pl[i] = value;
+          } else {
+            p_ql[i] = value;
+          }
+        }
+      }
+    }
   }
 }
 
@@ -1093,41 +1285,41 @@ int gridpack::powerflow::PFBus::getArea()
 int gridpack::powerflow::PFBus::diagonalJacobianValues(double *rvals)
 {
   if (!isIsolated()) {
-#ifdef LARGE_MATRIX
-    if (!getReferenceBus()) {
-      rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
-      rvals[1] = p_Pinj - p_ybusr * p_v *p_v; 
-      rvals[2] = p_Pinj / p_v + p_ybusr * p_v; 
-      rvals[3] = p_Qinj / p_v - p_ybusi * p_v; 
-      // Fix up matrix elements if bus is PV bus
-      if (p_isPV) {
+    if (p_fixedLayout) {
+      if (!getReferenceBus()) {
+        rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
+        rvals[1] = p_Pinj - p_ybusr * p_v *p_v; 
+        rvals[2] = p_Pinj / p_v + p_ybusr * p_v; 
+        rvals[3] = p_Qinj / p_v - p_ybusi * p_v; 
+        // Fix up matrix elements if bus is PV bus
+        if (p_isPV) {
+          rvals[1] = 0.0;
+          rvals[2] = 0.0;
+          rvals[3] = 1.0;
+        }
+        return 4;
+      } else {
+        rvals[0] = 1.0;
         rvals[1] = 0.0;
         rvals[2] = 0.0;
         rvals[3] = 1.0;
+        return 4;
       }
-      return 4;
-    } else {
-      rvals[0] = 1.0;
-      rvals[1] = 0.0;
-      rvals[2] = 0.0;
-      rvals[3] = 1.0;
-      return 4;
-    }
-#else
-    if (!getReferenceBus() && !p_isPV) {
-      rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
-      rvals[1] = p_Pinj - p_ybusr * p_v *p_v; 
-      rvals[2] = p_Pinj / p_v + p_ybusr * p_v; 
-      rvals[3] = p_Qinj / p_v - p_ybusi * p_v; 
-      // Fix up matrix elements if bus is PV bus
-      return 4;
-    } else if (!getReferenceBus() && p_isPV) {
-      rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
-      return 1;
     } else {
-      return 0;
+      if (!getReferenceBus() && !p_isPV) {
+        rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
+        rvals[1] = p_Pinj - p_ybusr * p_v *p_v; 
+        rvals[2] = p_Pinj / p_v + p_ybusr * p_v; 
+        rvals[3] = p_Qinj / p_v - p_ybusi * p_v; 
+        // Fix up matrix elements if bus is PV bus
+        return 4;
+      } else if (!getReferenceBus() && p_isPV) {
+        rvals[0] = -p_Qinj - p_ybusi * p_v *p_v; 
+        return 1;
+      } else {
+        return 0;
+      }
     }
-#endif
   } else {
     return 0;
   }
@@ -1166,52 +1358,121 @@ int gridpack::powerflow::PFBus::rhsValues(double *rvals)
       P -= p_P0;
       Q -= p_Q0;
       rvals[0] = P;
-#ifdef LARGE_MATRIX
-      if (!p_isPV) {
-        rvals[1] = Q;
-      } else {
-        rvals[1] = 0.0;
-      }
-      nvals = 2;
-#else
-      nvals = 1;
-      if (!p_isPV) {
-        rvals[1] = Q;
+      if (p_fixedLayout) {
+        if (!p_isPV) {
+          rvals[1] = Q;
+        } else {
+          rvals[1] = 0.0;
+        }
         nvals = 2;
+      } else {
+        nvals = 1;
+        if (!p_isPV) {
+          rvals[1] = Q;
+          nvals = 2;
+        }
       }
-#endif
       return nvals;
     } else {
-#ifdef LARGE_MATRIX
+      if (p_fixedLayout) {
+        std::vector<boost::shared_ptr<BaseComponent> > branches;
+        getNeighborBranches(branches);
+        int size = branches.size();
+        int i;
+        double P, Q, p, q;
+        P = 0.0;
+        Q = 0.0;
+        for (i=0; i<size; i++) {
+          gridpack::powerflow::PFBranch *branch
+            = dynamic_cast<gridpack::powerflow::PFBranch*>(branches[i].get());
+          branch->getPQ(this, &p, &q);
+          P += p;
+          Q += q;
+        }
+        // Also add bus i's own Pi, Qi
+        P += p_v*p_v*p_ybusr;
+        Q += p_v*p_v*(-p_ybusi);
+        p_Pinj = P;
+        p_Qinj = Q;
+        rvals[0] = 0.0;
+        rvals[1] = 0.0;
+        return 2;
+      } else {
+        return 0;
+      }
+    }
+  } else {
+    return false;
+  }
+}
+
+/**
+ * Evaluate diagonal element of the fast decoupled B' or B'' matrix,
+ * depending on the current mode. The XB B'' matrix is the imaginary part of
+ * the Y-bus, while the BX B'' matrix neglects the resistance of the series
+ * elements
+ * @param rvals value of diagonal element
+ * @return number of values returned
+ */
+int gridpack::powerflow::PFBus::decoupledDiagonalValues(double *rvals)
+{
+  if (isIsolated() || getReferenceBus()) return 0;
+  if (p_mode == BPrimeXB || p_mode == BPrimeBX || p_mode == DCMatrix) {
+    // B' neglects shunts, line charging, and off-nominal taps
+    std::vector<boost::shared_ptr<BaseComponent> > branches;
+    getNeighborBranches(branches);
+    int size = branches.size();
+    double b = 0.0;
+    for (int i=0; i<size; i++) {
+      gridpack::powerflow::PFBranch *branch
+        = dynamic_cast<gridpack::powerflow::PFBranch*>(branches[i].get());
+      if (p_mode == DCMatrix) {
+        b += branch->getDCSusceptance();
+      } else {
+        b += branch->getSeriesSusceptance(p_mode == BPrimeXB);
+      }
+    }
+    rvals[0] = b;
+    return 1;
+  } else if (p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX) {
+    if (p_isPV) return 0;
+    rvals[0] = -p_ybusi;
+    if (p_mode == BDoublePrimeBX) {
+      // replace the series elements in the Y-bus with their reactance only
       std::vector<boost::shared_ptr<BaseComponent> > branches;
       getNeighborBranches(branches);
       int size = branches.size();
-      int i;
-      double P, Q, p, q;
-      P = 0.0;
-      Q = 0.0;
-      for (i=0; i<size; i++) {
+      for (int i=0; i<size; i++) {
         gridpack::powerflow::PFBranch *branch
           = dynamic_cast<gridpack::powerflow::PFBranch*>(branches[i].get());
-        branch->getPQ(this, &p, &q);
-        P += p;
-        Q += q;
+        rvals[0] += imag(branch->getSeriesSelf(this,false));
+        rvals[0] -= imag(branch->getSeriesSelf(this,true));
       }
-      // Also add bus i's own Pi, Qi
-      P += p_v*p_v*p_ybusr;
-      Q += p_v*p_v*(-p_ybusi);
-      p_Pinj = P;
-      p_Qinj = Q;
-      rvals[0] = 0.0;
-      rvals[1] = 0.0;
-      return 2;
-#else
-      return 0;
-#endif
     }
-  } else {
-    return false;
+    return 1;
   }
+  return 0;
+}
+
+/**
+ * Evaluate the real (P/V) or reactive (Q/V) power mismatch used by the
+ * fast decoupled power flow, depending on the current mode
+ * @param rvals value of mismatch
+ * @return number of values returned
+ */
+int gridpack::powerflow::PFBus::decoupledMismatchValues(double *rvals)
+{
+  double mismatch[2];
+  int nvals = rhsValues(mismatch);
+  if (nvals == 0) return 0;
+  if (p_mode == PMismatch) {
+    rvals[0] = mismatch[0]/p_v;
+    return 1;
+  } else if (p_mode == QMismatch && !p_isPV) {
+    rvals[0] = mismatch[1]/p_v;
+    return 1;
+  }
+  return 0;
 }
 
 /**
@@ -1323,36 +1584,59 @@ bool gridpack::powerflow::PFBranch::matrixForwardSize(int *isize, int *jsize) co
     ok = ok && !bus2->isIsolated();
     ok = ok && (p_active);
     if (ok) {
-#ifdef LARGE_MATRIX
-      *isize = 2;
-      *jsize = 2;
-      return true;
-#else
-      bool bus1PV = bus1->isPV();
-      bool bus2PV = bus2->isPV();
-      if (bus1PV && bus2PV) {
-        *isize = 1;
-        *jsize = 1;
-        return true;
-      } else if (bus1PV) {
-        *isize = 1;
-        *jsize = 2;
-        return true;
-      } else if (bus2PV) {
-        *isize = 2;
-        *jsize = 1;
-        return true;
-      } else {
+      if (bus1->hasFixedLayout()) {
         *isize = 2;
         *jsize = 2;
         return true;
+      } else {
+        bool bus1PV = bus1->isPV();
+        bool bus2PV = bus2->isPV();
+        if (bus1PV && bus2PV) {
+          *isize = 1;
+          *jsize = 1;
+          return true;
+        } else if (bus1PV) {
+          *isize = 1;
+          *jsize = 2;
+          return true;
+        } else if (bus2PV) {
+          *isize = 2;
+          *jsize = 1;
+          return true;
+        } else {
+          *isize = 2;
+          *jsize = 2;
+          return true;
+        }
       }
-#endif
     } else {
       return false;
     }
   } else if (p_mode == YBus) {
     return YMBranch::matrixForwardSize(isize,jsize);
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    gridpack::powerflow::PFBus *bus1
+      = dynamic_cast<gridpack::powerflow::PFBus*>(getBus1().get());
+    gridpack::powerflow::PFBus *bus2
+      = dynamic_cast<gridpack::powerflow::PFBus*>(getBus2().get());
+    bool ok = !bus1->getReferenceBus();
+    ok = ok && !bus2->getReferenceBus();
+    ok = ok && !bus1->isIsolated();
+    ok = ok && !bus2->isIsolated();
+    ok = ok && (p_active);
+    if (p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX) {
+      ok = ok && !bus1->isPV();
+      ok = ok && !bus2->isPV();
+    }
+    if (ok) {
+      *isize = 1;
+      *jsize = 1;
+      return true;
+    } else {
+      return false;
+    }
   }
   return false;
 }
@@ -1369,36 +1653,59 @@ bool gridpack::powerflow::PFBranch::matrixReverseSize(int *isize, int *jsize) co
     ok = ok && !bus2->isIsolated();
     ok = ok && (p_active);
     if (ok) {
-#ifdef LARGE_MATRIX
-      *isize = 2;
-      *jsize = 2;
-      return true;
-#else
-      bool bus1PV = bus1->isPV();
-      bool bus2PV = bus2->isPV();
-      if (bus1PV && bus2PV) {
-        *isize = 1;
-        *jsize = 1;
-        return true;
-      } else if (bus1PV) {
+      if (bus1->hasFixedLayout()) {
         *isize = 2;
-        *jsize = 1;
-        return true;
-      } else if (bus2PV) {
-        *isize = 1;
         *jsize = 2;
         return true;
       } else {
-        *isize = 2;
-        *jsize = 2;
-        return true;
+        bool bus1PV = bus1->isPV();
+        bool bus2PV = bus2->isPV();
+        if (bus1PV && bus2PV) {
+          *isize = 1;
+          *jsize = 1;
+          return true;
+        } else if (bus1PV) {
+          *isize = 2;
+          *jsize = 1;
+          return true;
+        } else if (bus2PV) {
+          *isize = 1;
+          *jsize = 2;
+          return true;
+        } else {
+          *isize = 2;
+          *jsize = 2;
+          return true;
+        }
       }
-#endif
     } else {
       return false;
     }
   } else if (p_mode == YBus) {
     return YMBranch::matrixReverseSize(isize,jsize);
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    gridpack::powerflow::PFBus *bus1
+      = dynamic_cast<gridpack::powerflow::PFBus*>(getBus1().get());
+    gridpack::powerflow::PFBus *bus2
+      = dynamic_cast<gridpack::powerflow::PFBus*>(getBus2().get());
+    bool ok = !bus1->getReferenceBus();
+    ok = ok && !bus2->getReferenceBus();
+    ok = ok && !bus1->isIsolated();
+    ok = ok && !bus2->isIsolated();
+    ok = ok && (p_active);
+    if (p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX) {
+      ok = ok && !bus1->isPV();
+      ok = ok && !bus2->isPV();
+    }
+    if (ok) {
+      *isize = 1;
+      *jsize = 1;
+      return true;
+    } else {
+      return false;
+    }
   }
   return false;
 }
@@ -1420,6 +1727,14 @@ bool gridpack::powerflow::PFBranch::matrixForwardValues(ComplexType *values)
     } else {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    double rval;
+    int nvals = forwardDecoupledValues(&rval);
+    if (nvals == 0) return false;
+    values[0] = rval;
+    return true;
   } else if (p_mode == YBus) {
     return YMBranch::matrixForwardValues(values);
   }
@@ -1435,6 +1750,15 @@ bool gridpack::powerflow::PFBranch::matrixForwardValues(RealType *values)
     } else {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    int nvals = forwardDecoupledValues(values);
+    if (nvals == 0) {
+      return false;
+    } else {
+      return true;
+    }
   }
   return false;
 }
@@ -1450,6 +1774,14 @@ bool gridpack::powerflow::PFBranch::matrixReverseValues(ComplexType *values)
     } else {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    double rval;
+    int nvals = reverseDecoupledValues(&rval);
+    if (nvals == 0) return false;
+    values[0] = rval;
+    return true;
   } else if (p_mode == YBus) {
     return YMBranch::matrixForwardValues(values);
   }
@@ -1465,6 +1797,15 @@ bool gridpack::powerflow::PFBranch::matrixReverseValues(RealType *values)
     } else {
       return true;
     }
+  } else if (p_mode == BPrimeXB || p_mode == BPrimeBX ||
+      p_mode == BDoublePrimeXB || p_mode == BDoublePrimeBX ||
+      p_mode == DCMatrix) {
+    int nvals = reverseDecoupledValues(values);
+    if (nvals == 0) {
+      return false;
+    } else {
+      return true;
+    }
   }
   return false;
 }
@@ -1936,46 +2277,7 @@ int gridpack::powerflow::PFBranch::forwardJacobianValues(double *rvals)
     double sn = sin(p_theta);
     bool bus1PV = bus1->isPV();
     bool bus2PV = bus2->isPV();
-#ifdef LARGE_MATRIX
-    rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
-    rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
-    rvals[2] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
-    rvals[3] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
-    rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-    rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
-    rvals[2] *= bus1->getVoltage();
-    rvals[3] *= bus1->getVoltage();
-    // fix up matrix if one or both buses at the end of the branch is a PV bus
-    if (bus1PV && bus2PV) {
-      rvals[1] = 0.0;
-      rvals[2] = 0.0;
-      rvals[3] = 0.0;
-    } else if (bus1PV) {
-      rvals[1] = 0.0;
-      rvals[3] = 0.0;
-    } else if (bus2PV) {
-      rvals[2] = 0.0;
-      rvals[3] = 0.0;
-    }
-    nvals = 4;
-#else
-    if (bus1PV && bus2PV) {
-      rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      nvals = 1;
-    } else if (bus1PV) {
-      rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
-      rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      rvals[1] *= bus1->getVoltage();
-      nvals = 2;
-    } else if (bus2PV) {
-      rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
-      rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
-      nvals = 2;
-    } else {
+    if (bus1->hasFixedLayout()) {
       rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
       rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
       rvals[2] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
@@ -1984,9 +2286,48 @@ int gridpack::powerflow::PFBranch::forwardJacobianValues(double *rvals)
       rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
       rvals[2] *= bus1->getVoltage();
       rvals[3] *= bus1->getVoltage();
+      // fix up matrix if one or both buses at the end of the branch is a PV bus
+      if (bus1PV && bus2PV) {
+        rvals[1] = 0.0;
+        rvals[2] = 0.0;
+        rvals[3] = 0.0;
+      } else if (bus1PV) {
+        rvals[1] = 0.0;
+        rvals[3] = 0.0;
+      } else if (bus2PV) {
+        rvals[2] = 0.0;
+        rvals[3] = 0.0;
+      }
       nvals = 4;
-    }  
-#endif
+    } else {
+      if (bus1PV && bus2PV) {
+        rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        nvals = 1;
+      } else if (bus1PV) {
+        rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
+        rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= bus1->getVoltage();
+        nvals = 2;
+      } else if (bus2PV) {
+        rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
+        rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
+        nvals = 2;
+      } else {
+        rvals[0] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
+        rvals[1] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
+        rvals[2] = (p_ybusr_frwd*cs + p_ybusi_frwd*sn);
+        rvals[3] = (p_ybusr_frwd*sn - p_ybusi_frwd*cs);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[2] *= bus1->getVoltage();
+        rvals[3] *= bus1->getVoltage();
+        nvals = 4;
+      }  
+    }
     return nvals;
   } else {
     return 0;
@@ -2011,46 +2352,7 @@ int gridpack::powerflow::PFBranch::reverseJacobianValues(double *rvals)
     double sn = sin(-p_theta);
     bool bus1PV = bus1->isPV();
     bool bus2PV = bus2->isPV();
-#ifdef LARGE_MATRIX
-    rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
-    rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
-    rvals[2] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
-    rvals[3] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
-    rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-    rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
-    rvals[2] *= bus2->getVoltage();
-    rvals[3] *= bus2->getVoltage();
-    // fix up matrix if one or both buses at the end of the branch is a PV bus
-    if (bus1PV && bus2PV) {
-      rvals[1] = 0.0;
-      rvals[2] = 0.0;
-      rvals[3] = 0.0;
-    } else if (bus1PV) {
-      rvals[2] = 0.0;
-      rvals[3] = 0.0;
-    } else if (bus2PV) {
-      rvals[1] = 0.0;
-      rvals[3] = 0.0;
-    }
-    nvals = 4;
-#else
-    if (bus1PV && bus2PV) {
-      rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      nvals = 1;
-    } else if (bus1PV) {
-      rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
-      rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
-      nvals = 2;
-    } else if (bus2PV) {
-      rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
-      rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
-      rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
-      rvals[1] *= bus2->getVoltage();
-      nvals = 2;
-    } else {
+    if (bus1->hasFixedLayout()) {
       rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
       rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
       rvals[2] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
@@ -2059,11 +2361,175 @@ int gridpack::powerflow::PFBranch::reverseJacobianValues(double *rvals)
       rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
       rvals[2] *= bus2->getVoltage();
       rvals[3] *= bus2->getVoltage();
+      // fix up matrix if one or both buses at the end of the branch is a PV bus
+      if (bus1PV && bus2PV) {
+        rvals[1] = 0.0;
+        rvals[2] = 0.0;
+        rvals[3] = 0.0;
+      } else if (bus1PV) {
+        rvals[2] = 0.0;
+        rvals[3] = 0.0;
+      } else if (bus2PV) {
+        rvals[1] = 0.0;
+        rvals[3] = 0.0;
+      }
       nvals = 4;
-    } 
-#endif
+    } else {
+      if (bus1PV && bus2PV) {
+        rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        nvals = 1;
+      } else if (bus1PV) {
+        rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
+        rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
+        nvals = 2;
+      } else if (bus2PV) {
+        rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
+        rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= bus2->getVoltage();
+        nvals = 2;
+      } else {
+        rvals[0] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
+        rvals[1] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
+        rvals[2] = (p_ybusr_rvrs*cs + p_ybusi_rvrs*sn);
+        rvals[3] = (p_ybusr_rvrs*sn - p_ybusi_rvrs*cs);
+        rvals[0] *= ((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[1] *= -((bus1->getVoltage())*(bus2->getVoltage()));
+        rvals[2] *= bus2->getVoltage();
+        rvals[3] *= bus2->getVoltage();
+        nvals = 4;
+      } 
+    }
     return nvals;
   } else {
     return 0;
   }
 }
+
+/**
+ * Return the total series susceptance of the active line elements on
+ * this branch. This is used to build the fast decoupled B' matrix
+ * @param ignoreR if true, resistance is neglected and the susceptance of
+ * each element is 1/x (XB scheme), otherwise it is x/(r*r+x*x) (BX scheme)
+ * @return series susceptance
+ */
+double gridpack::powerflow::PFBranch::getSeriesSusceptance(bool ignoreR)
+{
+  double ret = 0.0;
+  for (int i=0; i<p_elems; i++) {
+    if (!p_branch_status[i]) continue;
+    double r = p_resistance[i];
+    double x = p_reactance[i];
+    if (ignoreR) {
+      if (x != 0.0) ret += 1.0/x;
+    } else {
+      if (r != 0.0 || x != 0.0) ret += x/(r*r+x*x);
+    }
+  }
+  return ret;
+}
+
+/**
+ * Evaluate off-diagonal element of the fast decoupled B' or B'' matrix,
+ * depending on the current mode
+ * @param rvals value of off-diagonal element
+ * @return number of values returned
+ */
+int gridpack::powerflow::PFBranch::forwardDecoupledValues(double *rvals)
+{
+  int isize, jsize;
+  if (!matrixForwardSize(&isize,&jsize)) return 0;
+  if (p_mode == BDoublePrimeXB) {
+    rvals[0] = -p_ybusi_frwd;
+  } else if (p_mode == BDoublePrimeBX) {
+    gridpack::ComplexType frwd, rvrs;
+    getSeriesYBus(true, &frwd, &rvrs);
+    rvals[0] = -imag(frwd);
+  } else if (p_mode == DCMatrix) {
+    rvals[0] = -getDCSusceptance();
+  } else {
+    rvals[0] = -getSeriesSusceptance(p_mode == BPrimeXB);
+  }
+  return 1;
+}
+
+int gridpack::powerflow::PFBranch::reverseDecoupledValues(double *rvals)
+{
+  int isize, jsize;
+  if (!matrixReverseSize(&isize,&jsize)) return 0;
+  if (p_mode == BDoublePrimeXB) {
+    rvals[0] = -p_ybusi_rvrs;
+  } else if (p_mode == BDoublePrimeBX) {
+    gridpack::ComplexType frwd, rvrs;
+    getSeriesYBus(true, &frwd, &rvrs);
+    rvals[0] = -imag(rvrs);
+  } else if (p_mode == DCMatrix) {
+    rvals[0] = -getDCSusceptance();
+  } else {
+    rvals[0] = -getSeriesSusceptance(p_mode == BPrimeXB);
+  }
+  return 1;
+}
+
+/**
+ * Return the total susceptance used in the DC power flow B matrix,
+ * 1/(x*tap), summed over the active line elements on this branch
+ * @return DC susceptance
+ */
+double gridpack::powerflow::PFBranch::getDCSusceptance(void)
+{
+  double ret = 0.0;
+  for (int i=0; i<p_elems; i++) {
+    if (p_branch_status[i]) ret += getDCSusceptance(p_ckt[i]);
+  }
+  return ret;
+}
+
+/**
+ * Return the DC susceptance, 1/(x*tap), of a single line element
+ * @param tag character string identifying branch element
+ * @return DC susceptance, zero if the element is not active
+ */
+double gridpack::powerflow::PFBranch::getDCSusceptance(std::string tag)
+{
+  for (int i=0; i<p_elems; i++) {
+    if (p_ckt[i] == tag) {
+      if (!p_branch_status[i] || p_reactance[i] == 0.0) return 0.0;
+      double tap = 1.0;
+      if (p_xform[i] && p_tap_ratio[i] != 0.0) tap = p_tap_ratio[i];
+      return 1.0/(p_reactance[i]*tap);
+    }
+  }
+  return 0.0;
+}
+
+/**
+ * Return the DC power flow on a single line element, from bus 1 to bus 2,
+ * using the current bus phase angles
+ * @param tag character string identifying branch element
+ * @return real power flow
+ */
+double gridpack::powerflow::PFBranch::getDCFlow(std::string tag)
+{
+  gridpack::powerflow::PFBus *bus1 =
+    dynamic_cast<gridpack::powerflow::PFBus*>(getBus1().get());
+  gridpack::powerflow::PFBus *bus2 =
+    dynamic_cast<gridpack::powerflow::PFBus*>(getBus2().get());
+  return getDCSusceptance(tag)*(bus1->getPhase() - bus2->getPhase());
+}
+
+/**
+ * Return the DC power flow on a single line element as a fraction of its
+ * rating A
+ * @param tag character string identifying branch element
+ * @return loading, zero if the element has no rating
+ */
+double gridpack::powerflow::PFBranch::getDCLoading(std::string tag)
+{
+  double rate = getBranchRatingA(tag);
+  if (rate <= 0.0) return 0.0;
+  return std::abs(getDCFlow(tag))*p_sbase/rate;
+}
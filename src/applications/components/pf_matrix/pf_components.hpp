@@ -27,7 +27,18 @@
 namespace gridpack {
 namespace powerflow {
 
-enum PFMode{YBus, Jacobian, RHS, S_Cal, State};
+// BPrimeXB, BPrimeBX, BDoublePrimeXB, and BDoublePrimeBX build the constant
+// matrices used by the XB and BX fast decoupled power flow, and PMismatch and
+// QMismatch build the corresponding mismatch vectors (divided by voltage
+// magnitude). DCMatrix builds the DC power flow B matrix, DCInjection the
+// real power injections (and sets phase angles), DCAngle gets and sets the
+// phase angles, and DCBusIndex gives the original bus index of each row of
+// these. WarmStart saves and restores the voltage magnitude and phase angle
+// of every bus, with a layout that does not depend on bus type or status.
+enum PFMode{YBus, Jacobian, RHS, S_Cal, State,
+            BPrimeXB, BPrimeBX, BDoublePrimeXB, BDoublePrimeBX,
+            PMismatch, QMismatch,
+            DCMatrix, DCInjection, DCAngle, DCBusIndex, WarmStart};
 
 class PFBus
   : public gridpack::ymatrix::YMBus
@@ -228,6 +239,47 @@ class PFBus
     */
     bool chkQlim(void);
 
+    /**
+     * Use the same block layout for every bus in the Jacobian, RHS and State
+     * modes. Each bus contributes two rows; the rows of the reference bus
+     * are identity rows and the reactive power row of a PV bus is replaced
+     * by dV = 0. Bus types can then change without changing the matrix
+     * layout
+     * @param flag true if fixed layout is used
+     */
+    void setFixedLayout(bool flag);
+
+    /**
+     * Check whether the fixed block layout is used
+     * @return true if every bus contributes two rows
+     */
+    bool hasFixedLayout(void) const;
+
+    /**
+     * Check the reactive power of a PV bus against the limits of its
+     * generators. The reactive injection is the value from the last
+     * evaluation of the RHS, so this should only be called on buses owned
+     * by this processor, after the RHS vector has been mapped
+     * @return 1 if generation is above the combined QMAX, -1 if it is
+     *         below the combined QMIN, 0 otherwise (including non-PV buses)
+     */
+    int getQlimViolation(void);
+
+    /**
+     * Turn a PV bus into a PQ bus with its generators held at their
+     * reactive power limit. Generators stay in service. The change is
+     * undone by clearQlim()
+     * @param side 1 to hold generation at QMAX, -1 to hold it at QMIN
+     */
+    void setQlim(int side);
+
+    /**
+     * Restore a bus switched by setQlim() to a PV bus. The scheduled
+     * reactive power is restored by the next call to setSBus()
+     * @return true if the bus had been switched
+     */
+    bool clearQlim(void);
+
     /**
      * Save state variables inside the component to a DataCollection object.
      * This can be used as a way of moving data in a way that is useful for
@@ -298,6 +350,22 @@ class PFBus
      */
     int rhsValues(double *rvals);
 
+    /**
+     * Evaluate diagonal element of the fast decoupled B' or B'' matrix (or
+     * the DC power flow B matrix), depending on the current mode
+     * @param rvals value of diagonal element
+     * @return number of values returned
+     */
+    int decoupledDiagonalValues(double *rvals);
+
+    /**
+     * Evaluate the real (P/V) or reactive (Q/V) power mismatch used by the
+     * fast decoupled power flow, depending on the current mode
+     * @param rvals value of mismatch
+     * @return number of values returned
+     */
+    int decoupledMismatchValues(double *rvals);
+
     /**
      * Get vector containing generator participation
      * @return vector of generator participation factors
@@ -352,6 +420,8 @@ class PFBus
     double p_sbase;
     double p_Pinj, p_Qinj;
     bool p_isPV, p_saveisPV;
+    bool p_fixedLayout;
+    int p_qlimSide;
     int p_ngen;
     int p_nload;
     int p_type;
@@ -397,6 +467,7 @@ private:
       & p_Pinj & p_Qinj
       & p_isPV
       & p_saveisPV
+      & p_fixedLayout & p_qlimSide
       & p_ngen & p_type & p_nload
       & p_area;
   }  
@@ -555,6 +626,55 @@ class PFBranch
     int forwardJacobianValues(double *rvals);
     int reverseJacobianValues(double *rvals);
 
+    /**
+     * Return the total series susceptance of the active line elements on
+     * this branch. This is used to build the fast decoupled B' matrix
+     * @param ignoreR if true, resistance is neglected and the
+     * susceptance of each element is 1/x (XB scheme), otherwise it is
+     * x/(r*r+x*x) (BX scheme)
+     * @return series susceptance
+     */
+    double getSeriesSusceptance(bool ignoreR);
+
+    /**
+     * Return the total susceptance used in the DC power flow B matrix,
+     * 1/(x*tap), summed over the active line elements on this branch
+     * @return DC susceptance
+     */
+    double getDCSusceptance(void);
+
+    /**
+     * Return the DC susceptance, 1/(x*tap), of a single line element
+     * @param tag character string identifying branch element
+     * @return DC susceptance, zero if the element is not active
+     */
+    double getDCSusceptance(std::string tag);
+
+    /**
+     * Return the DC power flow on a single line element, from bus 1 to
+     * bus 2, using the current bus phase angles
+     * @param tag character string identifying branch element
+     * @return real power flow
+     */
+    double getDCFlow(std::string tag);
+
+    /**
+     * Return the DC power flow on a single line element as a fraction of
+     * its rating A
+     * @param tag character string identifying branch element
+     * @return loading, zero if the element has no rating
+     */
+    double getDCLoading(std::string tag);
+
+    /**
+     * Evaluate off-diagonal element of the fast decoupled B' or B''
+     * matrix (or the DC power flow B matrix), depending on the current mode
+     * @param rvals value of off-diagonal element
+     * @return number of values returned
+     */
+    int forwardDecoupledValues(double *rvals);
+    int reverseDecoupledValues(double *rvals);
+
   private:
     std::vector<bool> p_ignore;
     std::vector<double> p_reactance;
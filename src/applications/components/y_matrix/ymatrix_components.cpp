@@ -595,6 +595,69 @@ gridpack::ymatrix::YMBranch::getShunt(gridpack::ymatrix::YMBus *bus)
   return gridpack::ComplexType(retr,reti);
 }
 
+/**
+ * Return the off-diagonal Y matrix elements of the series elements of the
+ * branch, optionally neglecting their resistance
+ * @param ignoreR if true, the series impedance of each element is jx
+ * @param frwd forward y-matrix element
+ * @param rvrs reverse y-matrix element
+ */
+void gridpack::ymatrix::YMBranch::getSeriesYBus(bool ignoreR,
+    gridpack::ComplexType *frwd, gridpack::ComplexType *rvrs)
+{
+  int i;
+  *frwd = gridpack::ComplexType(0.0,0.0);
+  *rvrs = gridpack::ComplexType(0.0,0.0);
+  for (i=0; i<p_elems; i++) {
+    if (!p_branch_status[i]) continue;
+    double r = (ignoreR ? 0.0 : p_resistance[i]);
+    if (r == 0.0 && p_reactance[i] == 0.0) continue;
+    gridpack::ComplexType ret(r,p_reactance[i]);
+    ret = -1.0/ret;
+    if (p_xform[i]) {
+      gridpack::ComplexType a(cos(p_phase_shift[i]),sin(p_phase_shift[i]));
+      a = p_tap_ratio[i]*a;
+      if (p_switched[i]) a = conj(a);
+      *frwd += ret/conj(a);
+      *rvrs += ret/a;
+    } else {
+      *frwd += ret;
+      *rvrs += ret;
+    }
+  }
+}
+
+/**
+ * Return the contribution of the series elements of the branch to the
+ * diagonal Y matrix element of the calling bus, optionally neglecting
+ * their resistance
+ * @param bus: pointer to the bus making the call
+ * @param ignoreR if true, the series impedance of each element is jx
+ * @return: contribution to Y matrix from series elements
+ */
+gridpack::ComplexType
+gridpack::ymatrix::YMBranch::getSeriesSelf(gridpack::ymatrix::YMBus *bus,
+    bool ignoreR)
+{
+  int i;
+  gridpack::ComplexType ret(0.0,0.0);
+  for (i=0; i<p_elems; i++) {
+    if (!p_branch_status[i]) continue;
+    double r = (ignoreR ? 0.0 : p_resistance[i]);
+    if (r == 0.0 && p_reactance[i] == 0.0) continue;
+    gridpack::ComplexType tmp(r,p_reactance[i]);
+    tmp = 1.0/tmp;
+    // off-nominal taps scale the admittance on the tap side, as in
+    // getTransformer
+    if (p_xform[i] && ((!p_switched[i] && bus == getBus1().get()) ||
+          (p_switched[i] && bus == getBus2().get()))) {
+      tmp = tmp/(p_tap_ratio[i]*p_tap_ratio[i]);
+    }
+    ret += tmp;
+  }
+  return ret;
+}
+
 /**
  * Return contributions to Y-matrix from a specific transmission element
  * @param tag character string for transmission element
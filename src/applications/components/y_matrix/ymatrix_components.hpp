@@ -227,6 +227,28 @@ class YMBranch
      */
     gridpack::ComplexType getShunt(YMBus *bus);
 
+    /**
+     * Return the off-diagonal Y matrix elements of the series elements of
+     * the branch, optionally neglecting their resistance. With
+     * ignoreR false, these are the same as getForwardYBus and
+     * getReverseYBus
+     * @param ignoreR if true, the series impedance of each element is jx
+     * @param frwd forward y-matrix element
+     * @param rvrs reverse y-matrix element
+     */
+    void getSeriesYBus(bool ignoreR, gridpack::ComplexType *frwd,
+        gridpack::ComplexType *rvrs);
+
+    /**
+     * Return the contribution of the series elements of the branch to the
+     * diagonal Y matrix element of the calling bus, optionally neglecting
+     * their resistance. Line charging and shunts are not included
+     * @param bus: pointer to the bus making the call
+     * @param ignoreR if true, the series impedance of each element is jx
+     * @return: contribution to Y matrix from series elements
+     */
+    gridpack::ComplexType getSeriesSelf(YMBus *bus, bool ignoreR);
+
     /**
      * Return contributions to Y-matrix from a specific transmission element
      * @param tag character string for transmission element
@@ -15,9 +15,13 @@
  */
 // -------------------------------------------------------------
 
+#include <algorithm>
+#include <set>
 #include "gridpack/include/gridpack.hpp"
 #include "gridpack/applications/modules/powerflow/pf_app_module.hpp"
+#include "gridpack/applications/modules/powerflow/dc_pf_module.hpp"
 #include "gridpack/applications/contingency_analysis/ca_driver.hpp"
+#include "gridpack/applications/contingency_analysis/ca_results.hpp"
 
 // Sets up multiple communicators so that individual contingency calculations
 // can be run concurrently
@@ -154,6 +158,156 @@ std::vector<gridpack::powerflow::Contingency>
   return ret;
 }
 
+// Order screened contingencies by decreasing severity. Contingencies that
+// could not be screened (negative severity) come first, then ties keep
+// their original order
+static bool severityOrder(const std::pair<double,int> &a,
+    const std::pair<double,int> &b)
+{
+  bool a_unscreened = (a.first < 0.0);
+  bool b_unscreened = (b.first < 0.0);
+  if (a_unscreened != b_unscreened) return a_unscreened;
+  if (!a_unscreened && a.first != b.first) return a.first > b.first;
+  return a.second < b.second;
+}
+
+/**
+ * Screen contingencies with DC power flow and rank them by the severity
+ * of the estimated branch overloads. Screening is divided between task
+ * communicators and the ranking is the same on all processors
+ * @param network network on task communicator, initialized for power flow
+ * @param pf_app power flow application on network
+ * @param events list of contingencies
+ * @param pf_cursor powerflow block of the input deck
+ * @param task_comm task communicator
+ * @param limit loading (fraction of rating A) above which a line is
+ * overloaded
+ * @param threshold contingencies with severity above this are selected
+ * @param maxSelected keep at most this many of the most severe
+ * contingencies (no limit if zero or less)
+ * @param selectedSeverity severity of each selected contingency (-1 if it
+ * could not be screened)
+ * @param verbose if true, print the ranking of every contingency
+ * @return indices of selected contingencies, most severe first
+ */
+std::vector<int>
+  gridpack::contingency_analysis::CADriver::screenContingencies(
+      boost::shared_ptr<gridpack::powerflow::PFNetwork> network,
+      gridpack::powerflow::PFAppModule &pf_app,
+      std::vector<gridpack::powerflow::Contingency> &events,
+      gridpack::utility::Configuration::CursorPtr pf_cursor,
+      gridpack::parallel::Communicator &task_comm,
+      double limit, double threshold, int maxSelected,
+      std::vector<double> &selectedSeverity, bool verbose)
+{
+  gridpack::parallel::Communicator world;
+  int nevents = events.size();
+  int idx, j;
+
+  // The B matrix is factored once and line outages are evaluated by
+  // compensation. Generator outages only change the injections. All task
+  // communicators must agree on whether the base case solved, since the
+  // task manager and the sums below are collective on world
+  gridpack::powerflow::DCPFModule dc(network, pf_cursor);
+  int iok = dc.solve() ? 1 : 0;
+  world.min(&iok, 1);
+  bool ok = (iok == 1);
+  std::vector<double> severity(nevents, 0.0);
+  std::vector<double> loading(nevents, 0.0);
+  std::vector<int> overloads(nevents, 0);
+  std::vector<gridpack::powerflow::pathBranch> none;
+  gridpack::parallel::TaskManager taskmgr(world);
+  taskmgr.set(ok ? nevents : 0);
+  int task_id;
+  while (taskmgr.nextTask(task_comm, &task_id)) {
+    gridpack::powerflow::Contingency &event = events[task_id];
+    double sev = -1.0;
+    double lmax = 0.0;
+    int nover = 0;
+    if (event.p_type == Branch) {
+      std::vector<gridpack::powerflow::pathBranch> lines(event.p_from.size());
+      for (j=0; j<lines.size(); j++) {
+        lines[j].fromBus = event.p_from[j];
+        lines[j].toBus = event.p_to[j];
+        lines[j].branchID = event.p_ckt[j];
+      }
+      if (dc.solveOutage(lines)) {
+        sev = dc.getOverloadSeverity(limit, lines, &nover, &lmax);
+      }
+    } else if (event.p_type == Generator) {
+      pf_app.setContingency(event);
+      if (dc.solve()) {
+        sev = dc.getOverloadSeverity(limit, none, &nover, &lmax);
+      }
+      pf_app.unSetContingency(event);
+      dc.solve();
+    }
+    if (task_comm.rank() == 0) {
+      severity[task_id] = sev;
+      loading[task_id] = lmax;
+      overloads[task_id] = nover;
+    }
+  }
+  if (!ok) {
+    // Nothing could be screened, so evaluate everything
+    for (idx=0; idx<nevents; idx++) severity[idx] = -1.0;
+  } else if (nevents > 0) {
+    world.sum(&severity[0], nevents);
+    world.sum(&loading[0], nevents);
+    world.sum(&overloads[0], nevents);
+  }
+
+  std::vector<std::pair<double,int> > ranked(nevents);
+  for (idx=0; idx<nevents; idx++) {
+    ranked[idx] = std::pair<double,int>(severity[idx],idx);
+  }
+  std::sort(ranked.begin(), ranked.end(), severityOrder);
+  std::vector<int> ret;
+  selectedSeverity.clear();
+  for (idx=0; idx<nevents; idx++) {
+    if (maxSelected > 0 && static_cast<int>(ret.size()) >= maxSelected) break;
+    if (ranked[idx].first < 0.0 || ranked[idx].first > threshold) {
+      ret.push_back(ranked[idx].second);
+      selectedSeverity.push_back(ranked[idx].first);
+    }
+  }
+
+  // Only print the full ranking if asked for
+  if (world.rank() == 0) {
+    printf("\nDC contingency screening (loading limit %f, threshold %f)\n",
+        limit, threshold);
+    int nunscreened = 0;
+    for (idx=0; idx<nevents; idx++) {
+      if (severity[idx] < 0.0) nunscreened++;
+    }
+    if (nunscreened > 0) {
+      printf("%d of %d contingencies could not be screened\n",
+          nunscreened, nevents);
+    }
+  }
+  if (world.rank() == 0 && verbose) {
+    printf("    Rank Name                 Severity Overloads Max Loading"
+        "   AC\n");
+    for (idx=0; idx<nevents; idx++) {
+      int k = ranked[idx].second;
+      bool selected = (std::find(ret.begin(), ret.end(), k) != ret.end());
+      if (ranked[idx].first < 0.0) {
+        printf("%8d %-16s    unscreened                     %4s\n",
+            idx+1, events[k].p_name.c_str(), selected ? "yes" : "no");
+      } else {
+        printf("%8d %-16s %12.6f %9d %11.6f %4s\n",idx+1,
+            events[k].p_name.c_str(), ranked[idx].first, overloads[k],
+            loading[k], selected ? "yes" : "no");
+      }
+    }
+  }
+  if (world.rank() == 0) {
+    printf("%d of %d contingencies selected for AC evaluation\n",
+        static_cast<int>(ret.size()), nevents);
+  }
+  return ret;
+}
+
 /**
  * Execute application
  */
@@ -191,6 +345,35 @@ void gridpack::contingency_analysis::CADriver::execute(int argc, char** argv)
   if (!cursor->get("maxVoltage",&Vmax)) {
     Vmax = 1.1;
   }
+  // Optional DC screening to select contingencies for AC evaluation
+  bool screen = false;
+  screen = cursor->get("screening", screen);
+  double screenLimit = cursor->get("screenLoadingLimit", 0.9);
+  double screenThreshold = cursor->get("screenThreshold", 0.0);
+  int screenMax = cursor->get("screenMaxContingencies", 0);
+  // Tables with a line for each contingency are only printed if asked for
+  bool verbose = false;
+  verbose = cursor->get("verbose", verbose);
+  // Task scheduling. By default contingencies are handed out one at a time
+  double chunkFactor = cursor->get("taskChunkFactor", 0.0);
+  int minChunk = cursor->get("taskMinChunk", 1);
+  int nqueues = cursor->get("taskQueues", 1);
+  // Summaries of all contingencies go to a single results file. Full text
+  // reports (<name>.out) are optional: for all contingencies, for those
+  // with violations or failures, or for contingencies that set fullReport
+  std::string resultsFile = cursor->get("resultsFile",
+      std::string("ca_results.bin"));
+  std::string resultsFormat = cursor->get("resultsFormat",
+      std::string("binary"));
+  std::string fullReports = cursor->get("fullReports", std::string("none"));
+  if (fullReports != "none" && fullReports != "violations" &&
+      fullReports != "all") {
+    if (world.rank() == 0) {
+      printf("Unknown value of fullReports: %s, using none\n",
+          fullReports.c_str());
+    }
+    fullReports = "none";
+  }
   gridpack::parallel::Communicator task_comm = world.divide(grp_size);
 
   // Create powerflow applications on each task communicator
@@ -199,7 +382,12 @@ void gridpack::contingency_analysis::CADriver::execute(int argc, char** argv)
   gridpack::powerflow::PFAppModule pf_app;
   pf_app.readNetwork(pf_network,config);
   pf_app.initialize();
+  // Keep the powerflow block, it is needed after the contingency list
+  // is read
+  gridpack::utility::Configuration::CursorPtr pf_cursor =
+    config->getCursor("Configuration.Powerflow");
   pf_app.solve();
+  pf_app.saveBaseCase();
   pf_app.ignoreVoltageViolations(Vmin,Vmax);
 
   // Read in contingency file
@@ -216,6 +404,17 @@ void gridpack::contingency_analysis::CADriver::execute(int argc, char** argv)
   if (cursor) cursor->children(contingencies);
   std::vector<gridpack::powerflow::Contingency>
     events = getContingencies(contingencies);
+  std::set<std::string> reportNames;
+  int idx;
+  for (idx = 0; idx < contingencies.size(); idx++) {
+    bool report = false;
+    report = contingencies[idx]->get("fullReport", report);
+    if (report) {
+      std::string name;
+      contingencies[idx]->get("contingencyName",&name);
+      reportNames.insert(name);
+    }
+  }
   if (world.rank() == 0) {
     int idx;
     for (idx = 0; idx < events.size(); idx++) {
@@ -239,38 +438,138 @@ void gridpack::contingency_analysis::CADriver::execute(int argc, char** argv)
     }
   }
 
-  // set up task manager
+  // select contingencies for full AC evaluation
+  std::vector<int> selected;
+  std::vector<double> severity;
+  if (screen) {
+    selected = screenContingencies(pf_network, pf_app, events, pf_cursor,
+        task_comm, screenLimit, screenThreshold, screenMax, severity,
+        verbose);
+  } else {
+    int idx;
+    for (idx = 0; idx < events.size(); idx++) selected.push_back(idx);
+  }
+
+  // set up task manager. If contingencies were screened, the DC severity
+  // is used as an estimate of the cost, so that contingencies that are
+  // likely to need many iterations start first. Contingencies that could
+  // not be screened are treated as the most expensive
   gridpack::parallel::TaskManager taskmgr(world);
-  int ntasks = events.size();
-  taskmgr.set(ntasks);
+  int ntasks = selected.size();
+  taskmgr.setChunking(chunkFactor, minChunk);
+  taskmgr.setQueues(nqueues);
+  if (screen) {
+    double maxSeverity = 0.0;
+    int idx;
+    for (idx = 0; idx < ntasks; idx++) {
+      if (severity[idx] > maxSeverity) maxSeverity = severity[idx];
+    }
+    std::vector<double> costs(ntasks);
+    for (idx = 0; idx < ntasks; idx++) {
+      costs[idx] = 1.0 + (severity[idx] < 0.0 ? maxSeverity : severity[idx]);
+    }
+    taskmgr.set(ntasks, costs);
+  } else {
+    taskmgr.set(ntasks);
+  }
 
-  // evaluate contingencies
+  // evaluate contingencies. A summary of each contingency is recorded on
+  // the root of its task communicator
   int task_id;
   char sbuf[128];
+  gridpack::contingency_analysis::CAResults results(ntasks);
   while (taskmgr.nextTask(task_comm, &task_id)) {
-    printf("Executing task %d on process %d\n",task_id,world.rank());
-    sprintf(sbuf,"%s.out",events[task_id].p_name.c_str());
-    pf_app.open(sbuf);
-    pf_app.resetVoltages();
-    pf_app.setContingency(events[task_id]);
-    if (pf_app.solve()) {
-      pf_app.write();
-      bool ok = pf_app.checkVoltageViolations(Vmin,Vmax);
-      ok = ok & pf_app.checkLineOverloadViolations();
-      if (ok) {
-        sprintf(sbuf,"\nNo violation for contingency %s\n",
-            events[task_id].p_name.c_str());
-      } else {
-        sprintf(sbuf,"\nViolation for contingency %s\n",
-            events[task_id].p_name.c_str());
+    gridpack::powerflow::Contingency &event = events[selected[task_id]];
+    pf_app.warmStart(event);
+    pf_app.setContingency(event);
+    bool converged = pf_app.solve();
+    int its, nfact;
+    pf_app.getSolveStatistics(&its, &nfact);
+    gridpack::powerflow::PFViolationSummary summary =
+      gridpack::powerflow::PFViolationSummary();
+    if (converged) summary = pf_app.getViolationSummary(Vmin,Vmax);
+    if (task_comm.rank() == 0) {
+      results.record(task_id, converged, its, nfact,
+          converged ? &summary : NULL);
+    }
+    bool violation = !converged ||
+      summary.nVoltage > 0 || summary.nOverload > 0;
+    bool report = (fullReports == "all" ||
+        (fullReports == "violations" && violation) ||
+        reportNames.count(event.p_name) > 0);
+    if (report) {
+      sprintf(sbuf,"%s.out",event.p_name.c_str());
+      pf_app.open(sbuf);
+      if (converged) {
+        pf_app.write();
+        if (!violation) {
+          sprintf(sbuf,"\nNo violation for contingency %s\n",
+              event.p_name.c_str());
+        } else {
+          sprintf(sbuf,"\nViolation for contingency %s\n",
+              event.p_name.c_str());
+        }
+        pf_app.print(sbuf);
       }
+      sprintf(sbuf,"\nIterations for contingency %s: %d"
+          " (factorizations %d)\n", event.p_name.c_str(), its, nfact);
       pf_app.print(sbuf);
+      pf_app.close();
     }
-    pf_app.unSetContingency(events[task_id]);
-    pf_app.close();
+    pf_app.unSetContingency(event);
   }
   taskmgr.printStats();
 
+  // collect summaries and write them from a single process
+  results.gather(world);
+  if (world.rank() == 0 && ntasks > 0) {
+    std::vector<std::string> names(ntasks);
+    for (idx = 0; idx < ntasks; idx++) {
+      names[idx] = events[selected[idx]].p_name;
+    }
+    results.write(resultsFile, names, resultsFormat != "csv");
+  }
+
+  // report totals. Results for each contingency are in the results file,
+  // and are only printed as well if asked for
+  if (world.rank() == 0 && ntasks > 0) {
+    if (verbose) {
+      printf("\n    Contingency          Iterations Factorizations"
+          " Violations    Min V  Max Loading\n");
+    }
+    int nconv = 0;
+    int nviol = 0;
+    double total = 0.0;
+    for (idx = 0; idx < ntasks; idx++) {
+      int its, nfact;
+      results.getStatistics(idx, &its, &nfact);
+      if (results.status(idx)
+          == gridpack::contingency_analysis::CAResults::CONVERGED) {
+        gridpack::powerflow::PFViolationSummary summary =
+          results.summary(idx);
+        if (verbose) {
+          printf("    %-20s %10d %14d %10d %8.4f %12.4f\n",
+              events[selected[idx]].p_name.c_str(), its, nfact,
+              summary.nVoltage+summary.nOverload, summary.minV,
+              summary.maxLoading);
+        }
+        if (summary.nVoltage+summary.nOverload > 0) nviol++;
+        total += static_cast<double>(its);
+        nconv++;
+      } else if (verbose) {
+        printf("    %-20s %10d %14d  (failed)\n",
+            events[selected[idx]].p_name.c_str(), its, nfact);
+      }
+    }
+    printf("\n%d of %d contingencies converged, %d with violations,"
+        " %d failed (results in %s)\n", nconv, ntasks, nviol,
+        ntasks-nconv, resultsFile.c_str());
+    if (nconv > 0) {
+      printf("Average iterations for %d converged contingencies: %f\n",
+          nconv, total/static_cast<double>(nconv));
+    }
+  }
+
   timer->stop(t_total);
   if (contingencies.size()*grp_size >= world.size()) {
     timer->dump();
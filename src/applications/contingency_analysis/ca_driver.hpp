@@ -20,6 +20,7 @@
 
 #include "gridpack/include/gridpack.hpp"
 #include "gridpack/applications/modules/powerflow/pf_app_module.hpp"
+#include "gridpack/applications/modules/powerflow/dc_pf_module.hpp"
 
 namespace gridpack {
 namespace contingency_analysis {
@@ -55,6 +56,35 @@ class CADriver
      */
     void execute(int argc, char** argv);
 
+    /**
+     * Screen contingencies with DC power flow and rank them by the severity
+     * of the estimated branch overloads. Screening is divided between task
+     * communicators and the ranking is the same on all processors
+     * @param network network on task communicator, initialized for power
+     * flow
+     * @param pf_app power flow application on network
+     * @param events list of contingencies
+     * @param pf_cursor powerflow block of the input deck
+     * @param task_comm task communicator
+     * @param limit loading (fraction of rating A) above which a line is
+     * overloaded
+     * @param threshold contingencies with severity above this are selected
+     * @param maxSelected keep at most this many of the most severe
+     * contingencies (no limit if zero or less)
+     * @param selectedSeverity severity of each selected contingency (-1 if
+     * it could not be screened)
+     * @param verbose if true, print the ranking of every contingency
+     * @return indices of selected contingencies, most severe first
+     */
+    std::vector<int> screenContingencies(
+        boost::shared_ptr<gridpack::powerflow::PFNetwork> network,
+        gridpack::powerflow::PFAppModule &pf_app,
+        std::vector<gridpack::powerflow::Contingency> &events,
+        gridpack::utility::Configuration::CursorPtr pf_cursor,
+        gridpack::parallel::Communicator &task_comm,
+        double limit, double threshold, int maxSelected,
+        std::vector<double> &selectedSeverity, bool verbose = false);
+
     private:
 };
 
@@ -405,8 +405,12 @@ void  gridpack::contingency_analysis::CAFactory::checkContingencies(
       }
     }
   }
-  *bus_ok_r = checkTrue(bus_ok);
-  *branch_ok_r = checkTrue(branch_ok);
+  gridpack::parallel::ReductionBatch batch(p_network->communicator());
+  int h_bus = queueCheckTrue(bus_ok,batch);
+  int h_branch = queueCheckTrue(branch_ok,batch);
+  batch.flush();
+  *bus_ok_r = batch.getBool(h_bus);
+  *branch_ok_r = batch.getBool(h_branch);
 }
 
 
@@ -0,0 +1,204 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   ca_results.cpp
+ *
+ * @brief  Compact summaries of contingency analysis results
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "gridpack/applications/contingency_analysis/ca_results.hpp"
+
+/**
+ * Basic constructor
+ * @param ntasks number of contingencies
+ */
+gridpack::contingency_analysis::CAResults::CAResults(int ntasks)
+  : p_ntasks(ntasks), p_ints(NINT*ntasks, 0), p_doubles(NDOUBLE*ntasks, 0.0)
+{
+}
+
+/**
+ * Basic destructor
+ */
+gridpack::contingency_analysis::CAResults::~CAResults(void)
+{
+}
+
+/**
+ * Record the result of a contingency. This should only be called on one
+ * processor for each contingency
+ * @param task index of contingency
+ * @param converged true if power flow converged
+ * @param iterations number of Newton iterations
+ * @param factorizations number of Jacobian factorizations
+ * @param summary violations in the solution (NULL if not available)
+ */
+void gridpack::contingency_analysis::CAResults::record(int task,
+    bool converged, int iterations, int factorizations,
+    const gridpack::powerflow::PFViolationSummary *summary)
+{
+  int *ival = &p_ints[NINT*task];
+  double *dval = &p_doubles[NDOUBLE*task];
+  ival[STATUS] = (converged ? CONVERGED : FAILED);
+  ival[ITERATIONS] = iterations;
+  ival[FACTORIZATIONS] = factorizations;
+  if (summary) {
+    ival[NVOLTAGE] = summary->nVoltage;
+    ival[NOVERLOAD] = summary->nOverload;
+    ival[MINV_BUS] = summary->minVBus;
+    ival[MAXV_BUS] = summary->maxVBus;
+    ival[LOADING_FROM] = summary->maxLoadingFrom;
+    ival[LOADING_TO] = summary->maxLoadingTo;
+    dval[MINV] = summary->minV;
+    dval[MAXV] = summary->maxV;
+    dval[LOADING] = summary->maxLoading;
+  } else {
+    ival[NVOLTAGE] = 0;
+    ival[NOVERLOAD] = 0;
+    ival[MINV_BUS] = -1;
+    ival[MAXV_BUS] = -1;
+    ival[LOADING_FROM] = -1;
+    ival[LOADING_TO] = -1;
+    dval[MINV] = 0.0;
+    dval[MAXV] = 0.0;
+    dval[LOADING] = 0.0;
+  }
+}
+
+/**
+ * Combine results from all processors. After this the results are
+ * complete on all processors in comm
+ * @param comm communicator containing all processors that recorded
+ *        results
+ */
+void gridpack::contingency_analysis::CAResults::gather(
+    const gridpack::parallel::Communicator &comm)
+{
+  // Each contingency was recorded on exactly one processor and is zero
+  // everywhere else, so a sum is enough
+  if (p_ntasks > 0) {
+    comm.sum(&p_ints[0], NINT*p_ntasks);
+    comm.sum(&p_doubles[0], NDOUBLE*p_ntasks);
+  }
+  int i;
+  for (i=0; i<p_ntasks; i++) {
+    if (p_ints[NINT*i+STATUS] == NOT_EVALUATED) {
+      p_ints[NINT*i+MINV_BUS] = -1;
+      p_ints[NINT*i+MAXV_BUS] = -1;
+      p_ints[NINT*i+LOADING_FROM] = -1;
+      p_ints[NINT*i+LOADING_TO] = -1;
+    }
+  }
+}
+
+/**
+ * Get status of a contingency
+ * @param task index of contingency
+ * @return status
+ */
+gridpack::contingency_analysis::CAResults::Status
+  gridpack::contingency_analysis::CAResults::status(int task) const
+{
+  return static_cast<Status>(p_ints[NINT*task+STATUS]);
+}
+
+/**
+ * Get solver statistics of a contingency
+ * @param task index of contingency
+ * @param iterations number of Newton iterations
+ * @param factorizations number of Jacobian factorizations
+ */
+void gridpack::contingency_analysis::CAResults::getStatistics(int task,
+    int *iterations, int *factorizations) const
+{
+  *iterations = p_ints[NINT*task+ITERATIONS];
+  *factorizations = p_ints[NINT*task+FACTORIZATIONS];
+}
+
+/**
+ * Get violation summary of a contingency
+ * @param task index of contingency
+ * @return summary of violations
+ */
+gridpack::powerflow::PFViolationSummary
+  gridpack::contingency_analysis::CAResults::summary(int task) const
+{
+  const int *ival = &p_ints[NINT*task];
+  const double *dval = &p_doubles[NDOUBLE*task];
+  gridpack::powerflow::PFViolationSummary ret;
+  ret.nVoltage = ival[NVOLTAGE];
+  ret.nOverload = ival[NOVERLOAD];
+  ret.minVBus = ival[MINV_BUS];
+  ret.maxVBus = ival[MAXV_BUS];
+  ret.maxLoadingFrom = ival[LOADING_FROM];
+  ret.maxLoadingTo = ival[LOADING_TO];
+  ret.minV = dval[MINV];
+  ret.maxV = dval[MAXV];
+  ret.maxLoading = dval[LOADING];
+  return ret;
+}
+
+/**
+ * Write results to a file. Only call this on one processor
+ * @param filename name of results file
+ * @param names name of each contingency
+ * @param binary true for binary format, otherwise CSV
+ * @return false if the file could not be written
+ */
+bool gridpack::contingency_analysis::CAResults::write(
+    const std::string &filename, const std::vector<std::string> &names,
+    bool binary) const
+{
+  FILE *fp = fopen(filename.c_str(), binary ? "wb" : "w");
+  if (!fp) {
+    printf("CAResults: cannot open output file %s\n",filename.c_str());
+    return false;
+  }
+  int i;
+  bool ok = true;
+  if (binary) {
+    int header[2];
+    header[0] = p_ntasks;
+    header[1] = 32;
+    ok = (fwrite(header, sizeof(int), 2, fp) == 2);
+    char name[32];
+    for (i=0; i<p_ntasks && ok; i++) {
+      memset(name, ' ', 32);
+      if (i < names.size()) {
+        memcpy(name, names[i].c_str(), std::min<size_t>(names[i].length(),32));
+      }
+      ok = (fwrite(name, 1, 32, fp) == 32);
+      ok = ok && (fwrite(&p_ints[NINT*i], sizeof(int), NINT, fp) == NINT);
+      ok = ok && (fwrite(&p_doubles[NDOUBLE*i], sizeof(double), NDOUBLE, fp)
+          == NDOUBLE);
+    }
+  } else {
+    fprintf(fp,"name,status,iterations,factorizations,voltageViolations,"
+        "lineOverloads,minVBus,maxVBus,loadingFrom,loadingTo,minV,maxV,"
+        "maxLoading\n");
+    for (i=0; i<p_ntasks; i++) {
+      const int *ival = &p_ints[NINT*i];
+      const double *dval = &p_doubles[NDOUBLE*i];
+      fprintf(fp,"%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.8f,%.8f,%.8f\n",
+          (i < names.size() ? names[i].c_str() : ""), ival[STATUS],
+          ival[ITERATIONS], ival[FACTORIZATIONS], ival[NVOLTAGE],
+          ival[NOVERLOAD], ival[MINV_BUS], ival[MAXV_BUS], ival[LOADING_FROM],
+          ival[LOADING_TO], dval[MINV], dval[MAXV], dval[LOADING]);
+    }
+  }
+  if (fclose(fp) != 0) ok = false;
+  if (!ok) {
+    printf("CAResults: error writing output file %s\n",filename.c_str());
+  }
+  return ok;
+}
@@ -0,0 +1,137 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   ca_results.hpp
+ *
+ * @brief  Compact summaries of contingency analysis results
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _ca_results_h_
+#define _ca_results_h_
+
+#include <string>
+#include <vector>
+#include "gridpack/parallel/communicator.hpp"
+#include "gridpack/applications/modules/powerflow/pf_factory_module.hpp"
+
+namespace gridpack {
+namespace contingency_analysis {
+
+// -------------------------------------------------------------
+//  class CAResults
+// -------------------------------------------------------------
+/**
+ * Collects a short summary of each contingency (convergence, iterations,
+ * violations, worst voltages and line loading) so that a whole sweep can be
+ * written to a single file at the end instead of one report per
+ * contingency. Summaries are recorded by the processor that evaluates the
+ * contingency (the root of its task communicator), gathered with one
+ * reduction and written by a single processor.
+ *
+ * In binary format the file starts with the number of contingencies and
+ * the length of the name field (32) as 32 bit integers. Each contingency
+ * then has a record containing
+ *   name (32 characters, blank padded)
+ *   status (0 not evaluated, 1 converged, 2 failed), iterations,
+ *   factorizations, number of voltage violations, number of line overloads,
+ *   bus with lowest voltage, bus with highest voltage, from and to buses
+ *   of the most heavily loaded branch (32 bit integers)
+ *   lowest voltage, highest voltage, largest loading (doubles)
+ * Bus numbers are -1 and values are zero for contingencies that did not
+ * converge. In CSV format the same fields are written as one line per
+ * contingency after a header line.
+ */
+class CAResults
+{
+  public:
+
+    /// Status of a contingency
+    enum Status {NOT_EVALUATED, CONVERGED, FAILED};
+
+    /**
+     * Basic constructor
+     * @param ntasks number of contingencies
+     */
+    CAResults(int ntasks);
+
+    /**
+     * Basic destructor
+     */
+    ~CAResults(void);
+
+    /**
+     * Record the result of a contingency. This should only be called on one
+     * processor for each contingency
+     * @param task index of contingency
+     * @param converged true if power flow converged
+     * @param iterations number of Newton iterations
+     * @param factorizations number of Jacobian factorizations
+     * @param summary violations in the solution (NULL if not available)
+     */
+    void record(int task, bool converged, int iterations, int factorizations,
+        const gridpack::powerflow::PFViolationSummary *summary = NULL);
+
+    /**
+     * Combine results from all processors. After this the results are
+     * complete on all processors in comm
+     * @param comm communicator containing all processors that recorded
+     *        results
+     */
+    void gather(const gridpack::parallel::Communicator &comm);
+
+    /**
+     * Get status of a contingency
+     * @param task index of contingency
+     * @return status
+     */
+    Status status(int task) const;
+
+    /**
+     * Get solver statistics of a contingency
+     * @param task index of contingency
+     * @param iterations number of Newton iterations
+     * @param factorizations number of Jacobian factorizations
+     */
+    void getStatistics(int task, int *iterations, int *factorizations) const;
+
+    /**
+     * Get violation summary of a contingency
+     * @param task index of contingency
+     * @return summary of violations
+     */
+    gridpack::powerflow::PFViolationSummary summary(int task) const;
+
+    /**
+     * Write results to a file. Only call this on one processor
+     * @param filename name of results file
+     * @param names name of each contingency
+     * @param binary true for binary format, otherwise CSV
+     * @return false if the file could not be written
+     */
+    bool write(const std::string &filename,
+        const std::vector<std::string> &names, bool binary) const;
+
+  private:
+
+    // Integer and double fields of each contingency
+    enum IntField {STATUS, ITERATIONS, FACTORIZATIONS, NVOLTAGE, NOVERLOAD,
+      MINV_BUS, MAXV_BUS, LOADING_FROM, LOADING_TO, NINT};
+    enum DoubleField {MINV, MAXV, LOADING, NDOUBLE};
+
+    int p_ntasks;
+
+    std::vector<int> p_ints;
+
+    std::vector<double> p_doubles;
+};
+
+} // contingency_analysis
+} // gridpack
+#endif
@@ -144,6 +144,42 @@ public:
   }
 };
 
+// Apply or remove a fault, as a DAESolver time event
+class DSFaultEvent
+{
+  gridpack::dsimplicit::DSFactory& p_factory;
+
+  gridpack::math::NonlinearSolver& p_nlsolver;
+
+  int p_bus;
+
+  double p_G, p_B;
+
+  bool p_on;
+
+public:
+  // Default constructor
+  DSFaultEvent(gridpack::dsimplicit::DSFactory& factory,
+               gridpack::math::NonlinearSolver& nlsolver,
+               const int& bus, const double& G, const double& B, const bool& on)
+  : p_factory(factory), p_nlsolver(nlsolver),
+    p_bus(bus), p_G(G), p_B(B), p_on(on)
+  {}
+
+  // Change the fault and solve the algebraic equations at the event
+  void operator() (const double& time, gridpack::math::Vector& X)
+  {
+    if (p_on) {
+      printf("Applying a fault on bus %d at t = %3.2f\n",p_bus,time);
+      p_factory.setfault(p_bus,-p_G,-p_B);
+    } else {
+      printf("Removing fault on bus %d at t = %3.2f\n",p_bus,time);
+      p_factory.setfault(p_bus,p_G,p_B);
+    }
+    p_nlsolver.solve(X);
+  }
+};
+
 // Calling program for implicit dynamic simulation
 
 /**
@@ -310,31 +346,15 @@ void gridpack::dsimplicit::DSApp::execute(int argc, char** argv)
   nlsolver.reset(new gridpack::math::NonlinearSolver(*(dsprob.J),jbuildf,fbuildf));
   nlsolver->configure(cursor);
 	      
-  // Pre-fault time-stepping
+  // Fault on and off are time events: the DAE solver stops at each,
+  // the algebraic equations are solved, and time stepping restarts
+  DSFaultEvent faulton(factory,*nlsolver,faultbus,Gfault,Bfault,true);
+  DSFaultEvent faultoff(factory,*nlsolver,faultbus,Gfault,Bfault,false);
   daesolver.configure(cursor);
+  daesolver.addTimeEvent(faultontime,boost::ref(faulton));
+  daesolver.addTimeEvent(faultofftime,boost::ref(faultoff));
+
   daesolver.initialize(0,0.01,*X);
-  daesolver.solve(faultontime,maxsteps);
-
-  // Set fault
-  printf("Applying a fault on bus %d at t = %3.2f\n",faultbus,faultontime);
-  factory.setfault(faultbus,-Gfault,-Bfault);
-  // Solve algebraic fault-on equations
-  nlsolver->solve(*X);
-
-  // Fault-on time-stepping
-  maxsteps = 10000;
-  daesolver.initialize(faultontime,0.01,*X);
-  daesolver.solve(faultofftime,maxsteps);
-
-  // Remove fault
-  printf("Removing fault on bus %d at t = %3.2f\n",faultbus,faultontime);
-  factory.setfault(faultbus,Gfault,Bfault);
-  // Solve algebraic fault-on equations
-  nlsolver->solve(*X);
-
-  // Post-fault time-stepping
-  maxsteps = 10000;
-  daesolver.initialize(faultofftime,0.01,*X);
   daesolver.solve(tmax,maxsteps);
 
   timer->stop(t_setup);
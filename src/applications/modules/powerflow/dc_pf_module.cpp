@@ -0,0 +1,482 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   dc_pf_module.cpp
+ *
+ * @brief  DC power flow and linear sensitivity factors (PTDF, LODF)
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "boost/smart_ptr/shared_ptr.hpp"
+#include "gridpack/include/gridpack.hpp"
+#include "dc_pf_module.hpp"
+
+namespace gridpack {
+namespace powerflow {
+
+/**
+ * Basic constructor
+ * @param network network that has already been partitioned and
+ *        initialized for power flow
+ * @param cursor configuration block (usually Configuration.Powerflow)
+ *        used to configure the linear solver
+ */
+DCPFModule::DCPFModule(boost::shared_ptr<PFNetwork> network,
+    gridpack::utility::Configuration::CursorPtr cursor)
+  : p_network(network), p_comm(network->communicator()),
+    p_factory(new PFFactoryModule(network)), p_cursor(cursor),
+    p_factored(false), p_rowLo(0)
+{
+}
+
+/**
+ * Basic destructor
+ */
+DCPFModule::~DCPFModule()
+{
+}
+
+/**
+ * Build and factor the B matrix. This is done automatically the first
+ * time it is needed, but must be called again if the network topology
+ * (e.g. branch status) or the reference bus changes
+ */
+void DCPFModule::factor(void)
+{
+  p_factory->setMode(DCMatrix);
+  gridpack::mapper::FullMatrixMap<PFNetwork> bMap(p_network);
+  p_B = bMap.mapToRealMatrix();
+
+  // The mapper does not expose which bus owns a row, so map the original
+  // bus indices using the same set of buses
+  p_factory->setMode(DCBusIndex);
+  gridpack::mapper::BusVectorMap<PFNetwork> iMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> idx = iMap.mapToRealVector();
+  if (idx->localSize() != p_B->localRows()) {
+    throw gridpack::Exception("DCPFModule: bus index vector and B matrix"
+        " have different layouts");
+  }
+  int hi;
+  idx->localIndexRange(p_rowLo, hi);
+  std::vector<double> ids(hi-p_rowLo);
+  if (hi > p_rowLo) idx->getElementRange(p_rowLo, hi, &ids[0]);
+  p_rowBus.resize(ids.size());
+  p_busRow.clear();
+  int i;
+  for (i=0; i<ids.size(); i++) {
+    p_rowBus[i] = static_cast<int>(ids[i] + 0.5);
+    p_busRow[p_rowBus[i]] = i;
+  }
+
+  // The base case solution belongs to the old B matrix
+  p_outageSolver.reset();
+  p_P.reset();
+  p_theta.reset();
+  p_solver.reset(new gridpack::math::RealLinearSolver(*p_B));
+  p_solver->configure(p_cursor);
+  p_factored = false;
+}
+
+/**
+ * Solve the DC power flow using the current generation and load and
+ * set the bus phase angles. Voltage magnitudes are not changed
+ * @return false if the linear solve failed
+ */
+bool DCPFModule::solve(void)
+{
+  if (!p_solver) factor();
+  p_factory->setSBus();
+  p_factory->setMode(DCInjection);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> P = vMap.mapToRealVector();
+  boost::shared_ptr<gridpack::math::RealVector> theta(P->clone());
+  theta->zero();
+  try {
+    if (!p_factored) {
+      p_solver->solve(*P, *theta);
+      p_factored = true;
+    } else {
+      p_solver->resolve(*P, *theta);
+    }
+  } catch (const gridpack::Exception e) {
+    return false;
+  }
+  p_P = P;
+  p_theta = theta;
+  vMap.mapToBus(theta);
+  p_network->updateBuses();
+  return true;
+}
+
+/**
+ * Get DC power flows, from bus 1 to bus 2, on a set of branches using
+ * the current bus phase angles. The result is the same on all processors
+ * @param branches list of branches
+ * @return flow on each branch (zero if the branch is out of service)
+ */
+std::vector<double> DCPFModule::getFlows(
+    const std::vector<pathBranch> &branches)
+{
+  return branchValues(branches, true);
+}
+
+/**
+ * Compute power transfer distribution factors. Column l of the result
+ * contains, for each bus row, the change in flow on monitored branch l
+ * for a unit injection at that bus withdrawn at the reference bus
+ * @param monitored list of monitored branches
+ * @return distributed dense matrix with one row per B matrix row
+ */
+boost::shared_ptr<gridpack::math::RealMatrix>
+DCPFModule::getPTDF(const std::vector<pathBranch> &monitored)
+{
+  if (!p_solver) factor();
+  // B is symmetric, so column l of B^-1 E, with E scaled by the branch
+  // susceptance, is row l of the usual PTDF matrix
+  std::vector<double> b = branchValues(monitored, false);
+  boost::shared_ptr<gridpack::math::RealMatrix> E(incidence(monitored, b));
+  return boost::shared_ptr<gridpack::math::RealMatrix>(solveColumns(*E));
+}
+
+/**
+ * Compute line outage distribution factors. Element (l,k) of the
+ * result is the fraction of the pre-outage flow on outaged branch k
+ * that shows up on monitored branch l after k is removed. Element
+ * (l,k) is -1 if l and k are the same branch. Columns of outages that
+ * would island part of the network are zero
+ * @param monitored list of monitored branches
+ * @param outages list of outaged branches
+ * @return distributed dense matrix, monitored x outages
+ */
+boost::shared_ptr<gridpack::math::RealMatrix>
+DCPFModule::getLODF(const std::vector<pathBranch> &monitored,
+    const std::vector<pathBranch> &outages)
+{
+  if (!p_solver) factor();
+  int nmon = monitored.size();
+  int nout = outages.size();
+  int i, k, l;
+
+  // Angle changes for a unit transfer across each outaged branch. One solve
+  // with all outages as right hand sides
+  std::vector<double> ones(nout, 1.0);
+  boost::shared_ptr<gridpack::math::RealMatrix> E(incidence(outages, ones));
+  boost::shared_ptr<gridpack::math::RealMatrix> X(solveColumns(*E));
+
+  std::vector<double> bmon = branchValues(monitored, false);
+  std::vector<double> bout = branchValues(outages, false);
+
+  // Flow change on each outaged branch for its own unit transfer, d(k).
+  // Only the rows of its end buses contribute
+  std::vector<double> d(nout, 0.0);
+  std::map<int, int>::iterator it;
+  for (k=0; k<nout; k++) {
+    if (bout[k] == 0.0) continue;
+    for (i=0; i<2; i++) {
+      it = p_busRow.find(i == 0 ? outages[k].fromBus : outages[k].toBus);
+      if (it == p_busRow.end()) continue;
+      double x;
+      X->getElement(p_rowLo + it->second, k, x);
+      d[k] += (i == 0 ? bout[k] : -bout[k])*x;
+    }
+  }
+  if (nout > 0) p_comm.sum(&d[0], nout);
+
+  // Flow changes on the monitored branches, M = diag(b) E_mon^T X. Rows of
+  // E_mon^T are split evenly between processors and each processor adds
+  // the entries for the buses it owns, so M is distributed the same way
+  int lo, hi;
+  localColumnRange(nmon, lo, hi);
+  gridpack::math::RealMatrix Et(p_comm, hi-lo, p_rowBus.size(), 2);
+  for (l=0; l<nmon; l++) {
+    if (bmon[l] == 0.0) continue;
+    for (i=0; i<2; i++) {
+      it = p_busRow.find(i == 0 ? monitored[l].fromBus : monitored[l].toBus);
+      if (it == p_busRow.end()) continue;
+      Et.addElement(l, p_rowLo + it->second, (i == 0 ? bmon[l] : -bmon[l]));
+    }
+  }
+  Et.ready();
+  boost::shared_ptr<gridpack::math::RealMatrix>
+    ret(gridpack::math::multiply(Et, *X));
+
+  // Scale each column by 1/(1-d(k)). If d(k) is 1 the outage islands part
+  // of the network and the column is left at zero
+  std::vector<double> scale(nout, 0.0);
+  for (k=0; k<nout; k++) {
+    double denom = 1.0 - d[k];
+    if (std::abs(denom) > 1.0e-8 && bout[k] != 0.0) scale[k] = 1.0/denom;
+  }
+  ret->localRowRange(lo, hi);
+  std::vector<int> rows(nout), cols(nout);
+  std::vector<double> mrow(nout);
+  for (k=0; k<nout; k++) cols[k] = k;
+  for (l=lo; l<hi && nout > 0; l++) {
+    for (k=0; k<nout; k++) rows[k] = l;
+    ret->getElements(nout, &rows[0], &cols[0], &mrow[0]);
+    for (k=0; k<nout; k++) {
+      mrow[k] *= scale[k];
+      if (monitored[l].fromBus == outages[k].fromBus &&
+          monitored[l].toBus == outages[k].toBus &&
+          monitored[l].branchID == outages[k].branchID) {
+        mrow[k] = -1.0;
+      }
+    }
+    ret->setElements(nout, &rows[0], &cols[0], &mrow[0]);
+  }
+  ret->ready();
+  return ret;
+}
+
+/**
+ * Set the bus phase angles to the DC solution with a set of branches out
+ * of service, without refactoring the B matrix. Each outaged branch is a
+ * rank one update of B, which is handled by a low rank update solver
+ * sharing the factorization of B. The outaged branches should still be in
+ * service when this is called
+ * @param outages list of outaged branches
+ * @param increment if true, add the change in DC angles caused by the
+ *        outages to the current bus angles (e.g. an AC solution) instead
+ *        of setting the angles to the DC solution
+ * @return false if the outages island part of the network (or the linear
+ *         solve failed)
+ */
+bool DCPFModule::solveOutage(const std::vector<pathBranch> &outages,
+    bool increment)
+{
+  // The low rank update solver needs a factored B and the base case
+  // solution
+  if ((!p_theta || !p_factored) && !solve()) return false;
+  int nout = outages.size();
+  int i, k;
+  if (nout == 0 && increment) return true;
+
+  boost::shared_ptr<gridpack::math::RealVector> theta(p_theta->clone());
+  if (nout > 0) {
+    // Global rows of the end buses of each outaged branch, plus one, so
+    // that every processor can specify the same updates. Zero means the
+    // bus has no row (e.g. the reference bus)
+    std::vector<double> b = branchValues(outages, false);
+    std::vector<int> rows(2*nout, 0);
+    std::map<int, int>::iterator it;
+    for (k=0; k<nout; k++) {
+      for (i=0; i<2; i++) {
+        it = p_busRow.find(i == 0 ? outages[k].fromBus : outages[k].toBus);
+        if (it != p_busRow.end()) rows[2*k+i] = p_rowLo + it->second + 1;
+      }
+    }
+    p_comm.sum(&rows[0], rows.size());
+
+    // Removing branch k changes B by -b(k) w w^T, where w is +1 in the row
+    // of the from bus and -1 in the row of the to bus
+    if (!p_outageSolver) {
+      p_outageSolver.reset(
+          new gridpack::math::RealLowRankUpdateSolver(*p_B, *p_solver));
+      p_outageSolver->configure(p_cursor);
+    }
+    p_outageSolver->clearUpdates();
+    for (k=0; k<nout; k++) {
+      if (b[k] == 0.0) continue;
+      std::vector<int> idx;
+      std::vector<double> u, w;
+      for (i=0; i<2; i++) {
+        if (rows[2*k+i] == 0) continue;
+        double sign = (i == 0 ? 1.0 : -1.0);
+        idx.push_back(rows[2*k+i]-1);
+        u.push_back(-b[k]*sign);
+        w.push_back(sign);
+      }
+      if (!idx.empty()) p_outageSolver->addUpdate(idx, u, idx, w);
+    }
+    try {
+      p_outageSolver->solve(*p_P, *theta);
+    } catch (const gridpack::Exception e) {
+      return false;
+    }
+  }
+
+  p_factory->setMode(DCAngle);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  if (increment) {
+    boost::shared_ptr<gridpack::math::RealVector>
+      angle(vMap.mapToRealVector());
+    theta->add(*p_theta, -1.0);
+    theta->add(*angle);
+  }
+  vMap.mapToBus(theta);
+  p_network->updateBuses();
+  return true;
+}
+
+/**
+ * Evaluate branch overloads from the current bus phase angles. The loading
+ * of a line element is its DC flow divided by rating A. Elements without a
+ * rating, elements flagged to be ignored, and elements in the outage list
+ * are skipped. The result is the same on all processors
+ * @param limit loading above which an element counts as overloaded
+ * @param outages branches to treat as out of service
+ * @param count number of overloaded elements
+ * @param maxLoading largest loading found
+ * @return severity, the sum of loading - limit over overloaded elements
+ */
+double DCPFModule::getOverloadSeverity(double limit,
+    const std::vector<pathBranch> &outages, int *count, double *maxLoading)
+{
+  int numBranch = p_network->numBranches();
+  int nout = outages.size();
+  int i, j, k;
+  double severity = 0.0;
+  double lmax = 0.0;
+  int nover = 0;
+  for (i=0; i<numBranch; i++) {
+    if (!p_network->getActiveBranch(i)) continue;
+    PFBranch *branch = dynamic_cast<PFBranch*>(p_network->getBranch(i).get());
+    int from = branch->getBus1OriginalIndex();
+    int to = branch->getBus2OriginalIndex();
+    std::vector<std::string> tags = branch->getLineTags();
+    for (j=0; j<tags.size(); j++) {
+      if (branch->getIgnore(tags[j])) continue;
+      bool out = false;
+      for (k=0; k<nout && !out; k++) {
+        out = (tags[j] == outages[k].branchID &&
+            ((from == outages[k].fromBus && to == outages[k].toBus) ||
+             (from == outages[k].toBus && to == outages[k].fromBus)));
+      }
+      if (out) continue;
+      double loading = branch->getDCLoading(tags[j]);
+      if (loading > lmax) lmax = loading;
+      if (loading > limit) {
+        severity += loading - limit;
+        nover++;
+      }
+    }
+  }
+  p_comm.sum(&severity, 1);
+  p_comm.sum(&nover, 1);
+  p_comm.max(&lmax, 1);
+  if (count) *count = nover;
+  if (maxLoading) *maxLoading = lmax;
+  return severity;
+}
+
+/**
+ * Get original bus indices of the locally owned rows of the B matrix
+ * (and of the PTDF matrix)
+ * @param lo global index of first local row
+ * @param indices original bus index of each local row
+ */
+void DCPFModule::getBusIndices(int &lo, std::vector<int> &indices)
+{
+  if (!p_B) factor();
+  lo = p_rowLo;
+  indices = p_rowBus;
+}
+
+/**
+ * Sum a branch quantity over the active branch elements on all
+ * processors
+ * @param branches list of branches
+ * @param flow if true return DC flows, otherwise return susceptances
+ * @return value for each branch
+ */
+std::vector<double> DCPFModule::branchValues(
+    const std::vector<pathBranch> &branches, bool flow)
+{
+  int nbranch = branches.size();
+  std::vector<double> ret(nbranch, 0.0);
+  int i, j;
+  for (i=0; i<nbranch; i++) {
+    std::vector<int> lids = p_network->getLocalBranchIndices(
+        branches[i].fromBus, branches[i].toBus);
+    for (j=0; j<lids.size(); j++) {
+      if (!p_network->getActiveBranch(lids[j])) continue;
+      PFBranch *branch = dynamic_cast<PFBranch*>(
+          p_network->getBranch(lids[j]).get());
+      if (flow) {
+        ret[i] += branch->getDCFlow(branches[i].branchID);
+      } else {
+        ret[i] += branch->getDCSusceptance(branches[i].branchID);
+      }
+    }
+  }
+  if (nbranch > 0) p_comm.sum(&ret[0], nbranch);
+  return ret;
+}
+
+/**
+ * Build the bus-branch incidence matrix for a set of branches. Column k
+ * has scale[k] in the row of the from bus and -scale[k] in the row of
+ * the to bus (nothing for the reference bus)
+ * @param branches list of branches
+ * @param scale column scaling
+ * @return distributed dense matrix with one row per B matrix row
+ */
+gridpack::math::RealMatrix* DCPFModule::incidence(
+    const std::vector<pathBranch> &branches,
+    const std::vector<double> &scale)
+{
+  int nbranch = branches.size();
+  int lo, hi;
+  localColumnRange(nbranch, lo, hi);
+  gridpack::math::RealMatrix *ret =
+    gridpack::math::RealMatrix::createDense(p_comm, p_B->rows(), nbranch,
+        p_rowBus.size(), hi-lo);
+  std::map<int, int>::iterator it;
+  int k;
+  for (k=0; k<nbranch; k++) {
+    it = p_busRow.find(branches[k].fromBus);
+    if (it != p_busRow.end()) {
+      ret->addElement(p_rowLo + it->second, k, scale[k]);
+    }
+    it = p_busRow.find(branches[k].toBus);
+    if (it != p_busRow.end()) {
+      ret->addElement(p_rowLo + it->second, k, -scale[k]);
+    }
+  }
+  ret->ready();
+  return ret;
+}
+
+/**
+ * Solve with the B matrix for each column of a distributed dense matrix,
+ * in one multiple right hand side solve
+ * @param E right hand sides, as returned by incidence()
+ * @return solution, with the same size and layout as E
+ */
+gridpack::math::RealMatrix* DCPFModule::solveColumns(
+    const gridpack::math::RealMatrix &E)
+{
+  gridpack::math::RealMatrix *ret =
+    gridpack::math::RealMatrix::createDense(p_comm, E.rows(), E.cols(),
+        E.localRows(), E.localCols());
+  p_solver->solve(E, *ret);
+  p_factored = true;
+  return ret;
+}
+
+/**
+ * Range of columns of a distributed dense matrix (or elements of a vector
+ * that multiplies it) owned by this processor
+ * @param ncols global number of columns
+ * @param lo index of first local column
+ * @param hi one past the index of the last local column
+ */
+void DCPFModule::localColumnRange(int ncols, int &lo, int &hi)
+{
+  int nprocs = p_comm.size();
+  int me = p_comm.rank();
+  lo = me*(ncols/nprocs) + std::min(me, ncols%nprocs);
+  hi = lo + ncols/nprocs + (me < ncols%nprocs ? 1 : 0);
+}
+
+} // powerflow
+} // gridpack
@@ -0,0 +1,230 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   dc_pf_module.hpp
+ *
+ * @brief  DC power flow and linear sensitivity factors (PTDF, LODF)
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _dc_pf_module_h_
+#define _dc_pf_module_h_
+
+#include <vector>
+#include <map>
+#include "boost/smart_ptr/shared_ptr.hpp"
+#include "gridpack/include/gridpack.hpp"
+#include "gridpack/math/low_rank_update_solver.hpp"
+#include "pf_factory_module.hpp"
+#include "pf_app_module.hpp"
+
+namespace gridpack {
+namespace powerflow {
+
+// -------------------------------------------------------------
+//  class DCPFModule
+// -------------------------------------------------------------
+/**
+ * Linearized (DC) power flow on a network that has already been set up
+ * by PFAppModule (or something equivalent). The B matrix is built from
+ * the branch reactances and tap ratios, ignoring resistance, shunts,
+ * phase shifters and losses, and is factored once. The DC power flow
+ * itself and the power transfer (PTDF) and line outage (LODF)
+ * distribution factors all reuse the same factorization; the factors
+ * for a whole set of branches are computed with a single multiple
+ * right hand side solve.
+ *
+ * Rows of the B matrix correspond to all buses that are not isolated
+ * and not the reference bus, so phase angles are relative to the
+ * reference bus and the reference bus absorbs any imbalance. All
+ * quantities are in per unit.
+ */
+class DCPFModule
+{
+  public:
+    /**
+     * Basic constructor
+     * @param network network that has already been partitioned and
+     *        initialized for power flow
+     * @param cursor configuration block (usually Configuration.Powerflow)
+     *        used to configure the linear solver
+     */
+    DCPFModule(boost::shared_ptr<PFNetwork> network,
+        gridpack::utility::Configuration::CursorPtr cursor);
+
+    /**
+     * Basic destructor
+     */
+    ~DCPFModule();
+
+    /**
+     * Build and factor the B matrix. This is done automatically the first
+     * time it is needed, but must be called again if the network topology
+     * (e.g. branch status) or the reference bus changes
+     */
+    void factor(void);
+
+    /**
+     * Solve the DC power flow using the current generation and load and
+     * set the bus phase angles. Voltage magnitudes are not changed
+     * @return false if the linear solve failed
+     */
+    bool solve(void);
+
+    /**
+     * Get DC power flows, from bus 1 to bus 2, on a set of branches using
+     * the current bus phase angles. The result is the same on all processors
+     * @param branches list of branches
+     * @return flow on each branch (zero if the branch is out of service)
+     */
+    std::vector<double> getFlows(const std::vector<pathBranch> &branches);
+
+    /**
+     * Compute power transfer distribution factors. Column l of the result
+     * contains, for each bus row, the change in flow on monitored branch l
+     * for a unit injection at that bus withdrawn at the reference bus
+     * @param monitored list of monitored branches
+     * @return distributed dense matrix with one row per B matrix row
+     */
+    boost::shared_ptr<gridpack::math::RealMatrix>
+      getPTDF(const std::vector<pathBranch> &monitored);
+
+    /**
+     * Compute line outage distribution factors. Element (l,k) of the
+     * result is the fraction of the pre-outage flow on outaged branch k
+     * that shows up on monitored branch l after k is removed. Element
+     * (l,k) is -1 if l and k are the same branch. Columns of outages that
+     * would island part of the network are zero
+     * @param monitored list of monitored branches
+     * @param outages list of outaged branches
+     * @return distributed dense matrix, monitored x outages
+     */
+    boost::shared_ptr<gridpack::math::RealMatrix>
+      getLODF(const std::vector<pathBranch> &monitored,
+          const std::vector<pathBranch> &outages);
+
+    /**
+     * Set the bus phase angles to the DC solution with a set of branches
+     * out of service, without refactoring the B matrix. Each outaged
+     * branch is a rank one update of B, which is handled by a low rank
+     * update solver sharing the factorization of B. The outaged branches
+     * should still be in service when this is called
+     * @param outages list of outaged branches
+     * @param increment if true, add the change in DC angles caused by the
+     *        outages to the current bus angles (e.g. an AC solution) instead
+     *        of setting the angles to the DC solution
+     * @return false if the outages island part of the network (or the
+     *         linear solve failed)
+     */
+    bool solveOutage(const std::vector<pathBranch> &outages,
+        bool increment = false);
+
+    /**
+     * Evaluate branch overloads from the current bus phase angles. The
+     * loading of a line element is its DC flow divided by rating A.
+     * Elements without a rating, elements flagged to be ignored, and
+     * elements in the outage list are skipped. The result is the same on
+     * all processors
+     * @param limit loading above which an element counts as overloaded
+     * @param outages branches to treat as out of service
+     * @param count number of overloaded elements
+     * @param maxLoading largest loading found
+     * @return severity, the sum of loading - limit over overloaded elements
+     */
+    double getOverloadSeverity(double limit,
+        const std::vector<pathBranch> &outages, int *count,
+        double *maxLoading);
+
+    /**
+     * Get original bus indices of the locally owned rows of the B matrix
+     * (and of the PTDF matrix)
+     * @param lo global index of first local row
+     * @param indices original bus index of each local row
+     */
+    void getBusIndices(int &lo, std::vector<int> &indices);
+
+  private:
+
+    /**
+     * Sum a branch quantity over the active branch elements on all
+     * processors
+     * @param branches list of branches
+     * @param flow if true return DC flows, otherwise return susceptances
+     * @return value for each branch
+     */
+    std::vector<double> branchValues(const std::vector<pathBranch> &branches,
+        bool flow);
+
+    /**
+     * Build the bus-branch incidence matrix for a set of branches. Column k
+     * has scale[k] in the row of the from bus and -scale[k] in the row of
+     * the to bus (nothing for the reference bus)
+     * @param branches list of branches
+     * @param scale column scaling
+     * @return distributed dense matrix with one row per B matrix row
+     */
+    gridpack::math::RealMatrix* incidence(
+        const std::vector<pathBranch> &branches,
+        const std::vector<double> &scale);
+
+    /**
+     * Solve with the B matrix for each column of a distributed dense
+     * matrix, in one multiple right hand side solve
+     * @param E right hand sides, as returned by incidence()
+     * @return solution, with the same size and layout as E
+     */
+    gridpack::math::RealMatrix* solveColumns(
+        const gridpack::math::RealMatrix &E);
+
+    /**
+     * Range of columns of a distributed dense matrix (or elements of a
+     * vector that multiplies it) owned by this processor
+     * @param ncols global number of columns
+     * @param lo index of first local column
+     * @param hi one past the index of the last local column
+     */
+    void localColumnRange(int ncols, int &lo, int &hi);
+
+    boost::shared_ptr<PFNetwork> p_network;
+
+    gridpack::parallel::Communicator p_comm;
+
+    boost::shared_ptr<PFFactoryModule> p_factory;
+
+    gridpack::utility::Configuration::CursorPtr p_cursor;
+
+    // B matrix and its factorization
+    boost::shared_ptr<gridpack::math::RealMatrix> p_B;
+
+    boost::shared_ptr<gridpack::math::RealLinearSolver> p_solver;
+
+    bool p_factored;
+
+    // Solver for B with branch outages, sharing the factorization in
+    // p_solver
+    boost::shared_ptr<gridpack::math::RealLowRankUpdateSolver> p_outageSolver;
+
+    // Injections and phase angles from the last call to solve()
+    boost::shared_ptr<gridpack::math::RealVector> p_P;
+
+    boost::shared_ptr<gridpack::math::RealVector> p_theta;
+
+    // Global index of first local row and original bus index of each
+    // local row
+    int p_rowLo;
+
+    std::vector<int> p_rowBus;
+
+    // Map from original bus index to local row
+    std::map<int, int> p_busRow;
+};
+
+} // powerflow
+} // gridpack
+#endif
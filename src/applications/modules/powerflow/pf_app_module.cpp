@@ -15,9 +15,13 @@
  */
 // -------------------------------------------------------------
 
+#include <algorithm>
+#include <cstdio>
 #include "gridpack/include/gridpack.hpp"
 #include "pf_app_module.hpp"
 #include "pf_factory_module.hpp"
+#include "dc_pf_module.hpp"
+#include "pf_profile.hpp"
 #include "pf_helper.hpp"
 
 #define USE_REAL_VALUES
@@ -27,6 +31,18 @@
  */
 gridpack::powerflow::PFAppModule::PFAppModule(void)
 {
+  p_refactorInterval = 1;
+  p_contractionLimit = 0.5;
+  p_iterations = 0;
+  p_factorizations = 0;
+  p_fastDecoupled = false;
+  p_fdXB = true;
+  p_fdMaxIteration = 20;
+  p_fdStale = true;
+  p_bpFactored = false;
+  p_bppFactored = false;
+  p_warmStart = "none";
+  p_enforceQlim = false;
 }
 
 /**
@@ -83,6 +99,26 @@ void gridpack::powerflow::PFAppModule::readNetwork(
   // Convergence and iteration parameters
   p_tolerance = cursor->get("tolerance",1.0e-6);
   p_max_iteration = cursor->get("maxIteration",50);
+  // Jacobian reuse policy. Refactor the Jacobian at least every
+  // refactorInterval iterations, or whenever the mismatch norm decreases by
+  // less than contractionLimit
+  p_refactorInterval = cursor->get("refactorInterval",1);
+  if (p_refactorInterval < 1) p_refactorInterval = 1;
+  p_contractionLimit = cursor->get("contractionLimit",0.5);
+  // Fast decoupled iterations (XB or BX scheme) before Newton-Raphson.
+  // Newton-Raphson takes over if these do not converge within
+  // fdMaxIteration iterations or the mismatch grows
+  std::string fdScheme = cursor->get("fastDecoupled","none");
+  p_fastDecoupled = (fdScheme == "XB" || fdScheme == "BX");
+  p_fdXB = (fdScheme != "BX");
+  p_fdMaxIteration = cursor->get("fdMaxIteration",20);
+  // Enforce generator reactive power limits during Newton-Raphson
+  // iterations. This uses a fixed Jacobian layout with two rows for every
+  // bus so PV buses can switch to PQ without rebuilding the mappers
+  p_enforceQlim = cursor->get("enforceQlim",false);
+  // Starting point for contingency solves
+  p_warmStart = cursor->get("warmStart","none");
+  if (p_warmStart != "base" && p_warmStart != "dc") p_warmStart = "none";
   ComplexType tol;
   // Phase shift sign
   double phaseShiftSign = cursor->get("phaseShiftSign",1.0);
@@ -149,6 +185,7 @@ void gridpack::powerflow::PFAppModule::initialize()
   int t_setc = timer->createCategory("Powerflow: Factory Set Components");
   timer->start(t_setc);
   p_factory->setComponents();
+  if (p_enforceQlim) p_factory->setFixedLayout(true);
   timer->stop(t_setc);
 
   // Set up bus data exchange buffers. Need to decide what data needs to be
@@ -177,6 +214,21 @@ void gridpack::powerflow::PFAppModule::reload()
   timer->start(t_load);
   p_factory->load();
   timer->stop(t_load);
+  int t_setc = timer->createCategory("Powerflow: Factory Set Components");
+  timer->start(t_setc);
+  p_factory->setComponents();
+  timer->stop(t_setc);
+  p_fdStale = true;
+}
+
+/**
+ * Discard the cached index maps so that they are recomputed on the next
+ * call to reload(), along with the fast decoupled matrices
+ */
+void gridpack::powerflow::PFAppModule::resetTopology()
+{
+  p_factory->resetTopology();
+  p_fdStale = true;
 }
 
 /**
@@ -223,12 +275,33 @@ bool gridpack::powerflow::PFAppModule::solve()
   timer->stop(t_cmap);
   int t_vmap = timer->createCategory("Powerflow: Map to Vector");
 
-  // make Sbus components to create S vector
+  // make Sbus components to create S vector. Buses switched to PQ by the
+  // last solve start out as PV buses again
   timer->start(t_fact);
+  if (p_enforceQlim) p_factory->clearQlim();
   p_factory->setSBus();
   timer->stop(t_fact);
 //  p_busIO->header("\nIteration 0\n");
 
+  p_iterations = 0;
+  p_factorizations = 0;
+  if (p_fastDecoupled) {
+    int t_fd = timer->createCategory("Powerflow: Fast Decoupled Iterations");
+    timer->start(t_fd);
+    bool fdok = fdSolve();
+    timer->stop(t_fd);
+    // Reactive power limits are checked in the Newton-Raphson iterations,
+    // which start out converged in this case
+    if (fdok && !p_enforceQlim) {
+      timer->stop(t_total);
+      return true;
+    }
+    if (!fdok) {
+      p_busIO->header("\nFast decoupled iterations did not converge,"
+          " switching to Newton-Raphson\n");
+    }
+  }
+
   // Set PQ
   timer->start(t_cmap);
   p_factory->setMode(RHS); 
@@ -268,10 +341,16 @@ bool gridpack::powerflow::PFAppModule::solve()
   // Create linear solver
   int t_csolv = timer->createCategory("Powerflow: Create Linear Solver");
   timer->start(t_csolv);
+  // The Jacobian pattern is usually the same from one call to the next
+  // (e.g. contingencies), so share the ordering and symbolic factorization
+  if (!p_analysis) {
+    p_analysis.reset(new gridpack::math::LinearSolverAnalysis(
+          p_network->communicator()));
+  }
 #ifdef USE_REAL_VALUES
-  gridpack::math::RealLinearSolver solver(*J);
+  gridpack::math::RealLinearSolver solver(*J, p_analysis);
 #else
-  gridpack::math::LinearSolver solver(*J);
+  gridpack::math::LinearSolver solver(*J, p_analysis);
 #endif
   solver.configure(cursor);
   timer->stop(t_csolv);
@@ -297,14 +376,28 @@ bool gridpack::powerflow::PFAppModule::solve()
     return false;
   }
   timer->stop(t_lsolv);
+  p_factorizations++;
   tol = PQ->normInfinity();
+  int lastFactor = 0;
+  bool refactor = false;
 
   // Create timer for map to bus
   int t_bmap = timer->createCategory("Powerflow: Map to Bus");
   int t_updt = timer->createCategory("Powerflow: Bus Update");
   char ioBuf[128];
 
-  while (real(tol) > p_tolerance && iter < p_max_iteration) {
+  while (iter < p_max_iteration) {
+    if (real(tol) <= p_tolerance) {
+      // Once converged, switch PV buses that violate their reactive power
+      // limits to PQ. The Jacobian layout does not change, so iterations
+      // continue with the same mappers and solver
+      if (!p_enforceQlim) break;
+      int nswitch = p_factory->enforceQlim();
+      if (nswitch == 0) break;
+      sprintf(ioBuf,"\nSwitched %d PV buses to PQ\n",nswitch);
+      p_busIO->header(ioBuf);
+      refactor = true;
+    }
     // Push current values in X vector back into network components
     // Need to implement setValues method in PFBus class in order for this to
     // work
@@ -329,14 +422,19 @@ bool gridpack::powerflow::PFAppModule::solve()
 //    p_busIO->header("\nnew PQ vector\n");
 //    PQ->print();
     timer->stop(t_vmap);
-    timer->start(t_mmap);
-    p_factory->setMode(Jacobian);
+    // Only rebuild the Jacobian if the reuse policy calls for it. Otherwise
+    // the previous factorization is used for this iteration
+    if (iter+1-lastFactor >= p_refactorInterval) refactor = true;
+    if (refactor) {
+      timer->start(t_mmap);
+      p_factory->setMode(Jacobian);
 #ifdef USE_REAL_VALUES
-    jMap.mapToRealMatrix(J);
+      jMap.mapToRealMatrix(J);
 #else
-    jMap.mapToMatrix(J);
+      jMap.mapToMatrix(J);
 #endif
-    timer->stop(t_mmap);
+      timer->stop(t_mmap);
+    }
 
     // Create linear solver
     timer->start(t_lsolv);
@@ -346,7 +444,14 @@ bool gridpack::powerflow::PFAppModule::solve()
 //    sprintf(dbgfile,"pq%d.bin",iter+1);
 //    PQ->saveBinary(dbgfile);
     try {
-      solver.solve(*PQ, *X);
+      if (refactor) {
+        solver.solve(*PQ, *X);
+        p_factorizations++;
+        lastFactor = iter+1;
+        refactor = false;
+      } else {
+        solver.resolve(*PQ, *X);
+      }
     } catch (const gridpack::Exception e) {
       p_busIO->header("Solver failure\n\n");
       timer->stop(t_lsolv);
@@ -354,12 +459,15 @@ bool gridpack::powerflow::PFAppModule::solve()
     }
     timer->stop(t_lsolv);
 
+    gridpack::ComplexType oldtol = tol;
     tol = PQ->normInfinity();
+    if (real(tol) > p_contractionLimit*real(oldtol)) refactor = true;
     sprintf(ioBuf,"\nIteration %d Tol: %12.6e\n",iter+1,real(tol));
     p_busIO->header(ioBuf);
     iter++;
   }
 
+  p_iterations += iter;
   if (iter >= p_max_iteration) ret = false;
 
   // Push final result back onto buses
@@ -376,6 +484,150 @@ bool gridpack::powerflow::PFAppModule::solve()
   timer->stop(t_total);
   return ret;
 }
+/**
+ * Check whether any bus has switched between PV and PQ since B'' was built,
+ * and record the current bus types
+ * @return true if B'' needs to be rebuilt
+ */
+bool gridpack::powerflow::PFAppModule::fdBusTypesChanged()
+{
+  int nbus = p_network->numBuses();
+  int changed = (static_cast<int>(p_fdPV.size()) != nbus ? 1 : 0);
+  p_fdPV.resize(nbus);
+  for (int i=0; i<nbus; i++) {
+    gridpack::powerflow::PFBus *bus =
+      dynamic_cast<gridpack::powerflow::PFBus*>(p_network->getBus(i).get());
+    int pv = (bus->isPV() ? 1 : 0);
+    if (pv != p_fdPV[i]) changed = 1;
+    p_fdPV[i] = pv;
+  }
+  p_comm.sum(&changed, 1);
+  return changed > 0;
+}
+
+/**
+ * Fast decoupled iterations. B' and B'' are kept from one solve to the next,
+ * and are only rebuilt and refactored if the topology changed or (for B'') a
+ * bus switched between PV and PQ. Network buses are left with the last
+ * iterate
+ * @return true if the mismatch converged
+ */
+bool gridpack::powerflow::PFAppModule::fdSolve()
+{
+  gridpack::utility::Configuration::CursorPtr cursor;
+  cursor = p_config->getCursor("Configuration.Powerflow");
+
+  if (!p_bpAnalysis) {
+    p_bpAnalysis.reset(new gridpack::math::LinearSolverAnalysis(
+          p_network->communicator()));
+    p_bppAnalysis.reset(new gridpack::math::LinearSolverAnalysis(
+          p_network->communicator()));
+  }
+
+  // Constant matrices. These depend only on the network topology, impedances
+  // and bus types, so they are factored the first time they are used after
+  // they are built and reused after that
+  bool bppNew = fdBusTypesChanged() || p_fdStale || !p_Bpp;
+  if (p_fdStale || !p_Bp) {
+    p_factory->setMode(p_fdXB ? BPrimeXB : BPrimeBX);
+    gridpack::mapper::FullMatrixMap<PFNetwork> bpMap(p_network);
+    p_Bp = bpMap.mapToRealMatrix();
+    p_bpSolver.reset(new gridpack::math::RealLinearSolver(*p_Bp,
+          p_bpAnalysis));
+    p_bpSolver->configure(cursor);
+    p_bpFactored = false;
+  }
+  if (bppNew) {
+    p_factory->setMode(p_fdXB ? BDoublePrimeXB : BDoublePrimeBX);
+    gridpack::mapper::FullMatrixMap<PFNetwork> bppMap(p_network);
+    p_Bpp = bppMap.mapToRealMatrix();
+    p_bppSolver.reset(new gridpack::math::RealLinearSolver(*p_Bpp,
+          p_bppAnalysis));
+    p_bppSolver->configure(cursor);
+    p_bppFactored = false;
+  }
+  p_fdStale = false;
+
+  // Mismatch vectors
+  p_factory->setMode(PMismatch);
+  gridpack::mapper::BusVectorMap<PFNetwork> pMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> dP = pMap.mapToRealVector();
+  p_factory->setMode(QMismatch);
+  gridpack::mapper::BusVectorMap<PFNetwork> qMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> dQ = qMap.mapToRealVector();
+  boost::shared_ptr<gridpack::math::RealVector> dA(dP->clone());
+  boost::shared_ptr<gridpack::math::RealVector> dV(dQ->clone());
+
+  double ptol = dP->normInfinity();
+  double qtol = dQ->normInfinity();
+  double oldtol = std::max(ptol,qtol);
+  char ioBuf[128];
+  int iter = 0;
+  bool ret = (oldtol <= p_tolerance);
+  if (ret) return ret;
+  while (iter < p_fdMaxIteration) {
+    // P-theta half iteration
+    dA->zero();
+    try {
+      if (!p_bpFactored) {
+        p_bpSolver->solve(*dP, *dA);
+        p_factorizations++;
+        p_bpFactored = true;
+      } else {
+        p_bpSolver->resolve(*dP, *dA);
+      }
+    } catch (const gridpack::Exception e) {
+      p_busIO->header("Solver failure\n\n");
+      p_fdStale = true;
+      break;
+    }
+    p_factory->setMode(PMismatch);
+    pMap.mapToBus(dA);
+    p_network->updateBuses();
+
+    // Q-V half iteration, with the updated angles
+    p_factory->setMode(QMismatch);
+    qMap.mapToRealVector(dQ);
+    dV->zero();
+    try {
+      if (!p_bppFactored) {
+        p_bppSolver->solve(*dQ, *dV);
+        p_factorizations++;
+        p_bppFactored = true;
+      } else {
+        p_bppSolver->resolve(*dQ, *dV);
+      }
+    } catch (const gridpack::Exception e) {
+      p_busIO->header("Solver failure\n\n");
+      p_fdStale = true;
+      break;
+    }
+    qMap.mapToBus(dV);
+    p_network->updateBuses();
+    iter++;
+
+    // Check convergence with the new voltages
+    p_factory->setMode(PMismatch);
+    pMap.mapToRealVector(dP);
+    p_factory->setMode(QMismatch);
+    qMap.mapToRealVector(dQ);
+    ptol = dP->normInfinity();
+    qtol = dQ->normInfinity();
+    double tol = std::max(ptol,qtol);
+    sprintf(ioBuf,"\nFast decoupled iteration %d Tol: %12.6e\n",iter,tol);
+    p_busIO->header(ioBuf);
+    if (tol <= p_tolerance) {
+      ret = true;
+      break;
+    }
+    // Let Newton-Raphson deal with diverging iterations
+    if (tol > oldtol) break;
+    oldtol = tol;
+  }
+  p_iterations += iter;
+  return ret;
+}
+
 /**
  * Execute the iterative solve portion of the application using a library
  * non-linear solver
@@ -580,6 +832,7 @@ bool gridpack::powerflow::PFAppModule::setContingency(
     ret = false;
   }
   p_factory->checkLoneBus();
+  p_fdStale = true;
   return ret;
 }
 
@@ -630,6 +883,7 @@ bool gridpack::powerflow::PFAppModule::unSetContingency(
     ret = false;
   }
   p_factory->clearLoneBus();
+  p_fdStale = true;
   return ret;
 }
 
@@ -688,6 +942,47 @@ bool gridpack::powerflow::PFAppModule::checkLineOverloadViolations(int area)
   return p_factory->checkLineOverloadViolations(area);
 }
 
+/**
+ * Return statistics from the last call to solve
+ * @param iterations number of Newton iterations after the initial solve
+ * @param factorizations number of times the Jacobian was built and factored
+ */
+void gridpack::powerflow::PFAppModule::getSolveStatistics(int *iterations,
+    int *factorizations)
+{
+  *iterations = p_iterations;
+  *factorizations = p_factorizations;
+}
+
+/**
+ * Check for both voltage and line overload violations in the network. This
+ * only requires a single global reduction
+ * @param minV maximum voltage limit
+ * @param maxV maximum voltage limit
+ * @param voltage_ok returns true if no voltage violations found
+ * @param line_ok returns true if no line overload violations found
+ * @return true if no violations of either kind found
+ */
+bool gridpack::powerflow::PFAppModule::checkViolations(double Vmin,
+    double Vmax, bool *voltage_ok, bool *line_ok)
+{
+  return p_factory->checkViolations(Vmin,Vmax,voltage_ok,line_ok);
+}
+
+/**
+ * Count voltage and line overload violations and find the worst
+ * voltages and line loading in the current solution
+ * @param minV maximum voltage limit
+ * @param maxV maximum voltage limit
+ * @return summary of violations
+ */
+gridpack::powerflow::PFViolationSummary
+  gridpack::powerflow::PFAppModule::getViolationSummary(double Vmin,
+      double Vmax)
+{
+  return p_factory->getViolationSummary(Vmin,Vmax);
+}
+
 /**
  * Reset voltages to values in network configuration file
  */
@@ -695,3 +990,607 @@ void gridpack::powerflow::PFAppModule::resetVoltages()
 {
   p_factory->resetVoltages();
 }
+
+/**
+ * Run a quasi-static time series of power flows on the current network.
+ * Parameters are read from the Configuration.Powerflow.TimeSeries block:
+ *   profile: file of load and generation setpoints (see PFProfile)
+ *   profileFormat: csv (default) or binary
+ *   outputFile: binary results file (default pf_time_series.bin)
+ *   maxSteps: optional limit on the number of time points
+ * Each time point starts from the solution of the previous one. The mappers
+ * and linear solver are set up once, and the last factorization of the
+ * Jacobian is reused as a chord Jacobian, refactored according to the
+ * refactorInterval and contractionLimit parameters. The results
+ * file contains the number of buses and their original indices (32 bit
+ * integers), in global bus order, followed by one record for each time
+ * point: the time (double), whether the solve converged and the number of
+ * iterations (32 bit integers), then voltage magnitudes and phase angles in
+ * radians (doubles) for all buses
+ * @return number of time points that did not converge
+ */
+int gridpack::powerflow::PFAppModule::solveTimeSeries()
+{
+  gridpack::utility::Configuration::CursorPtr cursor;
+  cursor = p_config->getCursor("Configuration.Powerflow.TimeSeries");
+  if (!cursor) {
+    throw gridpack::Exception("solveTimeSeries: no TimeSeries block found"
+        " in Powerflow configuration");
+  }
+  std::string filename = cursor->get("profile","");
+  bool binary = (cursor->get("profileFormat","csv") == "binary");
+  std::string outfile = cursor->get("outputFile","pf_time_series.bin");
+  int maxSteps = cursor->get("maxSteps",-1);
+  PFProfile profile;
+  if (!profile.open(filename, binary)) {
+    throw gridpack::Exception("solveTimeSeries: cannot read profile "
+        + filename);
+  }
+
+  // Find the local buses that each column applies to once, so each time
+  // point is a single pass over the columns
+  std::vector<PFSetpoint> setpoints;
+  resolveProfile(profile, setpoints);
+
+  // The Y-bus and the layouts of the mismatch vector and Jacobian do not
+  // change from one time point to the next
+  p_factory->setYBus();
+  p_factory->setMode(RHS);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> PQ = vMap.mapToRealVector();
+  boost::shared_ptr<gridpack::math::RealVector> X(PQ->clone());
+  p_factory->setMode(Jacobian);
+  gridpack::mapper::FullMatrixMap<PFNetwork> jMap(p_network);
+  boost::shared_ptr<gridpack::math::RealMatrix> J = jMap.mapToRealMatrix();
+  if (!p_analysis) {
+    p_analysis.reset(new gridpack::math::LinearSolverAnalysis(
+          p_network->communicator()));
+  }
+  gridpack::math::RealLinearSolver solver(*J, p_analysis);
+  solver.configure(p_config->getCursor("Configuration.Powerflow"));
+  bool factored = false;
+
+  FILE *fp = openBusResults(outfile);
+  std::vector<double> values;
+  double time;
+  int step = 0;
+  int failures = 0;
+  char ioBuf[128];
+  while ((maxSteps < 0 || step < maxSteps) && profile.next(&time, values)) {
+    p_factory->applySetpoints(setpoints, values);
+    sprintf(ioBuf,"\nTime series power flow at time %f\n",time);
+    p_busIO->header(ioBuf);
+    if (p_enforceQlim) p_factory->clearQlim();
+    p_factory->setSBus();
+    p_iterations = 0;
+    p_factorizations = 0;
+    bool ok = false;
+    if (p_fastDecoupled) {
+      bool fdok = fdSolve();
+      ok = fdok && !p_enforceQlim;
+      if (!fdok) {
+        p_busIO->header("\nFast decoupled iterations did not converge,"
+            " switching to Newton-Raphson\n");
+      }
+    }
+
+    int iter = 0;
+    int lastFactor = 0;
+    bool refactor = !factored;
+    double tol, oldtol = 0.0;
+    while (!ok && iter <= p_max_iteration) {
+      p_factory->setMode(RHS);
+      vMap.mapToRealVector(PQ);
+      tol = PQ->normInfinity();
+      if (tol <= p_tolerance) {
+        // Switch PV buses that violate their reactive power limits to PQ
+        // once converged, as in solve()
+        int nswitch = (p_enforceQlim ? p_factory->enforceQlim() : 0);
+        if (nswitch == 0) {
+          ok = true;
+          break;
+        }
+        sprintf(ioBuf,"\nSwitched %d PV buses to PQ\n",nswitch);
+        p_busIO->header(ioBuf);
+        vMap.mapToRealVector(PQ);
+        tol = PQ->normInfinity();
+        refactor = true;
+      }
+      if (iter == p_max_iteration) break;
+      // Refactor if the chord iterations stall
+      if (iter > 0 && tol > p_contractionLimit*oldtol) refactor = true;
+      if (iter-lastFactor >= p_refactorInterval) refactor = true;
+      if (refactor) {
+        p_factory->setMode(Jacobian);
+        jMap.mapToRealMatrix(J);
+      }
+      X->zero();
+      try {
+        if (refactor) {
+          solver.solve(*PQ, *X);
+          p_factorizations++;
+          lastFactor = iter;
+          factored = true;
+          refactor = false;
+        } else {
+          solver.resolve(*PQ, *X);
+        }
+      } catch (const gridpack::Exception e) {
+        p_busIO->header("Solver failure\n\n");
+        factored = false;
+        break;
+      }
+      p_factory->setMode(RHS);
+      vMap.mapToBus(X);
+      p_network->updateBuses();
+      oldtol = tol;
+      iter++;
+      sprintf(ioBuf,"\nIteration %d Tol: %12.6e\n",iter,tol);
+      p_busIO->header(ioBuf);
+    }
+    p_iterations += iter;
+
+    if (!ok) failures++;
+    writeBusResults(fp, time, ok, p_iterations);
+    // A failed solve is a poor starting point for the next time point, and
+    // so is its Jacobian
+    if (!ok) {
+      resetVoltages();
+      factored = false;
+    }
+    step++;
+  }
+  if (fp) fclose(fp);
+  profile.close();
+  return failures;
+}
+
+/**
+ * Solve power flow for an ensemble of scenarios that differ only in load and
+ * generation setpoints. All scenarios start from the current bus voltages and
+ * share one set of mappers, one Jacobian and one solver. In each iteration
+ * the mismatches of all unconverged scenarios are solved together as a block
+ * right hand side, so the factorization is shared by the whole ensemble. The
+ * Jacobian is re-evaluated at the state of the first unconverged scenario
+ * according to the refactorInterval and contractionLimit parameters. A
+ * scenario that still stalls right after the Jacobian is re-evaluated is then
+ * solved with its own Jacobian, whose numeric factorization reuses the shared
+ * analysis. Reactive power limits are not enforced. Setpoints are left at the
+ * values of the last scenario evaluated; use setEnsembleScenario() to load
+ * the solution of a particular scenario
+ * @param setpoints setpoints changed by the scenarios (see
+ *        PFFactoryModule::resolveSetpoints())
+ * @param values values[k] holds the setpoint values for scenario k
+ * @param converged returns true for each scenario that converged
+ * @return number of scenarios that did not converge
+ */
+int gridpack::powerflow::PFAppModule::solveEnsemble(
+    const std::vector<PFSetpoint> &setpoints,
+    const std::vector<std::vector<double> > &values,
+    std::vector<bool> &converged)
+{
+  gridpack::utility::CoarseTimer *timer =
+    gridpack::utility::CoarseTimer::instance();
+  int t_ens = timer->createCategory("Powerflow: Ensemble Solve");
+  timer->start(t_ens);
+  int nscen = values.size();
+  int i, j, k;
+  converged.assign(nscen, false);
+  p_ensembleSetpoints = setpoints;
+  p_ensembleValues = values;
+  p_ensembleStates.clear();
+  p_iterations = 0;
+  p_factorizations = 0;
+  if (nscen == 0) {
+    timer->stop(t_ens);
+    return 0;
+  }
+  p_factory->setYBus();
+  if (p_enforceQlim) p_factory->clearQlim();
+
+  // Every scenario starts from the current bus voltages
+  p_factory->setMode(WarmStart);
+  gridpack::mapper::BusVectorMap<PFNetwork> wMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> start =
+    wMap.mapToRealVector();
+  for (k=0; k<nscen; k++) {
+    p_ensembleStates.push_back(
+        boost::shared_ptr<gridpack::math::RealVector>(start->clone()));
+  }
+
+  // Mappers, Jacobian and linear solver are shared by all scenarios
+  p_factory->setMode(RHS);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  boost::shared_ptr<gridpack::math::RealVector> PQ = vMap.mapToRealVector();
+  boost::shared_ptr<gridpack::math::RealVector> dX(PQ->clone());
+  p_factory->setMode(Jacobian);
+  gridpack::mapper::FullMatrixMap<PFNetwork> jMap(p_network);
+  boost::shared_ptr<gridpack::math::RealMatrix> J = jMap.mapToRealMatrix();
+  if (!p_analysis) {
+    p_analysis.reset(new gridpack::math::LinearSolverAnalysis(
+          p_network->communicator()));
+  }
+  gridpack::math::RealLinearSolver solver(*J, p_analysis);
+  solver.configure(p_config->getCursor("Configuration.Powerflow"));
+
+  int nrows = PQ->size();
+  int lo, hi;
+  PQ->localIndexRange(lo, hi);
+  std::vector<std::vector<double> > mismatch(nscen);
+  std::vector<double> norms(nscen, 0.0);
+  std::vector<int> active, fallback;
+  // Scenarios that stall with a fresh chord Jacobian are too far from the
+  // scenario it was built for, and get their own Jacobian. Its numeric
+  // factorization reuses the shared analysis
+  std::vector<bool> own(nscen, false);
+  boost::shared_ptr<gridpack::math::RealMatrix> Jk;
+  boost::shared_ptr<gridpack::math::RealLinearSolver> ownSolver;
+  bool refactor = true;
+  int lastFactor = 0;
+  int iter = 0;
+  int nprocs = p_comm.size();
+  int me = p_comm.rank();
+  char ioBuf[128];
+  while (true) {
+    // Evaluate the mismatch of every unconverged scenario
+    active.clear();
+    fallback.clear();
+    bool stalled = false;
+    for (k=0; k<nscen; k++) {
+      if (converged[k]) continue;
+      loadScenario(k, wMap);
+      p_factory->setMode(RHS);
+      vMap.mapToRealVector(PQ);
+      double norm = PQ->normInfinity();
+      if (iter > 0 && norms[k] > 0.0 && !own[k] &&
+          norm > p_contractionLimit*norms[k]) {
+        if (lastFactor == iter-1) {
+          own[k] = true;
+        } else {
+          stalled = true;
+        }
+      }
+      norms[k] = norm;
+      if (norm <= p_tolerance) {
+        converged[k] = true;
+        continue;
+      }
+      if (own[k]) {
+        fallback.push_back(k);
+        continue;
+      }
+      active.push_back(k);
+      mismatch[k].resize(hi-lo);
+      if (hi > lo) PQ->getElementRange(lo, hi, &mismatch[k][0]);
+    }
+    if ((active.empty() && fallback.empty()) || iter >= p_max_iteration) {
+      break;
+    }
+
+    if (iter-lastFactor >= p_refactorInterval || stalled) refactor = true;
+    if (refactor && !active.empty()) {
+      // The Jacobian depends on injections evaluated with the RHS
+      loadScenario(active[0], wMap);
+      p_factory->setMode(RHS);
+      vMap.mapToRealVector(PQ);
+      p_factory->setMode(Jacobian);
+      jMap.mapToRealMatrix(J);
+      p_factorizations++;
+      lastFactor = iter;
+      refactor = false;
+    }
+
+    int nact = active.size();
+    bool failed = false;
+    if (nact > 0) {
+      // Solve for the corrections of all active scenarios at once. Columns of
+      // the dense right hand side are divided evenly between processors
+      int clo = me*(nact/nprocs) + std::min(me, nact%nprocs);
+      int chi = clo + nact/nprocs + (me < nact%nprocs ? 1 : 0);
+      boost::shared_ptr<gridpack::math::RealMatrix>
+        B(gridpack::math::RealMatrix::createDense(p_comm, nrows, nact,
+              hi-lo, chi-clo));
+      for (j=0; j<nact; j++) {
+        std::vector<double> &col = mismatch[active[j]];
+        for (i=lo; i<hi; i++) {
+          if (col[i-lo] != 0.0) B->setElement(i, j, col[i-lo]);
+        }
+      }
+      B->ready();
+      boost::shared_ptr<gridpack::math::RealMatrix> X;
+      try {
+        X.reset(solver.solve(*B));
+      } catch (const gridpack::Exception e) {
+        p_busIO->header("Solver failure\n\n");
+        failed = true;
+      }
+
+      // Apply corrections to the stored scenario states
+      for (j=0; j<nact && !failed; j++) {
+        k = active[j];
+        gridpack::math::column(*X, j, *dX);
+        p_factory->setMode(WarmStart);
+        wMap.mapToBus(p_ensembleStates[k]);
+        p_factory->setMode(RHS);
+        vMap.mapToBus(dX);
+        p_factory->setMode(WarmStart);
+        wMap.mapToRealVector(p_ensembleStates[k]);
+      }
+    }
+
+    // Scenarios with their own Jacobian are solved one at a time
+    for (j=0; j<fallback.size() && !failed; j++) {
+      k = fallback[j];
+      loadScenario(k, wMap);
+      p_factory->setMode(RHS);
+      vMap.mapToRealVector(PQ);
+      p_factory->setMode(Jacobian);
+      if (!Jk) {
+        Jk = jMap.mapToRealMatrix();
+        ownSolver.reset(new gridpack::math::RealLinearSolver(*Jk, p_analysis));
+        ownSolver->configure(p_config->getCursor("Configuration.Powerflow"));
+      } else {
+        jMap.mapToRealMatrix(Jk);
+      }
+      dX->zero();
+      try {
+        ownSolver->solve(*PQ, *dX);
+      } catch (const gridpack::Exception e) {
+        p_busIO->header("Solver failure\n\n");
+        failed = true;
+        break;
+      }
+      p_factorizations++;
+      p_factory->setMode(RHS);
+      vMap.mapToBus(dX);
+      p_factory->setMode(WarmStart);
+      wMap.mapToRealVector(p_ensembleStates[k]);
+    }
+    if (failed) break;
+    iter++;
+    sprintf(ioBuf,"\nEnsemble iteration %d: %d of %d scenarios active\n",
+        iter,nact+(int)fallback.size(),nscen);
+    p_busIO->header(ioBuf);
+  }
+  p_iterations = iter;
+
+  int failures = 0;
+  for (k=0; k<nscen; k++) {
+    if (!converged[k]) failures++;
+  }
+  timer->stop(t_ens);
+  return failures;
+}
+
+/**
+ * Run an ensemble of power flows on the current network. Parameters are
+ * read from the Configuration.Powerflow.Ensemble block:
+ *   profile: file of load and generation setpoints (see PFProfile), with
+ *            one row per scenario. The first column is a scenario label
+ *   profileFormat: csv (default) or binary
+ *   outputFile: binary results file (default pf_ensemble.bin)
+ *   maxScenarios: optional limit on the number of scenarios
+ * The results file has the same layout as the one written by
+ * solveTimeSeries(), with the scenario label in place of the time. The
+ * iteration count is the number of ensemble iterations
+ * @return number of scenarios that did not converge
+ */
+int gridpack::powerflow::PFAppModule::solveEnsemble()
+{
+  gridpack::utility::Configuration::CursorPtr cursor;
+  cursor = p_config->getCursor("Configuration.Powerflow.Ensemble");
+  if (!cursor) {
+    throw gridpack::Exception("solveEnsemble: no Ensemble block found"
+        " in Powerflow configuration");
+  }
+  std::string filename = cursor->get("profile","");
+  bool binary = (cursor->get("profileFormat","csv") == "binary");
+  std::string outfile = cursor->get("outputFile","pf_ensemble.bin");
+  int maxScenarios = cursor->get("maxScenarios",-1);
+  PFProfile profile;
+  if (!profile.open(filename, binary)) {
+    throw gridpack::Exception("solveEnsemble: cannot read profile "
+        + filename);
+  }
+  std::vector<PFSetpoint> setpoints;
+  resolveProfile(profile, setpoints);
+  std::vector<double> labels;
+  std::vector<std::vector<double> > values;
+  std::vector<double> row;
+  double label;
+  while ((maxScenarios < 0 || values.size() < maxScenarios) &&
+      profile.next(&label, row)) {
+    labels.push_back(label);
+    values.push_back(row);
+  }
+  profile.close();
+
+  std::vector<bool> converged;
+  int failures = solveEnsemble(setpoints, values, converged);
+  char ioBuf[128];
+  sprintf(ioBuf,"\nEnsemble of %d scenarios: %d did not converge in %d"
+      " iterations\n",static_cast<int>(values.size()),failures,p_iterations);
+  p_busIO->header(ioBuf);
+
+  FILE *fp = openBusResults(outfile);
+  int k;
+  for (k=0; k<values.size(); k++) {
+    setEnsembleScenario(k);
+    writeBusResults(fp, labels[k], converged[k], p_iterations);
+  }
+  if (fp) fclose(fp);
+  return failures;
+}
+
+/**
+ * Load the solution and setpoints of one scenario from the last call to
+ * solveEnsemble() onto the buses, e.g. to write output for it
+ * @param k scenario index
+ */
+void gridpack::powerflow::PFAppModule::setEnsembleScenario(int k)
+{
+  if (k < 0 || k >= p_ensembleStates.size()) {
+    throw gridpack::Exception("setEnsembleScenario: scenario index out"
+        " of range");
+  }
+  p_factory->setMode(WarmStart);
+  gridpack::mapper::BusVectorMap<PFNetwork> wMap(p_network);
+  loadScenario(k, wMap);
+}
+
+/**
+ * Push the stored state and setpoints of an ensemble scenario onto the
+ * buses
+ * @param k scenario index
+ * @param wMap mapper for vectors in the WarmStart layout
+ */
+void gridpack::powerflow::PFAppModule::loadScenario(int k,
+    gridpack::mapper::BusVectorMap<PFNetwork> &wMap)
+{
+  p_factory->setMode(WarmStart);
+  wMap.mapToBus(p_ensembleStates[k]);
+  p_network->updateBuses();
+  p_factory->applySetpoints(p_ensembleSetpoints, p_ensembleValues[k]);
+  p_factory->setSBus();
+}
+
+/**
+ * Resolve the columns of a load and generation profile to setpoints on
+ * local buses
+ * @param profile open profile
+ * @param setpoints setpoints for profile columns on this processor
+ */
+void gridpack::powerflow::PFAppModule::resolveProfile(
+    const PFProfile &profile, std::vector<PFSetpoint> &setpoints)
+{
+  const char *fields[] = {GENERATOR_PG, GENERATOR_QG, LOAD_PL, LOAD_QL};
+  const std::vector<PFProfile::Column> &columns = profile.columns();
+  std::vector<int> busIDs;
+  std::vector<std::string> ids, names;
+  int j;
+  for (j=0; j<columns.size(); j++) {
+    busIDs.push_back(columns[j].busID);
+    ids.push_back(columns[j].id);
+    names.push_back(fields[columns[j].field]);
+  }
+  p_factory->resolveSetpoints(busIDs, ids, names, setpoints);
+}
+
+/**
+ * Open a binary bus results file and write the header: the number of buses
+ * and their original indices in global bus order. Must be called on all
+ * processors
+ * @param filename name of results file
+ * @return file pointer on the first processor, NULL everywhere else (or if
+ *         the file could not be opened)
+ */
+FILE* gridpack::powerflow::PFAppModule::openBusResults(
+    const std::string &filename)
+{
+  int numBus = p_network->numBuses();
+  int nbus = p_network->totalBuses();
+  int i;
+  std::vector<int> ids(nbus, 0);
+  for (i=0; i<numBus; i++) {
+    if (p_network->getActiveBus(i)) {
+      ids[p_network->getGlobalBusIndex(i)] = p_network->getOriginalBusIndex(i);
+    }
+  }
+  if (nbus > 0) p_comm.sum(&ids[0], nbus);
+  FILE *fp = NULL;
+  if (p_comm.rank() == 0) {
+    fp = fopen(filename.c_str(), "wb");
+    if (!fp) {
+      printf("openBusResults: cannot open output file %s\n",
+          filename.c_str());
+    } else {
+      fwrite(&nbus, sizeof(int), 1, fp);
+      if (nbus > 0) fwrite(&ids[0], sizeof(int), nbus, fp);
+    }
+  }
+  return fp;
+}
+
+/**
+ * Write one record of bus results: a label, the convergence flag and
+ * iteration count, then voltage magnitudes and phase angles of all buses in
+ * global bus order. Must be called on all processors
+ * @param fp file pointer returned by openBusResults()
+ * @param label time or scenario label
+ * @param converged true if the solve converged
+ * @param iterations number of iterations
+ */
+void gridpack::powerflow::PFAppModule::writeBusResults(FILE *fp,
+    double label, bool converged, int iterations)
+{
+  int numBus = p_network->numBuses();
+  int nbus = p_network->totalBuses();
+  int i;
+  std::vector<double> state(2*nbus, 0.0);
+  for (i=0; i<numBus; i++) {
+    if (p_network->getActiveBus(i)) {
+      PFBus *bus = dynamic_cast<PFBus*>(p_network->getBus(i).get());
+      int g = p_network->getGlobalBusIndex(i);
+      state[g] = bus->getVoltage();
+      state[nbus+g] = bus->getPhase();
+    }
+  }
+  if (nbus > 0) p_comm.sum(&state[0], 2*nbus);
+  if (fp) {
+    int iconv = converged ? 1 : 0;
+    fwrite(&label, sizeof(double), 1, fp);
+    fwrite(&iconv, sizeof(int), 1, fp);
+    fwrite(&iterations, sizeof(int), 1, fp);
+    if (nbus > 0) fwrite(&state[0], sizeof(double), 2*nbus, fp);
+  }
+}
+
+/**
+ * Save the current (converged) bus voltages as the base case used by
+ * warmStart()
+ */
+void gridpack::powerflow::PFAppModule::saveBaseCase()
+{
+  p_factory->setMode(WarmStart);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  p_baseVoltages = vMap.mapToRealVector();
+}
+
+/**
+ * Set the starting voltages for a contingency solve, using the warmStart
+ * policy from the input deck: "none" resets voltages to the values in the
+ * network configuration file, "base" starts from the base case saved by
+ * saveBaseCase(), and "dc" also corrects the base case phase angles for
+ * line outages with a DC estimate. Call this before setContingency()
+ * @param event contingency that is about to be solved
+ */
+void gridpack::powerflow::PFAppModule::warmStart(
+    gridpack::powerflow::Contingency &event)
+{
+  if (p_warmStart == "none" || !p_baseVoltages) {
+    resetVoltages();
+    return;
+  }
+  if (p_warmStart == "dc" && !p_dcpf) {
+    // The DC base case overwrites the bus angles, so do it before the
+    // saved voltages are restored
+    p_dcpf.reset(new DCPFModule(p_network,
+          p_config->getCursor("Configuration.Powerflow")));
+    if (!p_dcpf->solve()) p_warmStart = "base";
+  }
+  p_factory->setMode(WarmStart);
+  gridpack::mapper::BusVectorMap<PFNetwork> vMap(p_network);
+  vMap.mapToBus(p_baseVoltages);
+  p_network->updateBuses();
+  if (p_warmStart == "dc" && event.p_type == Branch) {
+    std::vector<pathBranch> lines(event.p_from.size());
+    int i;
+    for (i=0; i<lines.size(); i++) {
+      lines[i].fromBus = event.p_from[i];
+      lines[i].toBus = event.p_to[i];
+      lines[i].branchID = event.p_ckt[i];
+    }
+    // If the outages island the network the angles are left unchanged
+    p_dcpf->solveOutage(lines, true);
+  }
+}
@@ -18,6 +18,7 @@
 #ifndef _pf_app_module_h_
 #define _pf_app_module_h_
 
+#include <cstdio>
 #include "boost/smart_ptr/shared_ptr.hpp"
 #include "pf_factory_module.hpp"
 
@@ -67,6 +68,9 @@ struct Contingency
   std::vector<bool> p_saveGenStatus;
 };
 
+class DCPFModule;
+class PFProfile;
+
 // Calling program for powerflow application
 
 class PFAppModule
@@ -95,18 +99,25 @@ class PFAppModule
 
     /**
      * Set up exchange buffers and other internal parameters and initialize
-     * network components using data from data collection
+     * network components using data from data collection. This can be
+     * called again on the same network, in which case the topology index
+     * maps evaluated by the first call are reused
      */
     void initialize();
 
     /**
-     * Reinitialize calculation from data collections
+     * Reinitialize calculation from data collections. Components are
+     * relinked using the index maps already stored on the network, so the
+     * global index maps are not rebuilt. This is still collective: the
+     * processors agree (with a reduction) that the stored maps are valid,
+     * and rebuild them if any processor finds them missing
      */
     void reload();
 
     /**
      * Execute the iterative solve portion of the application using a hand-coded
-     * Newton-Raphson solver
+     * Newton-Raphson solver. If fast decoupled iterations are enabled, these
+     * are used first and Newton-Raphson is only used if they converge slowly
      * @return false if an error was caught in the solution algorithm
      */
     bool solve();
@@ -161,6 +172,14 @@ class PFAppModule
      */
     bool unSetContingency(Contingency &event);
 
+    /**
+     * Discard the cached index maps so that they are recomputed on the next
+     * call to reload(), along with the fast decoupled matrices. Call this
+     * if the network topology is modified other than by setContingency()
+     * or unSetContingency()
+     */
+    void resetTopology();
+
     /**
      * Check to see if there are any voltage violations in the network
      * @param minV maximum voltage limit
@@ -202,12 +221,182 @@ class PFAppModule
      */
     void clearLineOverloadViolations();
 
+    /**
+     * Check for both voltage and line overload violations in the network.
+     * This only requires a single global reduction
+     * @param minV maximum voltage limit
+     * @param maxV maximum voltage limit
+     * @param voltage_ok returns true if no voltage violations found
+     * @param line_ok returns true if no line overload violations found
+     * @return true if no violations of either kind found
+     */
+    bool checkViolations(double Vmin, double Vmax, bool *voltage_ok = NULL,
+        bool *line_ok = NULL);
+
+    /**
+     * Count voltage and line overload violations and find the worst
+     * voltages and line loading in the current solution
+     * @param minV maximum voltage limit
+     * @param maxV maximum voltage limit
+     * @return summary of violations
+     */
+    PFViolationSummary getViolationSummary(double Vmin, double Vmax);
+
+    /**
+     * Return statistics from the last call to solve
+     * @param iterations number of Newton iterations after the initial solve,
+     * plus the number of fast decoupled iterations, if any
+     * @param factorizations number of times the Jacobian (or B' and B'')
+     * was built and factored
+     */
+    void getSolveStatistics(int *iterations, int *factorizations);
+
     /**
      * Reset voltages to values in network configuration file
      */
     void resetVoltages();
+
+    /**
+     * Save the current (converged) bus voltages as the base case used by
+     * warmStart()
+     */
+    void saveBaseCase();
+
+    /**
+     * Set the starting voltages for a contingency solve, using the
+     * warmStart policy from the input deck: "none" resets voltages to the
+     * values in the network configuration file, "base" starts from the base
+     * case saved by saveBaseCase(), and "dc" also corrects the base case
+     * phase angles for line outages with a DC estimate. Call this before
+     * setContingency()
+     * @param event contingency that is about to be solved
+     */
+    void warmStart(Contingency &event);
+
+    /**
+     * Run a quasi-static time series of power flows on the current network.
+     * Parameters are read from the Configuration.Powerflow.TimeSeries block:
+     *   profile: file of load and generation setpoints (see PFProfile)
+     *   profileFormat: csv (default) or binary
+     *   outputFile: binary results file (default pf_time_series.bin)
+     *   maxSteps: optional limit on the number of time points
+     * Each time point starts from the solution of the previous one. The
+     * mappers and linear solver are set up once, and the last factorization
+     * of the Jacobian is reused as a chord Jacobian, refactored according to
+     * the refactorInterval and contractionLimit parameters. The
+     * results file contains the number of buses and their original indices
+     * (32 bit integers), in global bus order, followed by one record for each
+     * time point: the time (double), whether the solve converged and the
+     * number of iterations (32 bit integers), then voltage magnitudes and
+     * phase angles in radians (doubles) for all buses
+     * @return number of time points that did not converge
+     */
+    int solveTimeSeries();
+
+    /**
+     * Solve power flow for an ensemble of scenarios that differ only in load
+     * and generation setpoints. All scenarios start from the current bus
+     * voltages and share one set of mappers, one Jacobian and one solver. In
+     * each iteration the mismatches of all unconverged scenarios are solved
+     * together as a block right hand side, so the factorization is shared by
+     * the whole ensemble. The Jacobian is re-evaluated at the state of the
+     * first unconverged scenario according to the refactorInterval and
+     * contractionLimit parameters. A scenario that still stalls right after
+     * the Jacobian is re-evaluated is then solved with its own Jacobian,
+     * whose numeric factorization reuses the shared analysis. Reactive power
+     * limits are not enforced. Setpoints are left at the values of the last
+     * scenario evaluated; use setEnsembleScenario() to load the solution of a
+     * particular scenario
+     * @param setpoints setpoints changed by the scenarios (see
+     *        PFFactoryModule::resolveSetpoints())
+     * @param values values[k] holds the setpoint values for scenario k
+     * @param converged returns true for each scenario that converged
+     * @return number of scenarios that did not converge
+     */
+    int solveEnsemble(const std::vector<PFSetpoint> &setpoints,
+        const std::vector<std::vector<double> > &values,
+        std::vector<bool> &converged);
+
+    /**
+     * Run an ensemble of power flows on the current network. Parameters are
+     * read from the Configuration.Powerflow.Ensemble block:
+     *   profile: file of load and generation setpoints (see PFProfile),
+     *            with one row per scenario. The first column is a scenario
+     *            label
+     *   profileFormat: csv (default) or binary
+     *   outputFile: binary results file (default pf_ensemble.bin)
+     *   maxScenarios: optional limit on the number of scenarios
+     * The results file has the same layout as the one written by
+     * solveTimeSeries(), with the scenario label in place of the time. The
+     * iteration count is the number of ensemble iterations
+     * @return number of scenarios that did not converge
+     */
+    int solveEnsemble();
+
+    /**
+     * Load the solution and setpoints of one scenario from the last call to
+     * solveEnsemble() onto the buses, e.g. to write output for it
+     * @param k scenario index
+     */
+    void setEnsembleScenario(int k);
   private:
 
+    /**
+     * Push the stored state and setpoints of an ensemble scenario onto the
+     * buses
+     * @param k scenario index
+     * @param wMap mapper for vectors in the WarmStart layout
+     */
+    void loadScenario(int k, gridpack::mapper::BusVectorMap<PFNetwork> &wMap);
+
+    /**
+     * Resolve the columns of a load and generation profile to setpoints on
+     * local buses
+     * @param profile open profile
+     * @param setpoints setpoints for profile columns on this processor
+     */
+    void resolveProfile(const PFProfile &profile,
+        std::vector<PFSetpoint> &setpoints);
+
+    /**
+     * Open a binary bus results file and write the header: the number of
+     * buses and their original indices in global bus order. Must be called
+     * on all processors
+     * @param filename name of results file
+     * @return file pointer on the first processor, NULL everywhere else (or
+     *         if the file could not be opened)
+     */
+    FILE* openBusResults(const std::string &filename);
+
+    /**
+     * Write one record of bus results: a label, the convergence flag and
+     * iteration count, then voltage magnitudes and phase angles of all
+     * buses in global bus order. Must be called on all processors
+     * @param fp file pointer returned by openBusResults()
+     * @param label time or scenario label
+     * @param converged true if the solve converged
+     * @param iterations number of iterations
+     */
+    void writeBusResults(FILE *fp, double label, bool converged,
+        int iterations);
+
+    /**
+     * Fast decoupled iterations. B' and B'' are kept from one solve to the
+     * next, and are only rebuilt and refactored if the topology changed or
+     * (for B'') a bus switched between PV and PQ. Network buses are left
+     * with the last iterate
+     * @return true if the mismatch converged
+     */
+    bool fdSolve();
+
+    /**
+     * Check whether any bus has switched between PV and PQ since B'' was
+     * built, and record the current bus types. Must be called on all
+     * processors
+     * @return true if B'' needs to be rebuilt
+     */
+    bool fdBusTypesChanged();
+
     // pointer to network
     boost::shared_ptr<PFNetwork> p_network;
 
@@ -223,6 +412,68 @@ class PFAppModule
     // convergence tolerance
     double p_tolerance;
 
+    // maximum number of iterations between Jacobian factorizations
+    int p_refactorInterval;
+
+    // refactor Jacobian if mismatch decreases by less than this factor
+    double p_contractionLimit;
+
+    // number of iterations in last solve
+    int p_iterations;
+
+    // number of Jacobian factorizations in last solve
+    int p_factorizations;
+
+    // ordering and symbolic factorization shared by Jacobian solves
+    gridpack::math::LinearSolverAnalysisPtr p_analysis;
+
+    // use fast decoupled iterations before Newton-Raphson
+    bool p_fastDecoupled;
+
+    // use the XB (rather than BX) fast decoupled scheme
+    bool p_fdXB;
+
+    // maximum number of fast decoupled iterations before Newton-Raphson
+    int p_fdMaxIteration;
+
+    // ordering and symbolic factorization shared by B' and B'' solves
+    gridpack::math::LinearSolverAnalysisPtr p_bpAnalysis;
+    gridpack::math::LinearSolverAnalysisPtr p_bppAnalysis;
+
+    // fast decoupled B' and B'' matrices and their (factored) solvers
+    boost::shared_ptr<gridpack::math::RealMatrix> p_Bp;
+    boost::shared_ptr<gridpack::math::RealMatrix> p_Bpp;
+    boost::shared_ptr<gridpack::math::RealLinearSolver> p_bpSolver;
+    boost::shared_ptr<gridpack::math::RealLinearSolver> p_bppSolver;
+
+    // B' and B'' must be rebuilt because the topology changed
+    bool p_fdStale;
+
+    // B' and B'' have been factored since they were built
+    bool p_bpFactored;
+    bool p_bppFactored;
+
+    // PV flags of the local buses when B'' was built
+    std::vector<int> p_fdPV;
+
+    // switch PV buses that reach their reactive power limits to PQ
+    bool p_enforceQlim;
+
+    // starting point for contingency solves (none, base or dc)
+    std::string p_warmStart;
+
+    // converged base case voltages, in WarmStart mode layout
+    boost::shared_ptr<gridpack::math::RealVector> p_baseVoltages;
+
+    // DC power flow used to correct the base case for line outages
+    boost::shared_ptr<DCPFModule> p_dcpf;
+
+    // solutions (in WarmStart layout) and setpoints of the last ensemble
+    std::vector<boost::shared_ptr<gridpack::math::RealVector> >
+      p_ensembleStates;
+    std::vector<PFSetpoint> p_ensembleSetpoints;
+    std::vector<std::vector<double> > p_ensembleValues;
+
     // pointer to bus IO module
     boost::shared_ptr<gridpack::serial_io::SerialBusIO<PFNetwork> > p_busIO;
 
@@ -16,7 +16,10 @@
 // -------------------------------------------------------------
 
 #include <vector>
+#include <map>
 #include "boost/smart_ptr/shared_ptr.hpp"
+#include <boost/mpi/collectives.hpp>
+#include <boost/serialization/vector.hpp>
 #include "gridpack/include/gridpack.hpp"
 #include "pf_factory_module.hpp"
 
@@ -101,26 +104,175 @@ void gridpack::powerflow::PFFactoryModule::setPQ(void)
  */
 //void gridpack::powerflow::PFFactoryModule::updatePg(std::string &name, int busID, std::string genID, double value)
 void gridpack::powerflow::PFFactoryModule::updatePg(int busID, std::string genID, double value)
+{
+  std::vector<int> lids = p_network->getLocalBusIndices(busID);
+  int i;
+  for (i=0; i<lids.size(); i++) {
+    dynamic_cast<PFBus*>(p_network->getBus(lids[i]).get())->setParam(
+        GENERATOR_PG, busID, genID, value);
+  }
+}
+
+void gridpack::powerflow::PFFactoryModule::updateQg(int busID, std::string genID, double value)
+{
+  std::vector<int> lids = p_network->getLocalBusIndices(busID);
+  int i;
+  for (i=0; i<lids.size(); i++) {
+    dynamic_cast<PFBus*>(p_network->getBus(lids[i]).get())->setParam(
+        GENERATOR_QG, busID, genID, value);
+  }
+}
+
+/**
+ * Find the local buses that a list of setpoint changes apply to. Changes
+ * on buses that are not on this processor are dropped, and changes on
+ * buses that appear more than once (ghosts) are kept for each copy. The
+ * result can be passed to applySetpoints() any number of times as long
+ * as the network is not repartitioned
+ * @param busIDs original index of the bus for each change
+ * @param ids generator (or load) ID for each change
+ * @param fields parameter for each change (GENERATOR_PG, GENERATOR_QG,
+ *        LOAD_PL or LOAD_QL)
+ * @param setpoints changes that apply to buses on this processor
+ */
+void gridpack::powerflow::PFFactoryModule::resolveSetpoints(
+    const std::vector<int> &busIDs, const std::vector<std::string> &ids,
+    const std::vector<std::string> &fields,
+    std::vector<PFSetpoint> &setpoints)
+{
+  if (ids.size() != busIDs.size() || fields.size() != busIDs.size()) {
+    throw gridpack::Exception("resolveSetpoints: bus, ID and field lists"
+        " have different lengths");
+  }
+  setpoints.clear();
+  int i, j;
+  for (i=0; i<busIDs.size(); i++) {
+    if (fields[i] != GENERATOR_PG && fields[i] != GENERATOR_QG &&
+        fields[i] != LOAD_PL && fields[i] != LOAD_QL) {
+      throw gridpack::Exception("resolveSetpoints: unknown field "
+          + fields[i]);
+    }
+    std::vector<int> lids = p_network->getLocalBusIndices(busIDs[i]);
+    for (j=0; j<lids.size(); j++) {
+      PFSetpoint setpoint;
+      setpoint.bus = dynamic_cast<PFBus*>(p_network->getBus(lids[j]).get());
+      setpoint.busID = busIDs[i];
+      setpoint.id = ids[i];
+      setpoint.field = fields[i];
+      setpoint.index = i;
+      setpoints.push_back(setpoint);
+    }
+  }
+}
+
+/**
+ * Apply values to a list of resolved setpoints in one pass
+ * @param setpoints list returned by resolveSetpoints()
+ * @param values new values, in the order of the original request
+ */
+void gridpack::powerflow::PFFactoryModule::applySetpoints(
+    const std::vector<PFSetpoint> &setpoints,
+    const std::vector<double> &values)
+{
+  int i;
+  for (i=0; i<setpoints.size(); i++) {
+    const PFSetpoint &setpoint = setpoints[i];
+    setpoint.bus->setParam(setpoint.field, setpoint.busID, setpoint.id,
+        values[setpoint.index]);
+  }
+}
+
+/**
+ * Resolve and apply a list of setpoint changes. Every processor can pass
+ * the same list; each one only touches its own buses
+ * @param busIDs original index of the bus for each change
+ * @param ids generator (or load) ID for each change
+ * @param fields parameter for each change (GENERATOR_PG, GENERATOR_QG,
+ *        LOAD_PL or LOAD_QL)
+ * @param values new value for each change
+ */
+void gridpack::powerflow::PFFactoryModule::updateSetpoints(
+    const std::vector<int> &busIDs, const std::vector<std::string> &ids,
+    const std::vector<std::string> &fields,
+    const std::vector<double> &values)
+{
+  if (values.size() != busIDs.size()) {
+    throw gridpack::Exception("updateSetpoints: bus and value lists"
+        " have different lengths");
+  }
+  std::vector<PFSetpoint> setpoints;
+  resolveSetpoints(busIDs, ids, fields, setpoints);
+  applySetpoints(setpoints, values);
+}
+
+/**
+ * Use the same two row block layout for every bus in the Jacobian, RHS
+ * and State modes, so that buses can switch between PV and PQ without
+ * changing the size of the Jacobian
+ * @param flag true if fixed layout is used
+ */
+void gridpack::powerflow::PFFactoryModule::setFixedLayout(bool flag)
 {
   int numBus = p_network->numBuses();
   int i;
-  int genIndex=0;
   for (i=0; i<numBus; i++) {
-//    dynamic_cast<PFBus*>(p_network->getBus(i).get())->setParam(name,busID, genID, value);
-    dynamic_cast<PFBus*>(p_network->getBus(i).get())->setParam(GENERATOR_PG,
-        busID, genID, value);
+    dynamic_cast<PFBus*>(p_network->getBus(i).get())->setFixedLayout(flag);
   }
 }
 
-void gridpack::powerflow::PFFactoryModule::updateQg(int busID, std::string genID, double value)
+/**
+ * Switch PV buses that violate the reactive power limits of their
+ * generators to PQ buses, with generation held at the limit. Reactive
+ * injections from the last evaluation of the RHS vector are used. Ghost
+ * copies of switched buses are switched as well
+ * @return number of buses switched on all processors
+ */
+int gridpack::powerflow::PFFactoryModule::enforceQlim()
+{
+  int numBus = p_network->numBuses();
+  int i, j;
+  // Only owned buses have current reactive injections. Few buses switch at
+  // a time, so only (global index, side) pairs for the switched buses are
+  // exchanged, and every copy of those buses is switched
+  std::vector<int> pairs;
+  for (i=0; i<numBus; i++) {
+    if (!p_network->getActiveBus(i)) continue;
+    int side =
+      dynamic_cast<PFBus*>(p_network->getBus(i).get())->getQlimViolation();
+    if (side != 0) {
+      pairs.push_back(p_network->getGlobalBusIndex(i));
+      pairs.push_back(side);
+    }
+  }
+  std::vector<std::vector<int> > allPairs;
+  boost::mpi::all_gather(p_network->communicator().getCommunicator(),
+      pairs, allPairs);
+  std::map<int, int> side;
+  for (i=0; i<allPairs.size(); i++) {
+    for (j=0; j+1<allPairs[i].size(); j+=2) {
+      side[allPairs[i][j]] = allPairs[i][j+1];
+    }
+  }
+  if (side.empty()) return 0;
+  std::map<int, int>::iterator it;
+  for (i=0; i<numBus; i++) {
+    it = side.find(p_network->getGlobalBusIndex(i));
+    if (it != side.end()) {
+      dynamic_cast<PFBus*>(p_network->getBus(i).get())->setQlim(it->second);
+    }
+  }
+  return side.size();
+}
+
+/**
+ * Restore all buses switched by enforceQlim() to PV buses
+ */
+void gridpack::powerflow::PFFactoryModule::clearQlim()
 {
   int numBus = p_network->numBuses();
   int i;
-  int genIndex=0;
   for (i=0; i<numBus; i++) {
-//    dynamic_cast<PFBus*>(p_network->getBus(i).get())->setParam(name,busID, genID, value);
-    dynamic_cast<PFBus*>(p_network->getBus(i).get())->setParam(GENERATOR_QG,
-        busID, genID, value);
+    dynamic_cast<PFBus*>(p_network->getBus(i).get())->clearQlim();
   }
 }
 
@@ -230,22 +382,7 @@ void gridpack::powerflow::PFFactoryModule::clearLoneBus()
 bool gridpack::powerflow::PFFactoryModule::checkVoltageViolations(
     double Vmin, double Vmax)
 {
-  int numBus = p_network->numBuses();
-  int i;
-  bool bus_ok = true;
-  for (i=0; i<numBus; i++) {
-    if (p_network->getActiveBus(i)) {
-      gridpack::powerflow::PFBus *bus =
-        dynamic_cast<gridpack::powerflow::PFBus*>
-        (p_network->getBus(i).get());
-      //bus->setVoltageLimits(Vmin, Vmax);
-      if (!bus->getIgnore()) {
-        double V = bus->getVoltage();
-        if (V < Vmin || V > Vmax) bus_ok = false;
-      }
-    }
-  }
-  return checkTrue(bus_ok);
+  return checkTrue(p_localVoltageOK(false,0,Vmin,Vmax));
 }
 
 /**
@@ -258,21 +395,7 @@ bool gridpack::powerflow::PFFactoryModule::checkVoltageViolations(
 bool gridpack::powerflow::PFFactoryModule::checkVoltageViolations(
     int area, double Vmin, double Vmax)
 {
-  int numBus = p_network->numBuses();
-  int i;
-  bool bus_ok = true;
-  for (i=0; i<numBus; i++) {
-    if (p_network->getActiveBus(i)) {
-      gridpack::powerflow::PFBus *bus =
-        dynamic_cast<gridpack::powerflow::PFBus*>
-        (p_network->getBus(i).get());
-      if (!bus->getIgnore() && bus->getArea() == area) {
-        double V = bus->getVoltage();
-        if (V < Vmin || V > Vmax) bus_ok = false;
-      }
-    }
-  }
-  return checkTrue(bus_ok);
+  return checkTrue(p_localVoltageOK(true,area,Vmin,Vmax));
 }
 
 /**
@@ -322,42 +445,182 @@ void gridpack::powerflow::PFFactoryModule::clearVoltageViolations()
  */
 bool gridpack::powerflow::PFFactoryModule::checkLineOverloadViolations()
 {
-  int numBranch = p_network->numBranches();
+  return checkTrue(p_localLineOverloadOK(false,0));
+}
+
+/**
+ * Check to see if there are any line overload violations in the
+ * network
+ * @param area only check for voltage violations in this area
+ * @return true if no violations found
+ */
+bool gridpack::powerflow::PFFactoryModule::checkLineOverloadViolations(int area)
+{
+  return checkTrue(p_localLineOverloadOK(true,area));
+}
+
+/**
+ * Check for both voltage and line overload violations using a single
+ * global reduction
+ * @param minV maximum voltage limit
+ * @param maxV maximum voltage limit
+ * @param bus_ok returns true if no voltage violations found
+ * @param branch_ok returns true if no line overload violations found
+ * @return true if no violations of either kind found
+ */
+bool gridpack::powerflow::PFFactoryModule::checkViolations(
+    double Vmin, double Vmax, bool *bus_ok, bool *branch_ok)
+{
+  gridpack::parallel::ReductionBatch batch(p_network->communicator());
+  int h_bus = queueCheckTrue(p_localVoltageOK(false,0,Vmin,Vmax),batch);
+  int h_branch = queueCheckTrue(p_localLineOverloadOK(false,0),batch);
+  batch.flush();
+  bool vok = batch.getBool(h_bus);
+  bool lok = batch.getBool(h_branch);
+  if (bus_ok) *bus_ok = vok;
+  if (branch_ok) *branch_ok = lok;
+  return vok && lok;
+}
+
+/**
+ * Count voltage and line overload violations and find the worst
+ * voltages and line loading. The result is the same on all processors
+ * @param minV maximum voltage limit
+ * @param maxV maximum voltage limit
+ * @return summary of violations
+ */
+gridpack::powerflow::PFViolationSummary
+  gridpack::powerflow::PFFactoryModule::getViolationSummary(double Vmin,
+      double Vmax)
+{
+  PFViolationSummary ret;
+  int nvolt = 0;
+  int nover = 0;
+  double vlo = 1.0e30;
+  double vhi = -1.0e30;
+  double lmax = 0.0;
+  int vloBus = -1;
+  int vhiBus = -1;
+  int lmaxFrom = -1;
+  int lmaxTo = -1;
+  int numBus = p_network->numBuses();
   int i;
-  bool branch_ok = true;
+  for (i=0; i<numBus; i++) {
+    if (p_network->getActiveBus(i)) {
+      gridpack::powerflow::PFBus *bus =
+        dynamic_cast<gridpack::powerflow::PFBus*>
+        (p_network->getBus(i).get());
+      double V = bus->getVoltage();
+      if (!bus->getIgnore() && (V < Vmin || V > Vmax)) nvolt++;
+      if (V < vlo) {
+        vlo = V;
+        vloBus = bus->getOriginalIndex();
+      }
+      if (V > vhi) {
+        vhi = V;
+        vhiBus = bus->getOriginalIndex();
+      }
+    }
+  }
+  int numBranch = p_network->numBranches();
   for (i=0; i<numBranch; i++) {
     if (p_network->getActiveBranch(i)) {
       gridpack::powerflow::PFBranch *branch =
         dynamic_cast<gridpack::powerflow::PFBranch*>
         (p_network->getBranch(i).get());
-      // Loop over all lines in the branch and choose the smallest rating value
       int nlines;
       p_network->getBranchData(i)->getValue(BRANCH_NUM_ELEMENTS,&nlines);
       std::vector<std::string> tags = branch->getLineTags();
       double rateA;
       for (int k = 0; k<nlines; k++) {
-        if (!branch->getIgnore(tags[k])) {
-          if (p_network->getBranchData(i)->getValue(BRANCH_RATING_A,&rateA,k)) {
-            if (rateA > 0.0) {
-              gridpack::ComplexType s = branch->getComplexPower(tags[k]);
-              double pq = abs(s);
-              if (pq > rateA) branch_ok = false;
+        if (p_network->getBranchData(i)->getValue(BRANCH_RATING_A,&rateA,k)) {
+          if (rateA > 0.0) {
+            gridpack::ComplexType s = branch->getComplexPower(tags[k]);
+            double loading = abs(s)/rateA;
+            if (!branch->getIgnore(tags[k]) && loading > 1.0) nover++;
+            if (loading > lmax) {
+              lmax = loading;
+              lmaxFrom = branch->getBus1OriginalIndex();
+              lmaxTo = branch->getBus2OriginalIndex();
             }
           }
         }
       }
     }
   }
-  return checkTrue(branch_ok);
+
+  // Find the extreme values, then the lowest ranked processor that holds
+  // each one supplies the location
+  gridpack::parallel::Communicator comm = p_network->communicator();
+  gridpack::parallel::ReductionBatch batch(comm);
+  int h_nvolt = batch.addSum(nvolt);
+  int h_nover = batch.addSum(nover);
+  int h_vlo = batch.addMin(vlo);
+  int h_vhi = batch.addMax(vhi);
+  int h_lmax = batch.addMax(lmax);
+  batch.flush();
+  ret.nVoltage = batch.getInt(h_nvolt);
+  ret.nOverload = batch.getInt(h_nover);
+  ret.minV = batch.getDouble(h_vlo);
+  ret.maxV = batch.getDouble(h_vhi);
+  ret.maxLoading = batch.getDouble(h_lmax);
+
+  int me = comm.rank();
+  int nprocs = comm.size();
+  int owner[3];
+  owner[0] = (vloBus >= 0 && vlo == ret.minV ? me : nprocs);
+  owner[1] = (vhiBus >= 0 && vhi == ret.maxV ? me : nprocs);
+  owner[2] = (lmaxFrom >= 0 && lmax == ret.maxLoading ? me : nprocs);
+  comm.min(owner,3);
+  int ids[4];
+  ids[0] = (owner[0] == me ? vloBus : 0);
+  ids[1] = (owner[1] == me ? vhiBus : 0);
+  ids[2] = (owner[2] == me ? lmaxFrom : 0);
+  ids[3] = (owner[2] == me ? lmaxTo : 0);
+  comm.sum(ids,4);
+  ret.minVBus = (owner[0] < nprocs ? ids[0] : -1);
+  ret.maxVBus = (owner[1] < nprocs ? ids[1] : -1);
+  ret.maxLoadingFrom = (owner[2] < nprocs ? ids[2] : -1);
+  ret.maxLoadingTo = (owner[2] < nprocs ? ids[3] : -1);
+  return ret;
 }
 
 /**
- * Check to see if there are any line overload violations in the
- * network
- * @param area only check for voltage violations in this area
- * @return true if no violations found
+ * Check for voltage violations on buses owned by this processor
+ * @param useArea only check buses in specified area
+ * @param area area to check
+ * @param minV maximum voltage limit
+ * @param maxV maximum voltage limit
+ * @return true if no violations found on this processor
  */
-bool gridpack::powerflow::PFFactoryModule::checkLineOverloadViolations(int area)
+bool gridpack::powerflow::PFFactoryModule::p_localVoltageOK(bool useArea,
+    int area, double Vmin, double Vmax)
+{
+  int numBus = p_network->numBuses();
+  int i;
+  bool bus_ok = true;
+  for (i=0; i<numBus; i++) {
+    if (p_network->getActiveBus(i)) {
+      gridpack::powerflow::PFBus *bus =
+        dynamic_cast<gridpack::powerflow::PFBus*>
+        (p_network->getBus(i).get());
+      if (!bus->getIgnore() && (!useArea || bus->getArea() == area)) {
+        double V = bus->getVoltage();
+        if (V < Vmin || V > Vmax) bus_ok = false;
+      }
+    }
+  }
+  return bus_ok;
+}
+
+/**
+ * Check for line overload violations on branches owned by this processor
+ * @param useArea only check branches with at least one end in specified area
+ * @param area area to check
+ * @return true if no violations found on this processor
+ */
+bool gridpack::powerflow::PFFactoryModule::p_localLineOverloadOK(
+    bool useArea, int area)
 {
   int numBranch = p_network->numBranches();
   int i;
@@ -367,34 +630,35 @@ bool gridpack::powerflow::PFFactoryModule::checkLineOverloadViolations(int area)
       gridpack::powerflow::PFBranch *branch =
         dynamic_cast<gridpack::powerflow::PFBranch*>
         (p_network->getBranch(i).get());
-      // get buses at either end
-      gridpack::powerflow::PFBus *bus1 =
-        dynamic_cast<gridpack::powerflow::PFBus*>
-        (branch->getBus1().get());
-      gridpack::powerflow::PFBus *bus2 =
-        dynamic_cast<gridpack::powerflow::PFBus*>
-        (branch->getBus2().get());
+      if (useArea) {
+        // get buses at either end
+        gridpack::powerflow::PFBus *bus1 =
+          dynamic_cast<gridpack::powerflow::PFBus*>
+          (branch->getBus1().get());
+        gridpack::powerflow::PFBus *bus2 =
+          dynamic_cast<gridpack::powerflow::PFBus*>
+          (branch->getBus2().get());
+        if (bus1->getArea() != area && bus2->getArea() != area) continue;
+      }
       // Loop over all lines in the branch and choose the smallest rating value
-      if (bus1->getArea() == area || bus2->getArea() == area) {
-        int nlines;
-        p_network->getBranchData(i)->getValue(BRANCH_NUM_ELEMENTS,&nlines);
-        std::vector<std::string> tags = branch->getLineTags();
-        double rateA;
-        for (int k = 0; k<nlines; k++) {
-          if (!branch->getIgnore(tags[k])) {
-            if (p_network->getBranchData(i)->getValue(BRANCH_RATING_A,&rateA,k)) {
-              if (rateA > 0.0) {
-                gridpack::ComplexType s = branch->getComplexPower(tags[k]);
-                double pq = abs(s);
-                if (pq > rateA) branch_ok = false;
-              }
+      int nlines;
+      p_network->getBranchData(i)->getValue(BRANCH_NUM_ELEMENTS,&nlines);
+      std::vector<std::string> tags = branch->getLineTags();
+      double rateA;
+      for (int k = 0; k<nlines; k++) {
+        if (!branch->getIgnore(tags[k])) {
+          if (p_network->getBranchData(i)->getValue(BRANCH_RATING_A,&rateA,k)) {
+            if (rateA > 0.0) {
+              gridpack::ComplexType s = branch->getComplexPower(tags[k]);
+              double pq = abs(s);
+              if (pq > rateA) branch_ok = false;
             }
           }
         }
       }
     }
   }
-  return checkTrue(branch_ok);
+  return branch_ok;
 }
 
 /**
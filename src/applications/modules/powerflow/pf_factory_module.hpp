@@ -28,6 +28,32 @@ namespace powerflow {
 /// The type of network used in the powerflow application
 typedef network::BaseNetwork<PFBus, PFBranch > PFNetwork;
 
+/// A setpoint change that has been resolved to a bus on this processor
+struct PFSetpoint
+{
+  PFBus *bus;        // local bus (owned or ghost)
+  int busID;         // original bus index
+  std::string id;    // generator or load ID
+  std::string field; // GENERATOR_PG, GENERATOR_QG, LOAD_PL or LOAD_QL
+  int index;         // position of the change in the original request
+};
+
+// Summary of the voltages and line loadings in a power flow solution.
+// Buses and line elements flagged to be ignored are not counted as
+// violations, but still contribute to the extreme values
+struct PFViolationSummary
+{
+  int nVoltage;       // buses outside the voltage limits
+  int nOverload;      // line elements above rating A
+  double minV;        // lowest voltage magnitude
+  int minVBus;        // original index of bus with lowest voltage
+  double maxV;        // highest voltage magnitude
+  int maxVBus;        // original index of bus with highest voltage
+  double maxLoading;  // largest ratio of apparent power to rating A
+  int maxLoadingFrom; // original indices of buses at either end of the
+  int maxLoadingTo;   // most heavily loaded branch
+};
+
 class PFFactoryModule
   : public gridpack::factory::BaseFactory<PFNetwork> {
   public:
@@ -63,6 +89,45 @@ class PFFactoryModule
     void updatePg(int busID, std::string genID, double value);
     void updateQg(int busID, std::string genID, double value);
 
+    /**
+     * Find the local buses that a list of setpoint changes apply to. Changes
+     * on buses that are not on this processor are dropped, and changes on
+     * buses that appear more than once (ghosts) are kept for each copy. The
+     * result can be passed to applySetpoints() any number of times as long
+     * as the network is not repartitioned
+     * @param busIDs original index of the bus for each change
+     * @param ids generator (or load) ID for each change
+     * @param fields parameter for each change (GENERATOR_PG, GENERATOR_QG,
+     *        LOAD_PL or LOAD_QL)
+     * @param setpoints changes that apply to buses on this processor
+     */
+    void resolveSetpoints(const std::vector<int> &busIDs,
+        const std::vector<std::string> &ids,
+        const std::vector<std::string> &fields,
+        std::vector<PFSetpoint> &setpoints);
+
+    /**
+     * Apply values to a list of resolved setpoints in one pass
+     * @param setpoints list returned by resolveSetpoints()
+     * @param values new values, in the order of the original request
+     */
+    void applySetpoints(const std::vector<PFSetpoint> &setpoints,
+        const std::vector<double> &values);
+
+    /**
+     * Resolve and apply a list of setpoint changes. Every processor can pass
+     * the same list; each one only touches its own buses
+     * @param busIDs original index of the bus for each change
+     * @param ids generator (or load) ID for each change
+     * @param fields parameter for each change (GENERATOR_PG, GENERATOR_QG,
+     *        LOAD_PL or LOAD_QL)
+     * @param values new value for each change
+     */
+    void updateSetpoints(const std::vector<int> &busIDs,
+        const std::vector<std::string> &ids,
+        const std::vector<std::string> &fields,
+        const std::vector<double> &values);
+
     /**
      * Create the PQ 
      */
@@ -116,6 +181,27 @@ class PFFactoryModule
     bool checkLineOverloadViolations();
     bool checkLineOverloadViolations(int area);
 
+    /**
+     * Check for both voltage and line overload violations using a single
+     * global reduction
+     * @param minV maximum voltage limit
+     * @param maxV maximum voltage limit
+     * @param bus_ok returns true if no voltage violations found
+     * @param branch_ok returns true if no line overload violations found
+     * @return true if no violations of either kind found
+     */
+    bool checkViolations(double Vmin, double Vmax, bool *bus_ok = NULL,
+        bool *branch_ok = NULL);
+
+    /**
+     * Count voltage and line overload violations and find the worst
+     * voltages and line loading. The result is the same on all processors
+     * @param minV maximum voltage limit
+     * @param maxV maximum voltage limit
+     * @return summary of violations
+     */
+    PFViolationSummary getViolationSummary(double Vmin, double Vmax);
+
     /**
      * Set "ignore" paramter on all lines with violations so that subsequent
      * checks are not counted as violations
@@ -131,8 +217,48 @@ class PFFactoryModule
      * Reinitialize voltages
      */
     void resetVoltages();
+
+    /**
+     * Use the same two row block layout for every bus in the Jacobian, RHS
+     * and State modes, so that buses can switch between PV and PQ without
+     * changing the size of the Jacobian
+     * @param flag true if fixed layout is used
+     */
+    void setFixedLayout(bool flag);
+
+    /**
+     * Switch PV buses that violate the reactive power limits of their
+     * generators to PQ buses, with generation held at the limit. Reactive
+     * injections from the last evaluation of the RHS vector are used. Ghost
+     * copies of switched buses are switched as well
+     * @return number of buses switched on all processors
+     */
+    int enforceQlim();
+
+    /**
+     * Restore all buses switched by enforceQlim() to PV buses
+     */
+    void clearQlim();
   private:
 
+    /**
+     * Check for voltage violations on buses owned by this processor
+     * @param useArea only check buses in specified area
+     * @param area area to check
+     * @param minV maximum voltage limit
+     * @param maxV maximum voltage limit
+     * @return true if no violations found on this processor
+     */
+    bool p_localVoltageOK(bool useArea, int area, double Vmin, double Vmax);
+
+    /**
+     * Check for line overload violations on branches owned by this processor
+     * @param useArea only check branches with at least one end in area
+     * @param area area to check
+     * @return true if no violations found on this processor
+     */
+    bool p_localLineOverloadOK(bool useArea, int area);
+
     NetworkPtr p_network;
     std::vector<bool> p_saveIsolatedStatus;
 };
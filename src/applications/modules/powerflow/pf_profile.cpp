@@ -0,0 +1,172 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   pf_profile.cpp
+ *
+ * @brief  Reader for load and generation profiles used by time series
+ *         power flow
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#include <cstdlib>
+#include "gridpack/utilities/string_utils.hpp"
+#include "pf_profile.hpp"
+
+namespace gridpack {
+namespace powerflow {
+
+/**
+ * Basic constructor
+ */
+PFProfile::PFProfile(void)
+  : p_binary(false)
+{
+}
+
+/**
+ * Basic destructor
+ */
+PFProfile::~PFProfile(void)
+{
+  close();
+}
+
+/**
+ * Open a profile and read the column descriptions
+ * @param filename name of profile file
+ * @param binary true if file is in binary format, otherwise CSV
+ * @return false if the file could not be opened or the header could not be
+ *         parsed
+ */
+bool PFProfile::open(const std::string &filename, bool binary)
+{
+  close();
+  p_binary = binary;
+  p_columns.clear();
+  if (binary) {
+    p_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+  } else {
+    p_file.open(filename.c_str(), std::ios::in);
+  }
+  if (!p_file.is_open()) return false;
+
+  int i;
+  if (binary) {
+    int ncols;
+    if (!p_file.read(reinterpret_cast<char*>(&ncols), sizeof(int))) {
+      return false;
+    }
+    char buf[33];
+    buf[32] = '\0';
+    for (i=0; i<ncols; i++) {
+      if (!p_file.read(buf, 32)) return false;
+      Column column;
+      if (!parseColumn(std::string(buf), column)) return false;
+      p_columns.push_back(column);
+    }
+  } else {
+    std::string line;
+    if (!std::getline(p_file, line)) return false;
+    gridpack::utility::StringUtils util;
+    std::vector<std::string> tokens = util.charTokenizer(line, ",");
+    for (i=1; i<tokens.size(); i++) {
+      Column column;
+      if (!parseColumn(tokens[i], column)) return false;
+      p_columns.push_back(column);
+    }
+  }
+  return true;
+}
+
+/**
+ * Close profile
+ */
+void PFProfile::close(void)
+{
+  if (p_file.is_open()) p_file.close();
+}
+
+/**
+ * Get column descriptions
+ * @return list of columns, in file order
+ */
+const std::vector<PFProfile::Column>& PFProfile::columns(void) const
+{
+  return p_columns;
+}
+
+/**
+ * Read the next time point
+ * @param time time of this row
+ * @param values one value for each column
+ * @return false if there are no more complete rows
+ */
+bool PFProfile::next(double *time, std::vector<double> &values)
+{
+  if (!p_file.is_open()) return false;
+  int ncols = p_columns.size();
+  values.resize(ncols);
+  if (p_binary) {
+    if (!p_file.read(reinterpret_cast<char*>(time), sizeof(double))) {
+      return false;
+    }
+    if (ncols > 0 && !p_file.read(reinterpret_cast<char*>(&values[0]),
+          ncols*sizeof(double))) {
+      return false;
+    }
+    return true;
+  }
+  std::string line;
+  gridpack::utility::StringUtils util;
+  while (std::getline(p_file, line)) {
+    util.trim(line);
+    // skip blank lines
+    if (line.length() == 0) continue;
+    std::vector<std::string> tokens = util.charTokenizer(line, ",");
+    if (tokens.size() < ncols+1) return false;
+    *time = atof(tokens[0].c_str());
+    int i;
+    for (i=0; i<ncols; i++) values[i] = atof(tokens[i+1].c_str());
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Parse a column identifier
+ * @param token string of the form FIELD:BUS:ID
+ * @param column parsed column description
+ * @return false if token could not be parsed
+ */
+bool PFProfile::parseColumn(std::string token, Column &column)
+{
+  gridpack::utility::StringUtils util;
+  util.trim(token);
+  std::vector<std::string> parts = util.charTokenizer(token, ":");
+  if (parts.size() != 3) return false;
+  util.trim(parts[0]);
+  if (parts[0] == "PG") {
+    column.field = PG;
+  } else if (parts[0] == "QG") {
+    column.field = QG;
+  } else if (parts[0] == "PL") {
+    column.field = PL;
+  } else if (parts[0] == "QL") {
+    column.field = QL;
+  } else {
+    return false;
+  }
+  column.busID = atoi(parts[1].c_str());
+  // IDs follow the same conventions as the network parsers
+  column.id = util.clean2Char(parts[2]);
+  return true;
+}
+
+} // powerflow
+} // gridpack
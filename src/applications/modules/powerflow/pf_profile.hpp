@@ -0,0 +1,119 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   pf_profile.hpp
+ *
+ * @brief  Reader for load and generation profiles used by time series
+ *         power flow
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _pf_profile_h_
+#define _pf_profile_h_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace gridpack {
+namespace powerflow {
+
+// -------------------------------------------------------------
+//  class PFProfile
+// -------------------------------------------------------------
+/**
+ * A profile is a table with one row per time point and one column per
+ * setpoint. Each column is identified by a field (PG, QG, PL or QL), a bus
+ * number and a generator or load ID, written as FIELD:BUS:ID, e.g.
+ * PL:9:1. Values are in MW or MVAR.
+ *
+ * In CSV format the first line is a header whose first entry is ignored
+ * (it labels the time column) and whose remaining entries are the column
+ * identifiers. Each following line is a time followed by one value for
+ * each column.
+ *
+ * In binary format the file starts with the number of columns as a 32 bit
+ * integer, followed by the column identifiers as 32 character, blank padded
+ * strings. Each record is then the time and the column values as doubles.
+ *
+ * Rows are read one at a time, so profiles do not have to fit in memory.
+ */
+class PFProfile
+{
+  public:
+
+    /// Setpoint a column applies to
+    enum Field {PG, QG, PL, QL};
+
+    /// Description of a profile column
+    struct Column
+    {
+      Field field;
+      int busID;
+      std::string id;
+    };
+
+    /**
+     * Basic constructor
+     */
+    PFProfile(void);
+
+    /**
+     * Basic destructor
+     */
+    ~PFProfile(void);
+
+    /**
+     * Open a profile and read the column descriptions
+     * @param filename name of profile file
+     * @param binary true if file is in binary format, otherwise CSV
+     * @return false if the file could not be opened or the header could not
+     *         be parsed
+     */
+    bool open(const std::string &filename, bool binary);
+
+    /**
+     * Close profile
+     */
+    void close(void);
+
+    /**
+     * Get column descriptions
+     * @return list of columns, in file order
+     */
+    const std::vector<Column>& columns(void) const;
+
+    /**
+     * Read the next time point
+     * @param time time of this row
+     * @param values one value for each column
+     * @return false if there are no more complete rows
+     */
+    bool next(double *time, std::vector<double> &values);
+
+  private:
+
+    /**
+     * Parse a column identifier
+     * @param token string of the form FIELD:BUS:ID
+     * @param column parsed column description
+     * @return false if token could not be parsed
+     */
+    bool parseColumn(std::string token, Column &column);
+
+    std::ifstream p_file;
+
+    bool p_binary;
+
+    std::vector<Column> p_columns;
+};
+
+} // powerflow
+} // gridpack
+#endif
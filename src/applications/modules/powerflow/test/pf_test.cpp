@@ -13,19 +13,137 @@
  */
 // -------------------------------------------------------------
 
+#include <cmath>
+#include <algorithm>
 #include "mpi.h"
 #include <ga.h>
 #include <macdecls.h>
 #include "gridpack/include/gridpack.hpp"
 #include "pf_app_module.hpp"
+#include "dc_pf_module.hpp"
 
 // Calling program for the contingency_analysis applications
 
+/**
+ * Compare post-outage DC flows predicted by line outage distribution
+ * factors, and by a low rank update solve right after refactoring the base
+ * case, with flows from a DC power flow on the network with the outage
+ * applied
+ * @return maximum difference
+ */
+double
+checkLODF(boost::shared_ptr<gridpack::powerflow::PFNetwork> network,
+    gridpack::powerflow::PFAppModule &pf_app,
+    gridpack::utility::Configuration::CursorPtr cursor)
+{
+  gridpack::parallel::Communicator world = network->communicator();
+  gridpack::powerflow::DCPFModule dc(network, cursor);
+  dc.solve();
+
+  int from[] = {1, 1, 2, 2, 2, 3, 4, 4, 4, 5};
+  int to[] = {2, 5, 3, 4, 5, 4, 5, 7, 9, 6};
+  std::vector<gridpack::powerflow::pathBranch> monitored(10);
+  int i;
+  for (i=0; i<10; i++) {
+    monitored[i].fromBus = from[i];
+    monitored[i].toBus = to[i];
+    monitored[i].branchID = "BL";
+  }
+  // Outage of line 2-3
+  std::vector<gridpack::powerflow::pathBranch> outages(1, monitored[2]);
+  std::vector<double> f0 = dc.getFlows(monitored);
+  boost::shared_ptr<gridpack::math::RealMatrix> lodf =
+    dc.getLODF(monitored, outages);
+
+  gridpack::powerflow::Contingency event;
+  event.p_type = gridpack::powerflow::Branch;
+  event.p_name = "DC_LODF_check";
+  event.p_from.push_back(outages[0].fromBus);
+  event.p_to.push_back(outages[0].toBus);
+  event.p_ckt.push_back(outages[0].branchID);
+  event.p_saveLineStatus.push_back(true);
+  pf_app.setContingency(event);
+  dc.factor();
+  dc.solve();
+  std::vector<double> f1 = dc.getFlows(monitored);
+  pf_app.unSetContingency(event);
+
+  // Refactor the base case and go straight to the outage solve, which must
+  // not use the solution from the B matrix with the outage applied
+  double uerr = 0.0;
+  dc.factor();
+  if (dc.solveOutage(outages, false)) {
+    std::vector<double> f2 = dc.getFlows(monitored);
+    for (i=0; i<10; i++) {
+      if (i == 2) continue;
+      double diff = std::abs(f2[i] - f1[i]);
+      if (diff > uerr) uerr = diff;
+    }
+  } else {
+    uerr = 1.0;
+  }
+
+  double err = 0.0;
+  int lo, hi;
+  lodf->localRowRange(lo, hi);
+  for (i=lo; i<hi; i++) {
+    double l;
+    lodf->getElement(i, 0, l);
+    double diff = std::abs(f0[i] + l*f0[2] - f1[i]);
+    if (diff > err) err = diff;
+  }
+  world.max(&err, 1);
+  if (world.rank() == 0) {
+    printf("\nMaximum error in LODF predicted DC flows: %e\n", err);
+    printf("Maximum error in outage DC flows after refactoring: %e\n", uerr);
+  }
+  return std::max(err, uerr);
+}
+
+/**
+ * Set up the power flow components again, first with a new factory and then
+ * by reloading, and check that the topology index maps stored on the network
+ * by the first initialization are reused unchanged
+ * @return number of buses with a different MatVec index
+ */
+int
+checkReinitialize(boost::shared_ptr<gridpack::powerflow::PFNetwork> network,
+    gridpack::powerflow::PFAppModule &pf_app)
+{
+  gridpack::parallel::Communicator world = network->communicator();
+  int nbus = network->numBuses();
+  int i, idx;
+  std::vector<int> cached;
+  int nerr = 0;
+  if (!network->getBusMatVecIndices(cached)) nerr++;
+  std::vector<int> before(nbus);
+  for (i=0; i<nbus; i++) network->getBus(i)->getMatVecIndex(&before[i]);
+
+  pf_app.initialize();
+  for (i=0; i<nbus; i++) {
+    network->getBus(i)->getMatVecIndex(&idx);
+    if (idx != before[i]) nerr++;
+  }
+  pf_app.reload();
+  std::vector<int> after;
+  if (!network->getBusMatVecIndices(after) || after != cached) nerr++;
+  for (i=0; i<nbus; i++) {
+    network->getBus(i)->getMatVecIndex(&idx);
+    if (idx != before[i]) nerr++;
+  }
+  world.sum(&nerr, 1);
+  if (world.rank() == 0) {
+    printf("\nMismatched bus indices after reinitialization: %d\n", nerr);
+  }
+  return nerr;
+}
+
 int
 main(int argc, char **argv)
 {
   gridpack::parallel::Environment env(argc,argv);
   gridpack::math::Initialize();
+  int ret = 0;
 
   if (1) {
     gridpack::parallel::Communicator world;
@@ -53,10 +171,24 @@ main(int argc, char **argv)
     gridpack::powerflow::PFAppModule pf_app;
     pf_app.readNetwork(pf_network,config);
     pf_app.initialize();
-    if (useNonLinear) {
+    bool useDC = false;
+    useDC = cursor->get("DCPowerflow", useDC);
+    if (useDC) {
+      if (checkLODF(pf_network, pf_app, cursor) > 1.0e-8) ret = 1;
+    }
+    bool reinit = false;
+    reinit = cursor->get("Reinitialize", reinit);
+    if (reinit) {
+      if (checkReinitialize(pf_network, pf_app) > 0) ret = 1;
+    }
+    if (config->getCursor("Configuration.Powerflow.TimeSeries")) {
+      if (pf_app.solveTimeSeries() > 0) ret = 1;
+    } else if (config->getCursor("Configuration.Powerflow.Ensemble")) {
+      if (pf_app.solveEnsemble() > 0) ret = 1;
+    } else if (useNonLinear) {
       pf_app.nl_solve();
     } else {
-      pf_app.solve();
+      if (!pf_app.solve()) ret = 1;
     }
     pf_app.write();
     pf_app.saveData();
@@ -64,6 +196,6 @@ main(int argc, char **argv)
 
   // Terminate Math libraries
   gridpack::math::Finalize();
-  return 0;
+  return ret;
 }
 
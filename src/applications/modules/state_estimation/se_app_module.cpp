@@ -279,6 +279,10 @@ void gridpack::state_estimation::SEAppModule::solve(void)
   p_factory->setMode(R_inv);
   gridpack::mapper::GenMatrixMap<SENetwork> RinvMap(p_network);
   boost::shared_ptr<gridpack::math::Matrix> Rinv = RinvMap.mapToMatrix();
+  // Rinv is diagonal; stored that way, products with it are just scaling
+  if (Rinv->localRows() == Rinv->localCols()) {
+    Rinv.reset(gridpack::math::storageType(*Rinv, gridpack::math::Diagonal));
+  }
 //  Rinv->print();
 
   // Start N-R loop
@@ -308,8 +312,8 @@ void gridpack::state_estimation::SEAppModule::solve(void)
 //  Gain->print();
 //  printf("Got to H'*Rinv\n");
 
-    // Form right hand side vector
-    boost::shared_ptr<gridpack::math::Matrix> HTR(multiply(*trans_HJac, *Rinv));
+    // Form right hand side vector (H'*Rinv is already available)
+    boost::shared_ptr<gridpack::math::Matrix> HTR(Gain1);
 //  HTR->print();
 //  printf("Got to RHS\n");
 
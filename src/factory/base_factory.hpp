@@ -22,6 +22,7 @@
 #include "boost/smart_ptr/shared_ptr.hpp"
 #include "gridpack/timer/coarse_timer.hpp"
 #include "gridpack/network/base_network.hpp"
+#include "gridpack/parallel/reduction_batch.hpp"
 #include "gridpack/component/base_component.hpp"
 
 // Base factory class that contains functions that are generic to all
@@ -70,7 +71,11 @@ class BaseFactory {
      * Set pointers in each bus and branch component so that it points to
      * connected buses and branches. This routine operates on the generic
      * BaseBusComponent and BaseBranchComponent interfaces. It also sets some
-     * indices in MatVecInterface for each component.
+     * indices in MatVecInterface for each component. The index maps that
+     * depend only on the network topology are evaluated the first time this
+     * function is called on a network and stored on the network, so
+     * subsequent calls (e.g. after reloading data or from a new factory on
+     * the same network) only need to relink the components.
      */
     virtual void setComponents(void)
     {
@@ -79,166 +84,172 @@ class BaseFactory {
       timer->configTimer(p_profile);
       int t_setc = timer->createCategory("Factory:setComponents");
       timer->start(t_setc);
+      // All processors must agree on whether the topology is recomputed,
+      // since this is collective
+      int cached = p_network->getBusMatVecIndices(p_busMatVecIndex) ? 1 : 0;
+      p_network->communicator().min(&cached,1);
+      if (!cached) {
+        int t_topo = timer->createCategory("Factory:setComponents:topology");
+        timer->start(t_topo);
+        setTopology();
+        timer->stop(t_topo);
+      }
+      relinkComponents();
+      timer->stop(t_setc);
+      timer->configTimer(true);
+    }
+
+    /**
+     * Evaluate the MatVec indices of all local buses (active and ghost). The
+     * indices are chosen so that the active buses are consecutively numbered
+     * on each processor. Ghost buses get their index from the processor that
+     * owns them. The result is stored on the network and reused by
+     * relinkComponents. This operation is collective.
+     */
+    void setTopology(void)
+    {
+      int i;
+      MPI_Comm comm = static_cast<MPI_Comm>(p_network->communicator());
+      int nprocs = p_network->communicator().size();
+      int me = p_network->communicator().rank();
+
+      // Find offset for active buses on this processor and total number of
+      // active buses
+      int numActiveBus = 0;
+      for (i=0; i<p_numBuses; i++) {
+        if (p_network->getActiveBus(i)) numActiveBus++;
+      }
+      int offset = 0;
+      MPI_Exscan(&numActiveBus,&offset,1,MPI_INT,MPI_SUM,comm);
+      if (me == 0) offset = 0;
+      int ntot = 0;
+      MPI_Allreduce(&numActiveBus,&ntot,1,MPI_INT,MPI_SUM,comm);
+
+      // Global bus indices lie in [0,ntot). Distribute this range in
+      // contiguous blocks so that each index has a home processor that
+      // stores its MatVec index
+      int blk = (ntot+nprocs-1)/nprocs;
+      if (blk == 0) blk = 1;
+      int homeLo = me*blk;
+      int homeSize = ntot - homeLo;
+      if (homeSize > blk) homeSize = blk;
+      if (homeSize < 0) homeSize = 0;
+
+      // Assign MatVec indices to active buses and send the (global index,
+      // MatVec index) pairs to their home processors
+      p_busMatVecIndex.assign(p_numBuses,-1);
+      std::vector<int> keys, values, dest;
+      int icnt = 0;
+      for (i=0; i<p_numBuses; i++) {
+        if (p_network->getActiveBus(i)) {
+          p_busMatVecIndex[i] = offset+icnt;
+          keys.push_back(p_network->getGlobalBusIndex(i));
+          values.push_back(offset+icnt);
+          icnt++;
+        }
+      }
+      std::vector<int> sendbuf, recvbuf, recvcnt;
+      p_packByHome(keys,values,blk,nprocs,sendbuf,dest);
+      p_exchange(comm,nprocs,sendbuf,dest,recvbuf,recvcnt);
+      std::vector<int> home(homeSize,-1);
+      int nrecv = recvbuf.size()/2;
+      for (i=0; i<nrecv; i++) {
+        home[recvbuf[2*i]-homeLo] = recvbuf[2*i+1];
+      }
+
+      // Query home processors for the MatVec indices of the ghost buses
+      keys.clear();
+      values.clear();
+      std::vector<int> ghosts;
+      for (i=0; i<p_numBuses; i++) {
+        if (!p_network->getActiveBus(i)) {
+          keys.push_back(p_network->getGlobalBusIndex(i));
+          values.push_back(static_cast<int>(ghosts.size()));
+          ghosts.push_back(i);
+        }
+      }
+      p_packByHome(keys,values,blk,nprocs,sendbuf,dest);
+      p_exchange(comm,nprocs,sendbuf,dest,recvbuf,recvcnt);
+
+      // Answer the queries and return them to the processors that asked.
+      // Replies go back in the same order and to the same processors that the
+      // requests came from, so the receive counts become the send counts.
+      nrecv = recvbuf.size()/2;
+      for (i=0; i<nrecv; i++) {
+        recvbuf[2*i] = home[recvbuf[2*i]-homeLo];
+      }
+      std::vector<int> replybuf, replycnt;
+      p_exchange(comm,nprocs,recvbuf,recvcnt,replybuf,replycnt);
+      int nreply = replybuf.size()/2;
+      for (i=0; i<nreply; i++) {
+        p_busMatVecIndex[ghosts[replybuf[2*i+1]]] = replybuf[2*i];
+      }
+      p_network->setBusMatVecIndices(p_busMatVecIndex);
+    }
+
+    /**
+     * Discard the cached index maps so that they are recomputed on the next
+     * call to setComponents. The network discards them itself if buses are
+     * added or change their active status, so this is only needed if the
+     * topology has been modified in some other way.
+     */
+    void resetTopology(void)
+    {
+      p_network->clearBusMatVecIndices();
+    }
+
+    /**
+     * Set neighbor pointers and indices on all buses and branches using the
+     * cached index maps. This is purely local and does not require any
+     * communication. The topology must already have been set by setTopology.
+     */
+    void relinkComponents(void)
+    {
       int i, j;
       int idx1, idx2;
 
       // Set pointers for buses at either end of each branch
-      int numActiveBranch = 0;
       for (i=0; i<p_numBranches; i++) {
-        int branch_idx, bus1_idx, bus2_idx;
         p_network->getBranchEndpoints(i, &idx1, &idx2);
-        p_network->getBranch(i)->setBus1(p_network->getBus(idx1));
-        p_network->getBranch(i)->setBus2(p_network->getBus(idx2));
-        branch_idx = p_network->getGlobalBranchIndex(i); 
-        bus1_idx = p_network->getGlobalBusIndex(idx1); 
-        bus2_idx = p_network->getGlobalBusIndex(idx2); 
-        p_network->getBranch(i)->setMatVecIndices(bus1_idx, bus2_idx); 
-        if (p_network->getActiveBranch(i)) numActiveBranch++;
+        gridpack::component::BaseBranchComponent *branch = p_branches[i];
+        branch->setBus1(p_network->getBus(idx1));
+        branch->setBus2(p_network->getBus(idx2));
+        branch->setMatVecIndices(p_busMatVecIndex[idx1],
+            p_busMatVecIndex[idx2]);
+        branch->setBus1OriginalIndex(p_network->getOriginalBusIndex(idx1));
+        branch->setBus2OriginalIndex(p_network->getOriginalBusIndex(idx2));
+        branch->setBus1GlobalIndex(p_network->getGlobalBusIndex(idx1));
+        branch->setBus2GlobalIndex(p_network->getGlobalBusIndex(idx2));
       }
 
       // Set pointers for branches and buses connected to each bus
-      int numActiveBus = 0;
       for (i=0; i<p_numBuses; i++) {
-        p_network->getBus(i)->clearBuses();
+        gridpack::component::BaseBusComponent *bus = p_buses[i];
+        bus->clearBuses();
         std::vector<int> nghbrBus = p_network->getConnectedBuses(i);
         for (j=0; j<nghbrBus.size(); j++) {
-          p_network->getBus(i)->addBus(p_network->getBus(nghbrBus[j]));
+          bus->addBus(p_network->getBus(nghbrBus[j]));
         }
-        p_network->getBus(i)->clearBranches();
+        bus->clearBranches();
         std::vector<int> nghbrBranch = p_network->getConnectedBranches(i);
         for (j=0; j<nghbrBranch.size(); j++) {
-          p_network->getBus(i)->addBranch(p_network->getBranch(nghbrBranch[j]));
+          bus->addBranch(p_network->getBranch(nghbrBranch[j]));
         }
-        int bus_idx;
-        bus_idx = p_network->getGlobalBusIndex(i); 
-        p_network->getBus(i)->setMatVecIndex(bus_idx);
-        if (p_network->getActiveBus(i)) numActiveBus++;
+        bus->setMatVecIndex(p_busMatVecIndex[i]);
+        bus->setOriginalIndex(p_network->getOriginalBusIndex(i));
+        bus->setGlobalIndex(p_network->getGlobalBusIndex(i));
       }
-      
+
       // Set reference bus
       int idx = p_network->getReferenceBus();
       if (idx != -1) {
         p_network->getBus(idx)->setReferenceBus(true);
       }
 
-      // Set bus and branch indices
-      for (i=0; i<p_numBuses; i++) {
-        p_network->getBus(i)->setOriginalIndex(p_network->getOriginalBusIndex(i));
-        p_network->getBus(i)->setGlobalIndex(p_network->getGlobalBusIndex(i));
-      }
-      for (i=0; i<p_numBranches; i++) {
-        gridpack::component::BaseBusComponent *bus1 =
-          dynamic_cast<gridpack::component::BaseBusComponent*>
-          (p_network->getBranch(i)->getBus1().get());
-        gridpack::component::BaseBusComponent *bus2 =
-          dynamic_cast<gridpack::component::BaseBusComponent*>
-          (p_network->getBranch(i)->getBus2().get());
-        p_network->getBranch(i)->setBus1OriginalIndex(
-            bus1->getOriginalIndex());
-        p_network->getBranch(i)->setBus2OriginalIndex(
-            bus2->getOriginalIndex());
-        p_network->getBranch(i)->setBus1GlobalIndex(
-            bus1->getGlobalIndex());
-        p_network->getBranch(i)->setBus2GlobalIndex(
-            bus2->getGlobalIndex());
-      }
-
-      // Come up with a set of global indices for each component so that the buses
-      // and branches are consecutively numbered on each component and the indices
-      // for all active components are unique. These are used in the mapper routine.
-      // First get the number of active buses and branches on each process and
-      // broadcast this to all other processes.
-      int grp = p_network->communicator().getGroup();
-      int nprocs = GA_Pgroup_nnodes(grp);
-      int me = GA_Pgroup_nodeid(grp);
-      int *activeBus = new int[nprocs];
-      int *activeBranch = new int[nprocs];
-
-      for (i=0; i<nprocs; i++) {
-        activeBus[i] = 0;
-        activeBranch[i] = 0;
-      }
-
-      activeBus[me] = numActiveBus;
-      activeBranch[me] = numActiveBranch;
-      char cplus[2];
-      strcpy(cplus,"+");
-      GA_Pgroup_igop(grp,activeBus,nprocs,cplus);
-      GA_Pgroup_igop(grp,activeBranch,nprocs,cplus);
-
-      // Create indices for buses. Start by creating a global array with an entry
-      // for each bus
-      int one = 1;
-      int ntot = 0;
-      int offset = 0;
-      for (i=0; i<nprocs; i++) {
-        ntot += activeBus[i];
-        if (i<me) offset += activeBus[i];
-      }
-      int g_bus = GA_Create_handle();
-      GA_Set_data(g_bus, one, &ntot, C_INT);
-      GA_Set_pgroup(g_bus, grp);
-      if (!GA_Allocate(g_bus)) {
-        char buf[256];
-        sprintf(buf,"BaseFactory::setComponents: Unable to allocate distributed array for indices");
-        printf(buf);
-        throw gridpack::Exception(buf);
-      }
-      GA_Zero(g_bus);
-
-      // Scatter new index values into the global index locations for the buses
-      int *ibus_val = new int[numActiveBus];
-      int **ibus_idx = new int*[numActiveBus];
-      int icnt = 0;
-      for (i=0; i<p_numBuses; i++) {
-        if (p_network->getActiveBus(i)) {
-          ibus_idx[icnt] = new int;
-          *(ibus_idx[icnt]) = p_network->getGlobalBusIndex(i);
-          ibus_val[icnt] = offset+icnt;
-          icnt++;
-        }
-      }
-      NGA_Scatter(g_bus,ibus_val,ibus_idx,numActiveBus);
-      GA_Pgroup_sync(grp);
-      for (i=0; i<numActiveBus; i++) {
-        delete ibus_idx[i];
-      }
-      delete [] ibus_idx;
-      delete [] ibus_val;
-
-      // Now gather values for both active and inactive buses
-      ibus_val = new int[p_numBuses];
-      ibus_idx = new int*[p_numBuses];
-      for (i=0; i<p_numBuses; i++) {
-        ibus_idx[i] = new int;
-        *(ibus_idx[i]) = p_network->getGlobalBusIndex(i);
-      }
-      NGA_Gather(g_bus,ibus_val,ibus_idx,p_numBuses);
-      // Assign the MatVecIndex for the bus and clean up arrays
-      for (i=0; i<p_numBuses; i++) {
-        p_network->getBus(i)->setMatVecIndex(ibus_val[i]);
-        delete ibus_idx[i];
-      }
-      delete [] ibus_idx;
-      delete [] ibus_val;
-      delete [] activeBus;
-      delete [] activeBranch;
-      GA_Destroy(g_bus);
-
-      // Finish by assigning MatVecIndices for the branches
-      for (i=0; i<p_numBranches; i++) {
-        p_network->getBranch(i)->getBus1()->getMatVecIndex(&idx1);
-        p_network->getBranch(i)->getBus2()->getMatVecIndex(&idx2);
-        p_network->getBranch(i)->setMatVecIndices(idx1,idx2);
-      }
-      
       // Set internal maps
       p_network->setMap();
-      timer->stop(t_setc);
-      timer->configTimer(true);
     }
 
-
     /**
      * Generic method that invokes the "load" method on all branches and buses
      * to move data from the DataCollection objects on the network into the
@@ -448,6 +459,31 @@ class BaseFactory {
       }
     }
 
+    /**
+     * Queue a check to see if something is true on all processors. The
+     * result is available from the batch after it has been flushed, so
+     * several checks can be evaluated with a single collective operation
+     * @param flag boolean flag on each processor
+     * @param batch reduction batch that evaluates the check
+     * @return handle of result in batch
+     */
+    int queueCheckTrue(bool flag, gridpack::parallel::ReductionBatch &batch)
+    {
+      return batch.addAllTrue(flag);
+    }
+
+    /**
+     * Queue a check to see if something is true on at least one processor
+     * @param flag boolean flag on each processor
+     * @param batch reduction batch that evaluates the check
+     * @return handle of result in batch
+     */
+    int queueCheckTrueSomewhere(bool flag,
+        gridpack::parallel::ReductionBatch &batch)
+    {
+      return batch.addAnyTrue(flag);
+    }
+
     /**
      * Save internal state variables of the buses and branches to the
      * associated data collection object for possible use in output or to
@@ -522,6 +558,72 @@ class BaseFactory {
       }
     }
 
+  private:
+
+    /**
+     * Sort key-value pairs into a single buffer ordered by the home processor
+     * of each key. Keys are distributed in contiguous blocks of size blk.
+     * @param keys list of global indices
+     * @param values list of values associated with keys
+     * @param blk block size of global index distribution
+     * @param nprocs number of processors
+     * @param sendbuf returned buffer of interleaved key-value pairs
+     * @param count returned number of integers going to each processor
+     */
+    void p_packByHome(const std::vector<int> &keys,
+        const std::vector<int> &values, int blk, int nprocs,
+        std::vector<int> &sendbuf, std::vector<int> &count)
+    {
+      int i;
+      int nkeys = keys.size();
+      count.assign(nprocs,0);
+      for (i=0; i<nkeys; i++) {
+        count[keys[i]/blk] += 2;
+      }
+      std::vector<int> offset(nprocs,0);
+      for (i=1; i<nprocs; i++) {
+        offset[i] = offset[i-1]+count[i-1];
+      }
+      sendbuf.resize(2*nkeys);
+      for (i=0; i<nkeys; i++) {
+        int &ptr = offset[keys[i]/blk];
+        sendbuf[ptr] = keys[i];
+        sendbuf[ptr+1] = values[i];
+        ptr += 2;
+      }
+    }
+
+    /**
+     * Exchange integer data between all processors
+     * @param comm MPI communicator
+     * @param nprocs number of processors in comm
+     * @param sendbuf data ordered by destination processor
+     * @param sendcnt number of integers going to each processor
+     * @param recvbuf returned data ordered by source processor
+     * @param recvcnt returned number of integers from each processor
+     */
+    void p_exchange(MPI_Comm comm, int nprocs, std::vector<int> &sendbuf,
+        std::vector<int> &sendcnt, std::vector<int> &recvbuf,
+        std::vector<int> &recvcnt)
+    {
+      int i;
+      recvcnt.assign(nprocs,0);
+      MPI_Alltoall(&sendcnt[0],1,MPI_INT,&recvcnt[0],1,MPI_INT,comm);
+      std::vector<int> sdispl(nprocs,0), rdispl(nprocs,0);
+      for (i=1; i<nprocs; i++) {
+        sdispl[i] = sdispl[i-1]+sendcnt[i-1];
+        rdispl[i] = rdispl[i-1]+recvcnt[i-1];
+      }
+      int rsize = rdispl[nprocs-1]+recvcnt[nprocs-1];
+      recvbuf.resize(rsize);
+      // Make sure buffers have valid addresses even if they are empty
+      int sdummy, rdummy;
+      int *sptr = sendbuf.empty() ? &sdummy : &sendbuf[0];
+      int *rptr = recvbuf.empty() ? &rdummy : &recvbuf[0];
+      MPI_Alltoallv(sptr,&sendcnt[0],&sdispl[0],MPI_INT,
+          rptr,&recvcnt[0],&rdispl[0],MPI_INT,comm);
+    }
+
   protected:
 
     NetworkPtr p_network;
@@ -535,6 +637,9 @@ class BaseFactory {
     gridpack::component::BaseBusComponent **p_buses;
 
     gridpack::component::BaseBranchComponent **p_branches;
+
+    // MatVec indices of all local buses (active and ghost)
+    std::vector<int> p_busMatVecIndex;
 };
 
 }    // factory
@@ -61,6 +61,12 @@ protected:
     return p_solver.solve(B);
   }
 
+  /// Solve w/ the specified RHS Matrix, in place (specialized)
+  void p_solve(const MatrixType& B, MatrixType& X) const
+  {
+    p_solver.solve(B, X);
+  }
+
   /// Specialized way to configure from property tree
   void p_configure(utility::Configuration::CursorPtr props)
   {
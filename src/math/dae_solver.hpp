@@ -47,6 +47,8 @@ public:
   typedef typename DAESolverInterface<T, I>::JacobianBuilder JacobianBuilder;
   typedef typename DAESolverInterface<T, I>::FunctionBuilder FunctionBuilder;
   typedef typename DAESolverInterface<T, I>::StepFunction StepFunction;
+  typedef typename DAESolverInterface<T, I>::EventFunction EventFunction;
+  typedef typename DAESolverInterface<T, I>::EventHandler EventHandler;
 
 
   /// Default constructor.
@@ -145,6 +147,39 @@ protected:
   {
     p_impl->postStep(f);
   }
+
+  /// Call a function at a specific time (specialized)
+  void p_addTimeEvent(const double& time, const EventHandler& handler)
+  {
+    p_impl->addTimeEvent(time, handler);
+  }
+
+  /// Call a function when a function of the solution crosses zero (specialized)
+  void p_addStateEvent(const EventFunction& indicator,
+                       const EventHandler& handler,
+                       const int& direction,
+                       const bool& terminate)
+  {
+    p_impl->addStateEvent(indicator, handler, direction, terminate);
+  }
+
+  /// Remove all events (specialized)
+  void p_clearEvents(void)
+  {
+    p_impl->clearEvents();
+  }
+
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_impl->statistics();
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_impl->resetStatistics();
+  }
 };
 
 typedef DAESolverT<ComplexType> ComplexDAESolver;
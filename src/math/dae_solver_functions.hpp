@@ -50,6 +50,16 @@ struct DAEBuilder {
   /// Functions that are called before and after a time step
   typedef  boost::function<void (const double& time)> StepFunction;
 
+  /// Functions that indicate a state event by crossing zero
+  typedef 
+  boost::function<double (const double& time, const VectorType& x)> 
+  EventFunction;
+
+  /// Functions that are called when an event occurs (may change @c x)
+  typedef 
+  boost::function<void (const double& time, VectorType& x)> 
+  EventHandler;
+
 };
 
 
@@ -20,6 +20,8 @@
 #ifndef _dae_solver_implementation_hpp_
 #define _dae_solver_implementation_hpp_
 
+#include <vector>
+#include <algorithm>
 #include <boost/shared_ptr.hpp>
 #include <gridpack/math/dae_solver_interface.hpp>
 #include <gridpack/parallel/distributed.hpp>
@@ -46,6 +48,8 @@ public:
   typedef typename DAESolverInterface<T, I>::JacobianBuilder JacobianBuilder;
   typedef typename DAESolverInterface<T, I>::FunctionBuilder FunctionBuilder;
   typedef typename DAESolverInterface<T, I>::StepFunction StepFunction;
+  typedef typename DAESolverInterface<T, I>::EventFunction EventFunction;
+  typedef typename DAESolverInterface<T, I>::EventHandler EventHandler;
   
 
   /// Default constructor.
@@ -57,7 +61,12 @@ public:
       utility::Configurable("DAESolver"),
       utility::Uncopyable(),
       p_J(comm, local_size, local_size),
-      p_Fbuilder(fbuilder), p_Jbuilder(jbuilder)
+      p_Fbuilder(fbuilder), p_Jbuilder(jbuilder),
+      p_stats(), p_verbose(false),
+      p_timeEvents(), p_stateEvents(), p_stateEventsChanged(false),
+      p_adaptiveSet(false), p_adaptive(false),
+      p_relativeTolerance(-1.0), p_absoluteTolerance(-1.0),
+      p_minimumTimeStep(-1.0), p_maximumTimeStep(-1.0)
   {
     
   }
@@ -85,9 +94,146 @@ protected:
   /// An optional function to call after each time step
   StepFunction p_postStepFunc;
 
+  /// Convergence and timing information
+  SolverStatistics p_stats;
+
+  /// Print convergence information for each solve
+  bool p_verbose;
+
+  /// A function to call at a specific time
+  struct TimeEvent {
+    double time;
+    EventHandler handler;
+    bool done;
+    bool operator< (const TimeEvent& other) const
+    {
+      return time < other.time;
+    }
+  };
+
+  /// A function to call when an indicator crosses zero
+  struct StateEvent {
+    EventFunction indicator;
+    EventHandler handler;
+    int direction;
+    bool terminate;
+  };
+
+  /// Time events, in time order
+  std::vector<TimeEvent> p_timeEvents;
+
+  /// State events
+  std::vector<StateEvent> p_stateEvents;
+
+  /// Have state events been added or removed since last used
+  bool p_stateEventsChanged;
+
+  /// Was time step adaptivity specified
+  bool p_adaptiveSet;
+
+  /// Use error controlled, adaptive time steps (if ::p_adaptiveSet)
+  bool p_adaptive;
+
+  /// Relative local error tolerance for adaptive steps (if > 0)
+  double p_relativeTolerance;
+
+  /// Absolute local error tolerance for adaptive steps (if > 0)
+  double p_absoluteTolerance;
+
+  /// Smallest adaptive time step (if > 0)
+  double p_minimumTimeStep;
+
+  /// Largest adaptive time step (if > 0)
+  double p_maximumTimeStep;
+
   /// Specialized way to configure from property tree
+  /**
+   * Error controlled time steps are turned on or off with @c
+   * Adaptive.  If not specified, the library default for the method
+   * is used.  Adaptive steps are controlled by @c
+   * RelativeTolerance, @c AbsoluteTolerance, @c MinimumTimeStep, and
+   * @c MaximumTimeStep.
+   */
   void p_configure(utility::Configuration::CursorPtr props)
-  {}
+  {
+    if (props) {
+      p_verbose = props->get("Verbose", p_verbose);
+      p_adaptiveSet = props->get("Adaptive", &p_adaptive);
+      p_relativeTolerance = props->get("RelativeTolerance", p_relativeTolerance);
+      p_absoluteTolerance = props->get("AbsoluteTolerance", p_absoluteTolerance);
+      p_minimumTimeStep = props->get("MinimumTimeStep", p_minimumTimeStep);
+      p_maximumTimeStep = props->get("MaximumTimeStep", p_maximumTimeStep);
+    }
+  }
+
+  /// Mark time events at or before the specified time as done
+  void p_resetTimeEvents(const double& t0)
+  {
+    for (typename std::vector<TimeEvent>::iterator e = p_timeEvents.begin();
+         e != p_timeEvents.end(); ++e) {
+      e->done = (e->time <= t0);
+    }
+  }
+
+  /// Get the next time event to be handled at or before the specified time
+  TimeEvent *p_nextTimeEvent(const double& tmax)
+  {
+    for (typename std::vector<TimeEvent>::iterator e = p_timeEvents.begin();
+         e != p_timeEvents.end(); ++e) {
+      if (!e->done) {
+        return (e->time <= tmax ? &(*e) : NULL);
+      }
+    }
+    return NULL;
+  }
+
+  /// Call a function at a specific time (specialized)
+  void p_addTimeEvent(const double& time, const EventHandler& handler)
+  {
+    TimeEvent e;
+    e.time = time;
+    e.handler = handler;
+    e.done = false;
+    p_timeEvents.insert(std::upper_bound(p_timeEvents.begin(), 
+                                         p_timeEvents.end(), e), e);
+  }
+
+  /// Call a function when a function of the solution crosses zero (specialized)
+  void p_addStateEvent(const EventFunction& indicator,
+                       const EventHandler& handler,
+                       const int& direction,
+                       const bool& terminate)
+  {
+    StateEvent e;
+    e.indicator = indicator;
+    e.handler = handler;
+    e.direction = (direction > 0 ? 1 : (direction < 0 ? -1 : 0));
+    e.terminate = terminate;
+    p_stateEvents.push_back(e);
+    p_stateEventsChanged = true;
+  }
+
+  /// Remove all events (specialized)
+  void p_clearEvents(void)
+  {
+    p_timeEvents.clear();
+    if (!p_stateEvents.empty()) {
+      p_stateEvents.clear();
+      p_stateEventsChanged = true;
+    }
+  }
+
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_stats;
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_stats.reset();
+  }
 
   /// Set a function to call before each time step (specialized)
   void p_preStep(StepFunction& f)
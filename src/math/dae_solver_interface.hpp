@@ -25,6 +25,7 @@
 #include <gridpack/math/matrix.hpp>
 
 #include <gridpack/math/dae_solver_functions.hpp>
+#include <gridpack/math/solver_statistics.hpp>
 
 namespace gridpack {
 namespace math {
@@ -42,6 +43,8 @@ public:
   typedef typename DAEBuilder<T, I>::Jacobian JacobianBuilder;
   typedef typename DAEBuilder<T, I>::Function FunctionBuilder;
   typedef typename DAEBuilder<T, I>::StepFunction StepFunction;
+  typedef typename DAEBuilder<T, I>::EventFunction EventFunction;
+  typedef typename DAEBuilder<T, I>::EventHandler EventHandler;
 
   /// Default constructor.
   DAESolverInterface(void)
@@ -100,6 +103,63 @@ public:
     this->p_postStep(f);
   }
 
+  /// Call a function when the solution reaches a specific time
+  /** 
+   * Time stepping stops exactly at @c time, @c handler is called,
+   * which may change the solution (e.g. to apply a fault), and time
+   * stepping is restarted with the initial time step.  Events at or
+   * before the time given to ::initialize() are not triggered.
+   * 
+   * @param time when the event occurs
+   * @param handler function to call
+   */
+  void addTimeEvent(const double& time, const EventHandler& handler)
+  {
+    this->p_addTimeEvent(time, handler);
+  }
+
+  /// Call a function when a function of the solution crosses zero
+  /** 
+   * The crossing is located by adjusting the time step, @c handler
+   * is called, and time stepping is restarted with the initial time
+   * step.  State events must all be added before the first
+   * ::solve().
+   * 
+   * @param indicator function whose zero crossing is the event
+   * @param handler function to call
+   * @param direction only crossings in this direction (1 = increasing,
+   * -1 = decreasing, 0 = both) are events
+   * @param terminate if true, ::solve() returns at the event
+   */
+  void addStateEvent(const EventFunction& indicator,
+                     const EventHandler& handler,
+                     const int& direction = 0,
+                     const bool& terminate = false)
+  {
+    this->p_addStateEvent(indicator, handler, direction, terminate);
+  }
+
+  /// Remove all events
+  void clearEvents(void)
+  {
+    this->p_clearEvents();
+  }
+
+  /// Get convergence and timing information collected by solves
+  /**
+   * For a DAESolver, SolverStatistics::iterations are time steps.
+   */
+  const SolverStatistics& statistics(void) const
+  {
+    return this->p_statistics();
+  }
+
+  /// Discard collected convergence and timing information
+  void resetStatistics(void)
+  {
+    this->p_resetStatistics();
+  }
+
 protected:
 
   /// Initialize the system (specialized)
@@ -117,6 +177,24 @@ protected:
   /// Set a function to call after each time step (specialized)
   virtual void p_postStep(StepFunction& f) = 0;
 
+  /// Call a function at a specific time (specialized)
+  virtual void p_addTimeEvent(const double& time, const EventHandler& handler) = 0;
+
+  /// Call a function when a function of the solution crosses zero (specialized)
+  virtual void p_addStateEvent(const EventFunction& indicator,
+                               const EventHandler& handler,
+                               const int& direction,
+                               const bool& terminate) = 0;
+
+  /// Remove all events (specialized)
+  virtual void p_clearEvents(void) = 0;
+
+  /// Get convergence and timing information (specialized)
+  virtual const SolverStatistics& p_statistics(void) const = 0;
+
+  /// Discard collected convergence and timing information (specialized)
+  virtual void p_resetStatistics(void) = 0;
+
 };
 
 
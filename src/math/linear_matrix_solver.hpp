@@ -87,6 +87,22 @@ protected:
     return p_impl->solve(B);
   }
 
+  /// Solve multiple systems w/ the specified RHS Matrix, in place (specialized)
+  /** 
+   * Like the other p_solve(), but the solution is put into an
+   * existing \ref Matrix::Dense "dense" Matrix @c X, which must have
+   * the same size and distribution as @c B.  This avoids allocating
+   * a new solution Matrix when the same systems are solved
+   * repeatedly.
+   * 
+   * @param B RHS matrix
+   * @param X (dense) solution Matrix
+   */
+  void p_solve(const MatrixType& B, MatrixType& X) const
+  {
+    p_impl->solve(B, X);
+  }
+
 };
 
 typedef LinearMatrixSolverT<ComplexType> ComplexLinearMatrixSolver;
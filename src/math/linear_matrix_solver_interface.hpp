@@ -55,11 +55,20 @@ public:
     return this->p_solve(B);
   }
 
+  /// Solve w/ the specified RHS Matrix, put result in existing (dense) Matrix
+  void solve(const MatrixType& B, MatrixType& X) const
+  {
+    this->p_solve(B, X);
+  }
+
 protected:
 
   /// Solve w/ the specified RHS Matrix (specialized)
   virtual MatrixType *p_solve(const MatrixType& B) const = 0;
 
+  /// Solve w/ the specified RHS Matrix, in place (specialized)
+  virtual void p_solve(const MatrixType& B, MatrixType& X) const = 0;
+
 };
 
 
@@ -23,6 +23,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <gridpack/utilities/uncopyable.hpp>
 #include <gridpack/math/linear_solver_implementation.hpp>
+#include <gridpack/math/linear_solver_analysis.hpp>
 
 namespace gridpack {
 namespace math {
@@ -90,6 +91,23 @@ public:
    * @return new LinearSolver instance
    */
   LinearSolverT(MatrixType& A);
+
+  /// Construct a solver that shares ordering and symbolic factorization
+  /** 
+   * @e Collective
+   *
+   * Like the default constructor, but the ordering and symbolic
+   * factorization of the coefficient matrix are taken from (and kept
+   * in) @c analysis. If @c A has the same sparsity pattern as the
+   * matrix last used with @c analysis, only a numeric factorization
+   * is done. See LinearSolverAnalysis.
+   * 
+   * @param A existing, filled coefficient matrix
+   * @param analysis shared analysis, created on the same communicator as @c A
+   * 
+   * @return new LinearSolver instance
+   */
+  LinearSolverT(MatrixType& A, LinearSolverAnalysisPtr analysis);
   
   /// Destructor
   /** 
@@ -202,6 +220,28 @@ protected:
     return p_solver->solve(B);
   }
 
+  /// Solve multiple systems w/ each column of the Matrix a single RHS, in place
+  /** 
+   * @param B RHS matrix -- each column is used as a RHS Vector
+   * @param X solution matrix, same size and distribution as @c B
+   */
+  void p_solve(const MatrixType& B, MatrixType& X) const
+  {
+    p_solver->solve(B, X);
+  }
+
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_solver->statistics();
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_solver->resetStatistics();
+  }
+
 
 };
 
@@ -0,0 +1,103 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   linear_solver_analysis.hpp
+ *
+ * @brief  Ordering and symbolic factorization shared by linear solvers
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _linear_solver_analysis_hpp_
+#define _linear_solver_analysis_hpp_
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gridpack/parallel/distributed.hpp>
+#include <gridpack/utilities/uncopyable.hpp>
+
+namespace gridpack {
+namespace math {
+
+class LinearSolverAnalysisImplementation;
+
+// -------------------------------------------------------------
+//  class LinearSolverAnalysis
+// -------------------------------------------------------------
+/// Ordering and symbolic factorization shared between LinearSolver instances
+/**
+ * Many applications (contingency analysis, state estimation, dynamic
+ * simulation fault stages) repeatedly build a LinearSolver on
+ * coefficient matrices that have identical sparsity patterns and
+ * differ only in their values.  Normally, each new LinearSolver
+ * computes a fill-reducing ordering and symbolic factorization of
+ * its coefficient matrix before the numeric factorization.
+ *
+ * A LinearSolverAnalysis instance holds the underlying library
+ * solver (and, hence, its ordering and symbolic factorization)
+ * along with a fingerprint of the sparsity pattern for which it was
+ * computed.  If it is passed to the LinearSolver constructor, the
+ * solver uses the shared analysis.  If the fingerprint of a new
+ * coefficient matrix matches, only a numeric factorization is done.
+ * If not, the analysis is recomputed for the new pattern.
+ *
+ * All solvers sharing an analysis must use the same \ref
+ * parallel::Communicator "communicator" and configuration.  The
+ * configuration of the first solver to use the analysis is the one
+ * that is kept.  Solvers sharing an analysis should not be used
+ * concurrently; each solve() may overwrite the factorization of the
+ * last.
+ *
+ */
+class LinearSolverAnalysis
+  : public parallel::Distributed,
+    private utility::Uncopyable
+{
+public:
+
+  /// Default constructor.
+  /**
+   * @e Collective
+   *
+   * @param comm communicator on which solvers using this analysis
+   * will be created
+   */
+  LinearSolverAnalysis(const parallel::Communicator& comm);
+
+  /// Destructor
+  ~LinearSolverAnalysis(void);
+
+  /// Get the number of times the ordering/symbolic factorization was computed
+  int symbolicFactorizations(void) const;
+
+  /// Get the number of times a numeric factorization was requested
+  int numericFactorizations(void) const;
+
+  /// Discard any cached analysis (@e Collective)
+  void reset(void);
+
+  /// Get the underlying library implementation (for internal use)
+  LinearSolverAnalysisImplementation *implementation(void) const
+  {
+    return p_impl.get();
+  }
+
+protected:
+
+  /// The library specific part of the analysis
+  boost::scoped_ptr<LinearSolverAnalysisImplementation> p_impl;
+};
+
+typedef boost::shared_ptr<LinearSolverAnalysis> LinearSolverAnalysisPtr;
+
+} // namespace math
+} // namespace gridpack
+
+#endif
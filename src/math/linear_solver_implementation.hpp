@@ -63,7 +63,9 @@ public:
       p_doSerial(false),
       p_constSerialMatrix(),
       p_guessZero(false),
-      p_serialSolution()
+      p_serialSolution(),
+      p_stats(),
+      p_verbose(false)
   {
   }
 
@@ -137,6 +139,24 @@ protected:
   /// A buffer to use for value transfer
   mutable std::vector<TheType> p_valueBuffer;
 
+  /// Convergence and timing information
+  mutable SolverStatistics p_stats;
+
+  /// Print convergence information for each solve
+  bool p_verbose;
+
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_stats;
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_stats.reset();
+  }
+
   /// Specialized way to configure from property tree
   void p_configure(utility::Configuration::CursorPtr props)
   {
@@ -152,6 +172,7 @@ protected:
       p_doSerial = (p_doSerial && (this->processor_size() > 1));
 
       p_guessZero = props->get("InitialGuessZero", p_guessZero);
+      p_verbose = props->get("Verbose", p_verbose);
     }
   }
 
@@ -185,6 +206,22 @@ protected:
   /// Solve the system again w/ RHS and estimate (implementation)
   virtual void p_resolveImpl(const VectorType& b, VectorType& x) const = 0;
 
+  /// Factor, or otherwise prepare, the coefficient matrix (implementation)
+  virtual void p_factorImpl(MatrixType& A) const = 0;
+
+  /// Factor the coefficient matrix so that it can be used by p_resolve()
+  void p_factor(void) const
+  {
+    if (p_doSerial) {
+      if (!p_serialMatrix || !p_constSerialMatrix) {
+        p_serialMatrix.reset(p_matrix.localClone());
+      }
+      this->p_factorImpl(*p_serialMatrix);
+    } else {
+      this->p_factorImpl(p_matrix);
+    }
+  }
+
   /// Gather the RHS and initial estimate vectors
   void p_serialSolvePrep(const VectorType& b, VectorType& x) const
   {
@@ -286,9 +323,25 @@ protected:
   /// Solve multiple systems w/ each column of the Matrix a single RHS
   MatrixType *p_solve(const MatrixType& B) const
   {
+    MatrixType *result(new MatrixType(B.communicator(), B.localRows(), B.localCols(), Dense));
+    this->p_solve(B, *result);
+    return result;
+  }
+
+  /// Solve multiple systems w/ each column of the Matrix a single RHS, in place
+  /**
+   * This is the fallback: the coefficient matrix is factored once and
+   * each column is then solved separately with that factorization.
+   * Implementations that can do a blocked solve should override this.
+   */
+  virtual void p_solve(const MatrixType& B, MatrixType& result) const
+  {
+    if (result.rows() != B.rows() || result.cols() != B.cols()) {
+      throw Exception("LinearSolver::solve(B, X): X must be the same size as B");
+    }
+
     VectorType b(B.communicator(), B.localRows());
     VectorType X(B.communicator(), B.localRows());
-    MatrixType *result(new MatrixType(B.communicator(), B.localRows(), B.localCols(), Dense));
 
     int ilo, ihi;
     X.localIndexRange(ilo, ihi);
@@ -299,22 +352,18 @@ protected:
     std::vector<IdxType> jidx(nloc);
     std::vector<TheType> locX(nloc);
 
+    this->p_factor();
     for (int j = 0; j < B.cols(); ++j) {
       column(B, j, b);
       X.zero();
       X.ready();
-      if (j == 0) {
-        this->solve(b, X);
-      } else {
-        this->resolve(b, X);
-      }
+      this->resolve(b, X);
       std::fill(jidx.begin(), jidx.end(), j);
       X.getElements(nloc, &iidx[0], &locX[0]);
-      result->setElements(nloc, &iidx[0], &jidx[0], &locX[0]);
+      result.setElements(nloc, &iidx[0], &jidx[0], &locX[0]);
     }
   
-    result->ready();
-    return result;
+    result.ready();
   }
 
 };
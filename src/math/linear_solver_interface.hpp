@@ -23,6 +23,7 @@
 #define _linear_solver_interface_hpp_
 
 #include "gridpack/math/matrix.hpp"
+#include "gridpack/math/solver_statistics.hpp"
 
 namespace gridpack {
 namespace math {
@@ -156,6 +157,40 @@ public:
     return this->p_solve(B);
   }
 
+  /// Solve multiple systems w/ each column of a Matrix a single RHS, in place
+  /** 
+   * @e Collective.
+   *
+   * Solve for all of the right hand sides in @c B using a single
+   * factorization of the coefficient matrix.  When the underlying
+   * library can, the systems are solved as a block (e.g. blocked
+   * triangular solves of a direct factorization).  Otherwise, the
+   * columns are solved one at a time.  
+   *
+   * @c X must already exist and have the same size and distribution
+   * as @c B.  Both should be \ref Matrix::Dense "dense" to get the
+   * blocked solution.
+   * 
+   * @param B RHS matrix -- each column is used as a RHS Vector
+   * @param X solution matrix -- each column is the solution for the corresponding column in @c B
+   */
+  void solve(const MatrixType& B, MatrixType& X) const
+  {
+    this->p_solve(B, X);
+  }
+
+  /// Get convergence and timing information collected by solves
+  const SolverStatistics& statistics(void) const
+  {
+    return this->p_statistics();
+  }
+
+  /// Discard collected convergence and timing information
+  void resetStatistics(void)
+  {
+    this->p_resetStatistics();
+  }
+
 
 protected:
 
@@ -195,6 +230,15 @@ protected:
   /// Solve multiple systems w/ each column of the Matrix a single RHS
   virtual MatrixType *p_solve(const MatrixType& B) const = 0;
 
+  /// Solve multiple systems w/ each column of the Matrix a single RHS, in place
+  virtual void p_solve(const MatrixType& B, MatrixType& X) const = 0;
+
+  /// Get convergence and timing information (specialized)
+  virtual const SolverStatistics& p_statistics(void) const = 0;
+
+  /// Discard collected convergence and timing information (specialized)
+  virtual void p_resetStatistics(void) = 0;
+
 };
 
 
@@ -0,0 +1,480 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   low_rank_update_solver.hpp
+ *
+ * @brief  Solve a low rank modification of a factored system
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _low_rank_update_solver_hpp_
+#define _low_rank_update_solver_hpp_
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <functional>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/mpi/collectives.hpp>
+#include <gridpack/utilities/exception.hpp>
+#include <gridpack/utilities/uncopyable.hpp>
+#include <gridpack/math/linear_solver.hpp>
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  class LowRankUpdateSolverT
+// -------------------------------------------------------------
+/// Solve a system that differs from a factored one by a low rank update
+/**
+ * This solves
+ * \f[
+ *   \left( \left[ \mathbf{A}_0 \right] + \sum_{k=1}^{r} \mathbf{u}_k \mathbf{v}_k^T \right) \mathbf{x} ~ = ~ \mathbf{b}
+ * \f]
+ * using the Sherman-Morrison-Woodbury formula, where
+ * \f$\left[ \mathbf{A}_0 \right]\f$ is factored once, at the first
+ * solve, and reused for every set of updates.  This is intended for
+ * contingency analysis, where a branch outage changes the
+ * admittance (or DC susceptance) matrix by a rank one update with
+ * @f$\mathbf{u}@f$ and @f$\mathbf{v}@f$ each having two nonzeros.
+ *
+ * Each update costs one solve with the base factorization (done at
+ * the first solve after it is added), after which each solve costs
+ * one more base solve, a few dot products and an \f$r \times r\f$
+ * dense solve.
+ *
+ * When the number of updates exceeds ::maximumRank() (configuration
+ * key "MaximumUpdateRank", default 8), Woodbury is no longer
+ * cheaper. In that case the modified matrix is formed explicitly and
+ * factored with a separate LinearSolver.
+ *
+ * The modified system is treated as singular, and an exception
+ * thrown, if a pivot of the capacitance matrix is smaller than
+ * "SingularUpdateTolerance" (default 1.0e-08) times its largest
+ * element. For a branch outage, this means the outage islands part
+ * of the network.
+ *
+ * The update vectors are specified by their nonzero elements using
+ * global indexes.  All processes must specify the same updates.
+ */
+template <typename T, typename I = int>
+class LowRankUpdateSolverT
+  : private utility::Uncopyable
+{
+public:
+
+  typedef MatrixT<T, I> MatrixType;
+  typedef VectorT<T, I> VectorType;
+  typedef LinearSolverT<T, I> SolverType;
+
+  /// Default constructor.
+  /**
+   * @e Collective
+   *
+   * @param A base coefficient matrix, which must exist for the life of
+   * this instance
+   */
+  LowRankUpdateSolverT(MatrixType& A)
+    : utility::Uncopyable(),
+      p_A(A),
+      p_ownSolver(new SolverType(A)),
+      p_solver(p_ownSolver.get()),
+      p_props(),
+      p_maxRank(8),
+      p_singularTolerance(1.0e-08),
+      p_factored(false),
+      p_updatesReady(false),
+      p_baseSolves(0)
+  {}
+
+  /// Construct using an existing solver for the base matrix
+  /**
+   * @e Collective
+   *
+   * This allows the base factorization to be shared with other uses
+   * of @c solver.  configure() does not change @c solver.
+   *
+   * @param A base coefficient matrix, which must exist for the life of
+   * this instance
+   * @param solver a solver for @c A that has already been used for a
+   * solve, so it is factored, and which must exist for the life of this
+   * instance
+   */
+  LowRankUpdateSolverT(MatrixType& A, SolverType& solver)
+    : utility::Uncopyable(),
+      p_A(A),
+      p_ownSolver(),
+      p_solver(&solver),
+      p_props(),
+      p_maxRank(8),
+      p_singularTolerance(1.0e-08),
+      p_factored(true),
+      p_updatesReady(false),
+      p_baseSolves(0)
+  {}
+
+  /// Destructor
+  ~LowRankUpdateSolverT(void)
+  {}
+
+  /// Configure the base (and any fallback) linear solver
+  void configure(utility::Configuration::CursorPtr props)
+  {
+    p_props = props;
+    if (props) {
+      p_maxRank = props->get("MaximumUpdateRank", p_maxRank);
+      p_singularTolerance =
+        props->get("SingularUpdateTolerance", p_singularTolerance);
+    }
+    if (p_ownSolver) p_ownSolver->configure(props);
+  }
+
+  /// Get the maximum rank handled with Woodbury updates
+  int maximumRank(void) const
+  {
+    return p_maxRank;
+  }
+
+  /// Set the maximum rank handled with Woodbury updates
+  void maximumRank(const int& r)
+  {
+    p_maxRank = r;
+  }
+
+  /// Get the current number of rank one updates
+  int rank(void) const
+  {
+    return static_cast<int>(p_u.size());
+  }
+
+  /// Get the number of solves done with the base factorization
+  int baseSolves(void) const
+  {
+    return p_baseSolves;
+  }
+
+  /// Is the last solve using a refactored (fallback) matrix
+  bool refactored(void) const
+  {
+    return static_cast<bool>(p_modifiedSolver);
+  }
+
+  /// Remove all updates, leaving the base system
+  void clearUpdates(void)
+  {
+    p_u.clear();
+    p_v.clear();
+    p_z.clear();
+    p_updatesReady = false;
+    p_modifiedSolver.reset();
+    p_modifiedA.reset();
+  }
+
+  /// Add a rank one update @f$\mathbf{u}\mathbf{v}^T@f$
+  /**
+   * @param uidx global indexes of the nonzero elements of @f$\mathbf{u}@f$
+   * @param uval nonzero values of @f$\mathbf{u}@f$
+   * @param vidx global indexes of the nonzero elements of @f$\mathbf{v}@f$
+   * @param vval nonzero values of @f$\mathbf{v}@f$
+   */
+  void addUpdate(const std::vector<I>& uidx, const std::vector<T>& uval,
+                 const std::vector<I>& vidx, const std::vector<T>& vval)
+  {
+    if (uidx.size() != uval.size() || vidx.size() != vval.size()) {
+      throw Exception("LowRankUpdateSolver::addUpdate: index and value sizes differ");
+    }
+    p_u.push_back(SparseVector(uidx, uval));
+    p_v.push_back(SparseVector(vidx, vval));
+    p_updatesReady = false;
+    p_modifiedSolver.reset();
+    p_modifiedA.reset();
+  }
+
+  /// Add a symmetric rank one update @f$ c\,\mathbf{w}\mathbf{w}^T@f$
+  /**
+   * This is the form of a branch admittance change between
+   * buses @c i and @c j, with @f$\mathbf{w} = \mathbf{e}_i -
+   * \mathbf{e}_j@f$ and @f$c@f$ the change in branch admittance.
+   *
+   * @param i first index
+   * @param j second index
+   * @param c update scale
+   */
+  void addBranchUpdate(const I& i, const I& j, const T& c)
+  {
+    std::vector<I> idx(2);
+    std::vector<T> u(2), v(2);
+    idx[0] = i; idx[1] = j;
+    u[0] = c; u[1] = -c;
+    v[0] = 1.0; v[1] = -1.0;
+    addUpdate(idx, u, idx, v);
+  }
+
+  /// Solve the updated system
+  /**
+   * @e Collective
+   *
+   * @param b right hand side
+   * @param x solution (initial estimate on input)
+   */
+  void solve(const VectorType& b, VectorType& x) const
+  {
+    int r(rank());
+    if (r > p_maxRank) {
+      p_solveModified(b, x);
+      return;
+    }
+
+    p_baseSolve(b, x);
+    if (r == 0) return;
+
+    if (!p_updatesReady) p_prepareUpdates(b);
+
+    // w = V^T y
+    std::vector<T> w(r);
+    for (int k = 0; k < r; ++k) w[k] = p_dot(p_v[k], x);
+    p_allSum(x, w);
+
+    // S a = w, S already factored
+    std::vector<T> a(w);
+    p_luSolve(p_S, p_piv, r, a);
+
+    // x = y - Z a
+    for (int k = 0; k < r; ++k) {
+      x.add(*p_z[k], -a[k]);
+    }
+    x.ready();
+  }
+
+protected:
+
+  /// A sparse vector, stored as global index/value pairs
+  struct SparseVector {
+    SparseVector(const std::vector<I>& i, const std::vector<T>& v)
+      : idx(i), val(v)
+    {}
+    std::vector<I> idx;
+    std::vector<T> val;
+  };
+
+  /// The base coefficient matrix
+  MatrixType& p_A;
+
+  /// Solver for the base coefficient matrix, if not shared
+  boost::scoped_ptr<SolverType> p_ownSolver;
+
+  /// Solver for the base coefficient matrix
+  SolverType *p_solver;
+
+  /// Configuration for solvers
+  utility::Configuration::CursorPtr p_props;
+
+  /// Largest number of updates handled with Woodbury
+  int p_maxRank;
+
+  /// Relative size of a capacitance matrix pivot that is treated as zero
+  double p_singularTolerance;
+
+  /// Has the base matrix been factored
+  mutable bool p_factored;
+
+  /// Are ::p_z and ::p_S consistent with the current updates
+  mutable bool p_updatesReady;
+
+  /// Number of base solves
+  mutable int p_baseSolves;
+
+  /// Update vectors
+  std::vector<SparseVector> p_u, p_v;
+
+  /// @f$\mathbf{A}_0^{-1}\mathbf{u}_k@f$
+  mutable std::vector< boost::shared_ptr<VectorType> > p_z;
+
+  /// Factored capacitance matrix, @f$\mathbf{I} + \mathbf{V}^T\mathbf{Z}@f$
+  mutable std::vector<T> p_S;
+
+  /// Pivots for ::p_S
+  mutable std::vector<int> p_piv;
+
+  /// Modified matrix, if formed explicitly
+  mutable boost::scoped_ptr<MatrixType> p_modifiedA;
+
+  /// Solver for the modified matrix
+  mutable boost::scoped_ptr<SolverType> p_modifiedSolver;
+
+  /// Solve with the base matrix
+  void p_baseSolve(const VectorType& b, VectorType& x) const
+  {
+    if (!p_factored) {
+      p_solver->solve(b, x);
+      p_factored = true;
+    } else {
+      p_solver->resolve(b, x);
+    }
+    p_baseSolves++;
+  }
+
+  /// Local part of a sparse dot product
+  T p_dot(const SparseVector& v, const VectorType& x) const
+  {
+    I lo, hi;
+    x.localIndexRange(lo, hi);
+    T sum(0.0);
+    for (size_t n = 0; n < v.idx.size(); ++n) {
+      I i(v.idx[n]);
+      if (lo <= i && i < hi) {
+        T xi;
+        x.getElement(i, xi);
+        sum += v.val[n]*xi;
+      }
+    }
+    return sum;
+  }
+
+  /// Sum local contributions over all processes
+  void p_allSum(const VectorType& x, std::vector<T>& w) const
+  {
+    boost::mpi::communicator comm(x.communicator());
+    if (comm.size() > 1) {
+      std::vector<T> lw(w);
+      boost::mpi::all_reduce(comm, &lw[0], static_cast<int>(lw.size()),
+                             &w[0], std::plus<T>());
+    }
+  }
+
+  /// Compute Z and factor the capacitance matrix
+  void p_prepareUpdates(const VectorType& b) const
+  {
+    int r(rank());
+    p_z.clear();
+    for (int k = 0; k < r; ++k) {
+      boost::shared_ptr<VectorType> uk(b.clone());
+      uk->zero();
+      I lo, hi;
+      uk->localIndexRange(lo, hi);
+      for (size_t n = 0; n < p_u[k].idx.size(); ++n) {
+        I i(p_u[k].idx[n]);
+        if (lo <= i && i < hi) uk->addElement(i, p_u[k].val[n]);
+      }
+      uk->ready();
+      boost::shared_ptr<VectorType> zk(b.clone());
+      zk->zero();
+      zk->ready();
+      p_baseSolve(*uk, *zk);
+      p_z.push_back(zk);
+    }
+
+    // S(i,j) = delta(i,j) + v_i^T z_j, stored by rows
+    p_S.assign(r*r, T(0.0));
+    for (int i = 0; i < r; ++i) {
+      for (int j = 0; j < r; ++j) {
+        p_S[i*r + j] = p_dot(p_v[i], *p_z[j]);
+      }
+    }
+    p_allSum(b, p_S);
+    for (int i = 0; i < r; ++i) p_S[i*r + i] += 1.0;
+
+    if (!p_luFactor(p_S, p_piv, r, p_singularTolerance)) {
+      throw Exception("LowRankUpdateSolver: singular update (modified system is singular)");
+    }
+    p_updatesReady = true;
+  }
+
+  /// Form and solve the modified system explicitly
+  void p_solveModified(const VectorType& b, VectorType& x) const
+  {
+    if (!p_modifiedSolver) {
+      p_modifiedA.reset(p_A.clone());
+      I lo, hi;
+      p_modifiedA->localRowRange(lo, hi);
+      for (size_t k = 0; k < p_u.size(); ++k) {
+        for (size_t m = 0; m < p_u[k].idx.size(); ++m) {
+          I i(p_u[k].idx[m]);
+          if (i < lo || i >= hi) continue;
+          for (size_t n = 0; n < p_v[k].idx.size(); ++n) {
+            p_modifiedA->addElement(i, p_v[k].idx[n],
+                                    p_u[k].val[m]*p_v[k].val[n]);
+          }
+        }
+      }
+      p_modifiedA->ready();
+      p_modifiedSolver.reset(new SolverType(*p_modifiedA));
+      if (p_props) p_modifiedSolver->configure(p_props);
+      p_modifiedSolver->solve(b, x);
+    } else {
+      p_modifiedSolver->resolve(b, x);
+    }
+  }
+
+  /// LU factor a small dense (row major) matrix in place w/ partial pivoting
+  /**
+   * @return false if a pivot is not larger than @c tol times the
+   * largest element of @c a
+   */
+  static bool p_luFactor(std::vector<T>& a, std::vector<int>& piv, const int& n,
+                         const double& tol)
+  {
+    double anorm(0.0);
+    for (size_t i = 0; i < a.size(); ++i) {
+      anorm = std::max<double>(anorm, std::abs(a[i]));
+    }
+    piv.resize(n);
+    for (int k = 0; k < n; ++k) {
+      int p(k);
+      double amax(std::abs(a[k*n + k]));
+      for (int i = k + 1; i < n; ++i) {
+        if (std::abs(a[i*n + k]) > amax) {
+          amax = std::abs(a[i*n + k]);
+          p = i;
+        }
+      }
+      if (!(amax > tol*anorm)) return false;
+      piv[k] = p;
+      if (p != k) {
+        for (int j = 0; j < n; ++j) std::swap(a[k*n + j], a[p*n + j]);
+      }
+      for (int i = k + 1; i < n; ++i) {
+        a[i*n + k] /= a[k*n + k];
+        for (int j = k + 1; j < n; ++j) {
+          a[i*n + j] -= a[i*n + k]*a[k*n + j];
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Solve w/ a small dense matrix factored by p_luFactor
+  static void p_luSolve(const std::vector<T>& a, const std::vector<int>& piv,
+                        const int& n, std::vector<T>& x)
+  {
+    for (int k = 0; k < n; ++k) {
+      if (piv[k] != k) std::swap(x[k], x[piv[k]]);
+    }
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < i; ++j) x[i] -= a[i*n + j]*x[j];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+      for (int j = i + 1; j < n; ++j) x[i] -= a[i*n + j]*x[j];
+      x[i] /= a[i*n + i];
+    }
+  }
+};
+
+typedef LowRankUpdateSolverT<ComplexType> ComplexLowRankUpdateSolver;
+typedef LowRankUpdateSolverT<RealType> RealLowRankUpdateSolver;
+typedef ComplexLowRankUpdateSolver LowRankUpdateSolver;
+
+} // namespace math
+} // namespace gridpack
+
+#endif
@@ -110,6 +110,27 @@ public:
           const int& local_cols,
           const int *nz_by_row);
 
+  /// Diagonal or block diagonal matrix constructor
+  /** 
+   * Only the (square) blocks of size @c block_size on the diagonal
+   * may be set.  A block must be owned by a single process, so @c
+   * local_rows must be a multiple of @c block_size and @c local_rows
+   * and @c local_cols must be the same. 
+   * 
+   * @param dist parallel environment
+   * @param local_rows matrix rows to be owned by the local process
+   * @param local_cols matrix columns to be owned by the local process
+   * @param storage_type Diagonal or BlockDiagonal
+   * @param block_size size of diagonal blocks (ignored if Diagonal)
+   * 
+   * @return new MatrixT
+   */
+  MatrixT(const parallel::Communicator& dist,
+          const int& local_rows,
+          const int& local_cols,
+          const MatrixStorageType& storage_type,
+          const int& block_size);
+
   /// Construct with an existing (allocated) implementation 
   /** 
    * For internal use only.
@@ -20,17 +20,24 @@ namespace math {
 
 /// The types of matrices that can be created
 /**
- * The gridpack::math library provides two storage schemes for
+ * The gridpack::math library provides several storage schemes for
  * matrices. This is used by Matrix and MatrixImplementation
  * subclasses.
  *
+ * Diagonal and BlockDiagonal matrices must be square and have the
+ * same local row and column ownership.  Only elements on the
+ * diagonal (or in the diagonal blocks) may be set. Some operations
+ * (e.g. multiply() and LinearSolver) use this to do less work.
+ *
  * The actual storage scheme and memory used is dependent upon the
  * underlying math library implementation.
  * 
  */
 enum MatrixStorageType { 
   Dense,                      /**< dense matrix storage scheme */
-  Sparse                      /**< sparse matrix storage scheme */
+  Sparse,                     /**< sparse matrix storage scheme */
+  Diagonal,                   /**< only diagonal elements are stored */
+  BlockDiagonal               /**< only small, dense diagonal blocks are stored */
 };
 
 } // namespace math
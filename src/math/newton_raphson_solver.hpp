@@ -75,9 +75,10 @@ public:
                        FunctionBuilder form_function)
     : NonlinearSolverT<T, I>()
   {
-    this->p_setImpl(new NewtonRaphsonSolverImplementation<T, I>(comm, local_size,
-                                                                form_jacobian,
-                                                                form_function));
+    p_nrImpl = new NewtonRaphsonSolverImplementation<T, I>(comm, local_size,
+                                                           form_jacobian,
+                                                           form_function);
+    this->p_setImpl(p_nrImpl);
   }
 
   /// Construct with an existing Jacobian Matrix
@@ -86,9 +87,10 @@ public:
                        FunctionBuilder form_function)
     : NonlinearSolverT<T, I>()
   {
-    this->p_setImpl(new NewtonRaphsonSolverImplementation<T, I>(J, 
-                                                                form_jacobian, 
-                                                                form_function));
+    p_nrImpl = new NewtonRaphsonSolverImplementation<T, I>(J, 
+                                                           form_jacobian, 
+                                                           form_function);
+    this->p_setImpl(p_nrImpl);
   }
 
   /// Destructor
@@ -99,6 +101,34 @@ public:
    */
   ~NewtonRaphsonSolverT(void)
   { }
+
+  /// Get the number of iterations performed by the last solve
+  int iterations(void) const
+  {
+    return p_nrImpl->iterations();
+  }
+
+  /// Get the number of Jacobian evaluations in the last solve
+  /**
+   * Each Jacobian evaluation also requires a new linear solver setup
+   * (factorization).  This is less than iterations() if the Jacobian
+   * is reused (see NewtonRaphsonSolverImplementation).
+   */
+  int jacobianEvaluations(void) const
+  {
+    return p_nrImpl->jacobianEvaluations();
+  }
+
+  /// Get the function (residual) norm at each iteration of the last solve
+  const std::vector<double>& residualHistory(void) const
+  {
+    return p_nrImpl->residualHistory();
+  }
+
+protected:
+
+  /// The implementation, as its specific type (owned by the base class)
+  NewtonRaphsonSolverImplementation<T, I> *p_nrImpl;
 };
 
 typedef NewtonRaphsonSolverT<ComplexType> ComplexNewtonRaphsonSolver;
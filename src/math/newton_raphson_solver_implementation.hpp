@@ -21,6 +21,7 @@
 #define _newton_raphson_solver_implementation_hpp_
 
 #include <iostream>
+#include <vector>
 #include <boost/scoped_ptr.hpp>
 #include "nonlinear_solver_functions.hpp"
 #include "nonlinear_solver_implementation.hpp"
@@ -60,6 +61,18 @@ namespace math {
  * The interative process is ended when the L<sup>2</sup> \ref
  * Vector::norm2() "norm" of \f$ \Delta \mathbf{x}^{k} \f$ is less
  * then some specified small tolerance.
+ *
+ * Forming and factoring the Jacobian usually dominates the cost of an
+ * iteration.  The Jacobian, and with it the linear solver setup, can
+ * be reused for several iterations (chord or Shamanskii Newton).  It
+ * is recomputed every @c RefactorInterval iterations, or earlier if
+ * the ratio of successive solution residual norms exceeds
+ * @c ContractionLimit.  With the default @c RefactorInterval of 1,
+ * this is the full Newton-Raphson method.
+ *
+ * The linear system is solved with a LinearSolver that needs the
+ * assembled Jacobian, so the @c MatrixFree option is ignored.
+ * Jacobian reuse is the equivalent here.
  */
 template <typename T, typename I>
 class NewtonRaphsonSolverImplementation 
@@ -90,7 +103,11 @@ public:
                                     JacobianBuilder form_jacobian,
                                     FunctionBuilder form_function)
     : NonlinearSolverImplementation<T, I>(comm, local_size, form_jacobian, form_function),
-      p_linear_solver()
+      p_linear_solver(),
+      p_refactorInterval(1),
+      p_contractionLimit(0.5),
+      p_iterations(0),
+      p_jacobianEvaluations(0)
   {
     this->configurationKey("NewtonRaphsonSolver");
   }
@@ -101,7 +118,11 @@ public:
                                     JacobianBuilder form_jacobian,
                                     FunctionBuilder form_function)
     : NonlinearSolverImplementation<T, I>(J, form_jacobian, form_function),
-      p_linear_solver()
+      p_linear_solver(),
+      p_refactorInterval(1),
+      p_contractionLimit(0.5),
+      p_iterations(0),
+      p_jacobianEvaluations(0)
   {
     this->configurationKey("NewtonRaphsonSolver");
   }
@@ -116,6 +137,24 @@ public:
   {
   }
 
+  /// Get the number of iterations performed by the last solve
+  int iterations(void) const
+  {
+    return p_iterations;
+  }
+
+  /// Get the number of Jacobian evaluations (and linear solver setups) in the last solve
+  int jacobianEvaluations(void) const
+  {
+    return p_jacobianEvaluations;
+  }
+
+  /// Get the function (residual) norm at each iteration of the last solve
+  const std::vector<double>& residualHistory(void) const
+  {
+    return p_residualHistory;
+  }
+
 
 protected:
 
@@ -132,6 +171,21 @@ protected:
   /// The linear solver
   boost::scoped_ptr< LinearSolverT<T, I> > p_linear_solver;
 
+  /// Maximum number of iterations between Jacobian evaluations
+  int p_refactorInterval;
+
+  /// Force a new Jacobian if successive residual norms decrease less than this
+  double p_contractionLimit;
+
+  /// Number of iterations performed by the last solve
+  int p_iterations;
+
+  /// Number of Jacobian evaluations in the last solve
+  int p_jacobianEvaluations;
+
+  /// Function (residual) norm at each iteration of the last solve
+  std::vector<double> p_residualHistory;
+
   /// Solve w/ using the specified initial guess (specialized)
   void p_solve(VectorType& x)
   {
@@ -139,23 +193,52 @@ protected:
     double stol(1.0e+30);
     double ftol(1.0e+30);
     int iter(0);
+    int lastJacobian(0);
+    bool needJacobian(true);
+
+    p_iterations = 0;
+    p_jacobianEvaluations = 0;
+    p_residualHistory.clear();
+    double tsetup(0.0), tstart(SolverStatistics::now());
+    int lits(0);
 
     boost::scoped_ptr<VectorType> deltaX(this->p_X->clone());
     while (stol > this->p_solutionTolerance && iter < this->p_maxIterations) {
       this->p_function(*(this->p_X), *(this->p_F));
       this->p_F->scale(-1.0);
-      this->p_jacobian(*(this->p_X), *(this->p_J));
-      if (!p_linear_solver) {
-        p_linear_solver.reset(new LinearSolverT<T, I>(*(this->p_J)));
-        p_linear_solver->configure(this->p_configCursor);
-      } 
+      if (iter - lastJacobian >= p_refactorInterval) needJacobian = true;
       deltaX->zero();
-      p_linear_solver->solve(*(this->p_F), *deltaX);
+      if (needJacobian) {
+        this->p_jacobian(*(this->p_X), *(this->p_J));
+        if (!p_linear_solver) {
+          p_linear_solver.reset(new LinearSolverT<T, I>(*(this->p_J)));
+          p_linear_solver->configure(this->p_configCursor);
+        } 
+        p_linear_solver->solve(*(this->p_F), *deltaX);
+        p_jacobianEvaluations += 1;
+        lastJacobian = iter;
+        needJacobian = false;
+      } else {
+        // the Jacobian has not changed, so the existing
+        // factorization is used
+        p_linear_solver->resolve(*(this->p_F), *deltaX);
+      }
+      {
+        const SolverStatistics& lstats(p_linear_solver->statistics());
+        lits += lstats.iterations;
+        tsetup += lstats.setupTime;
+        p_linear_solver->resetStatistics();
+      }
+      double oldstol(stol);
       stol = deltaX->norm2();
       ftol = this->p_F->norm2();
       this->p_X->add(*deltaX);
       iter += 1;
-      if (this->processor_rank() == 0) {
+      p_residualHistory.push_back(ftol);
+      if (iter > 1 && stol > p_contractionLimit*oldstol) {
+        needJacobian = true;
+      }
+      if (this->p_verbose && this->processor_rank() == 0) {
         std::cout << "Newton-Raphson "
                   << "iteration " << iter << ": "
                   << "solution residual norm = " << stol << ", "
@@ -163,6 +246,26 @@ protected:
                   << std::endl;
       }
     }
+    p_iterations = iter;
+
+    SolverStatistics& stats(this->p_stats);
+    stats.setupTime += tsetup;
+    stats.solveTime += SolverStatistics::now() - tstart - tsetup;
+    stats.setups += p_jacobianEvaluations;
+    stats.record(iter, (stol > this->p_solutionTolerance ? -1 : 1), stol);
+    stats.recordLinear(lits);
+    stats.residualHistory = p_residualHistory;
+  }
+
+  /// Specialized way to configure from property tree
+  void p_configure(utility::Configuration::CursorPtr props)
+  {
+    NonlinearSolverImplementation<T, I>::p_configure(props);
+    if (props) {
+      p_refactorInterval = props->get("RefactorInterval", p_refactorInterval);
+      p_contractionLimit = props->get("ContractionLimit", p_contractionLimit);
+    }
+    if (p_refactorInterval < 1) p_refactorInterval = 1;
   }
 
 };
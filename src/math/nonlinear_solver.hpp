@@ -49,6 +49,15 @@ namespace math {
  * use functor classes or structs, since extra required information
  * can be available to the Matrix/Vector construction.
  *
+ * If configured with @c MatrixFree, the Jacobian is only applied
+ * through Jacobian-vector products (Newton-Krylov).  The products are
+ * computed by a \ref JacobianProductBuilder "function" supplied with
+ * jacobianProduct(), or, if none is supplied, by finite differences
+ * of the \ref FunctionBuilder "right hand side".  The assembled
+ * Jacobian is then only used to build the preconditioner, and it is
+ * only rebuilt every @c PreconditionerInterval iterations.  A Krylov
+ * method (e.g. @c -ksp_type @c gmres) must be used.
+ *
  * Implementation ...
  */
 template <typename T, typename I = int>
@@ -143,12 +152,30 @@ protected:
     p_impl->maximumIterations(n);
   }
 
+  /// Supply a Jacobian-vector product (specialized)
+  void p_jacobianProduct(typename NonlinearSolverInterface<T, I>::JacobianProductBuilder jv)
+  {
+    p_impl->jacobianProduct(jv);
+  }
+
   /// Solve w/ the specified initial estimated, put result in same vector
   void p_solve(VectorType& x)
   {
     p_impl->solve(x);
   }
 
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_impl->statistics();
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_impl->resetStatistics();
+  }
+
   /// Set the implementation
   /** 
    * Does what is necessary to set the \ref
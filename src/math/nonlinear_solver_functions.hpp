@@ -105,12 +105,40 @@ struct NLSBuilder {
    */
   typedef boost::function<void (const VectorT<T, I>& x, VectorT<T, I>& F)> Function;
 
+  /// A function object that computes a Jacobian-vector product for NonlinearSolver
+  /**
+   * This type is used to supply the product of the Jacobian and a
+   * Vector, \f$\mathbf{J}\left( \mathbf{x} \right) \mathbf{v}\f$,
+   * without forming the Jacobian Matrix.  It is only used if the
+   * NonlinearSolver is configured to be matrix-free.  Typically, it
+   * would loop over network components, each of which contributes
+   * its part of the product, like this
+   *
+   @code{.cpp}
+   void 
+   my_jacobian_product(const Vector& x, const Vector& v, Vector& Jv)
+   {
+   // ...      
+   Jv.ready();
+   }
+   JacobianProductBuilder jv = my_jacobian_product;
+   @endcode
+   *
+   * If a matrix-free NonlinearSolver is not given one of these, the
+   * product is approximated by finite differences of the Function.
+   */
+  typedef boost::function<void (const VectorT<T, I>& x, 
+                                const VectorT<T, I>& v, 
+                                VectorT<T, I>& Jv)> JacobianProduct;
+
 };
 
 typedef NLSBuilder<ComplexType>::Jacobian ComplexJacobianBuilder;
 typedef NLSBuilder<ComplexType>::Function ComplexFunctionBuilder;
 typedef NLSBuilder<RealType>::Jacobian RealJacobianBuilder;
 typedef NLSBuilder<RealType>::Function RealFunctionBuilder;
+typedef NLSBuilder<ComplexType>::JacobianProduct ComplexJacobianProductBuilder;
+typedef NLSBuilder<RealType>::JacobianProduct RealJacobianProductBuilder;
 
 
 } // namespace math
@@ -48,6 +48,7 @@ public:
   typedef typename NonlinearSolverInterface<T, I>::MatrixType MatrixType;
   typedef typename NLSBuilder<T, I>::Jacobian JacobianBuilder;
   typedef typename NLSBuilder<T, I>::Function FunctionBuilder;
+  typedef typename NLSBuilder<T, I>::JacobianProduct JacobianProductBuilder;
 
   /// A functor to keep smart pointers from deleting their pointer
   struct null_deleter
@@ -68,9 +69,14 @@ public:
       p_X((VectorType *)NULL, null_deleter()),  // pointer set by solve()
       p_jacobian(form_jacobian), 
       p_function(form_function),
+      p_jvProduct(),
       p_solutionTolerance(1.0e-05),
-    p_functionTolerance(1.0e-10),
-    p_maxIterations(50)
+      p_functionTolerance(1.0e-10),
+      p_maxIterations(50),
+      p_matrixFree(false),
+      p_preconditionerInterval(1),
+      p_stats(),
+      p_verbose(false)
   {
     p_F.reset(new VectorType(this->communicator(), local_size));
     // std::cout << this->processor_rank() << ": "
@@ -92,9 +98,14 @@ public:
       p_X((VectorType *)NULL, null_deleter()),  // pointer set by solve()
       p_jacobian(form_jacobian), 
       p_function(form_function),
+      p_jvProduct(),
       p_solutionTolerance(1.0e-05),
       p_functionTolerance(1.0e-10),
-      p_maxIterations(50)
+      p_maxIterations(50),
+      p_matrixFree(false),
+      p_preconditionerInterval(1),
+      p_stats(),
+      p_verbose(false)
   {
     p_F.reset(new VectorType(this->communicator(), J.localRows()));
   }
@@ -124,6 +135,9 @@ protected:
   /// A thing to build the RHS
   FunctionBuilder p_function;
 
+  /// A thing to compute Jacobian-vector products (optional)
+  JacobianProductBuilder p_jvProduct;
+
   /// The solution residual norm tolerance
   double p_solutionTolerance;
 
@@ -133,6 +147,36 @@ protected:
   /// The maximum number of iterations to perform
   int p_maxIterations;
 
+  /// Use the Jacobian only through products, if possible
+  bool p_matrixFree;
+
+  /// In matrix-free mode, number of iterations between Jacobian (preconditioner) builds
+  int p_preconditionerInterval;
+
+  /// Convergence and timing information
+  SolverStatistics p_stats;
+
+  /// Print convergence information for each solve
+  bool p_verbose;
+
+  /// Get convergence and timing information (specialized)
+  const SolverStatistics& p_statistics(void) const
+  {
+    return p_stats;
+  }
+
+  /// Discard collected convergence and timing information (specialized)
+  void p_resetStatistics(void)
+  {
+    p_stats.reset();
+  }
+
+  /// Supply a Jacobian-vector product (specialized)
+  void p_jacobianProduct(JacobianProductBuilder jv)
+  {
+    p_jvProduct = jv;
+  }
+
   /// Get the solution tolerance (specialized)
   double p_tolerance(void) const
   {
@@ -171,7 +215,12 @@ protected:
       p_solutionTolerance = props->get("SolutionTolerance", p_solutionTolerance);
       p_functionTolerance = props->get("FunctionTolerance", p_functionTolerance);
       p_maxIterations = props->get("MaxIterations", p_maxIterations);
+      p_matrixFree = props->get("MatrixFree", p_matrixFree);
+      p_verbose = props->get("Verbose", p_verbose);
+      p_preconditionerInterval = 
+        props->get("PreconditionerInterval", p_preconditionerInterval);
     }
+    if (p_preconditionerInterval < 1) p_preconditionerInterval = 1;
   }
 
 };
@@ -22,6 +22,8 @@
 
 #include <gridpack/math/vector.hpp>
 #include <gridpack/math/matrix.hpp>
+#include <gridpack/math/nonlinear_solver_functions.hpp>
+#include <gridpack/math/solver_statistics.hpp>
 
 namespace gridpack {
 namespace math {
@@ -51,6 +53,7 @@ public:
 
   typedef VectorT<T, I> VectorType;
   typedef MatrixT<T, I> MatrixType;
+  typedef typename NLSBuilder<T, I>::JacobianProduct JacobianProductBuilder;
 
   /// Default constructor.
   NonlinearSolverInterface()
@@ -109,6 +112,18 @@ public:
     p_maximumIterations(n);
   }
 
+  /// Supply a Jacobian-vector product for matrix-free solution
+  /** 
+   * This is only used if the solver is configured with @c
+   * MatrixFree.  It must be called before configure().
+   * 
+   * @param jv function to compute the Jacobian-vector product
+   */
+  void jacobianProduct(JacobianProductBuilder jv)
+  {
+    p_jacobianProduct(jv);
+  }
+
   /// Solve w/ the specified initial estimated, put result in same vector
   /** 
    * This solves the system of nonlinear equations using the contents
@@ -122,6 +137,18 @@ public:
     p_solve(x);
   }
 
+  /// Get convergence and timing information collected by solves
+  const SolverStatistics& statistics(void) const
+  {
+    return p_statistics();
+  }
+
+  /// Discard collected convergence and timing information
+  void resetStatistics(void)
+  {
+    p_resetStatistics();
+  }
+
 protected:
 
   /// Get the solution tolerance (specialized)
@@ -136,8 +163,17 @@ protected:
   /// Set the maximum solution iterations  (specialized)
   virtual void p_maximumIterations(const int& n) = 0;
 
+  /// Supply a Jacobian-vector product (specialized)
+  virtual void p_jacobianProduct(JacobianProductBuilder jv) = 0;
+
   /// Solve w/ the specified initial estimated, put result in same vector
   virtual void p_solve(VectorType& x) = 0;
+
+  /// Get convergence and timing information (specialized)
+  virtual const SolverStatistics& p_statistics(void) const = 0;
+
+  /// Discard collected convergence and timing information (specialized)
+  virtual void p_resetStatistics(void) = 0;
   
 };
 
@@ -21,7 +21,9 @@
 #ifndef _petsc_dae_solver_implementation_hpp_
 #define _petsc_dae_solver_implementation_hpp_
 
+#include <cmath>
 #include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <petscts.h>
 
 #include "petsc_exception.hpp"
@@ -49,6 +51,9 @@ public:
   typedef typename DAESolverImplementation<T, I>::JacobianBuilder JacobianBuilder;
   typedef typename DAESolverImplementation<T, I>::FunctionBuilder FunctionBuilder;
   typedef typename DAESolverImplementation<T, I>::StepFunction StepFunction;
+  typedef typename DAESolverImplementation<T, I>::EventFunction EventFunction;
+  typedef typename DAESolverImplementation<T, I>::EventHandler EventHandler;
+  typedef typename DAESolverImplementation<T, I>::TimeEvent TimeEvent;
 
 
   /// Default constructor.
@@ -59,7 +64,9 @@ public:
     : DAESolverImplementation<T, I>(comm, local_size, jbuilder, fbuilder),
       PETScConfigurable(this->communicator()),
       p_ts(),
-      p_petsc_J(NULL)
+      p_petsc_J(NULL),
+      p_initialStep(0.0),
+      p_eventsInstalled(false)
   {
     
   }
@@ -88,6 +95,12 @@ protected:
   /// The Jacobian matrix
   Mat *p_petsc_J;
 
+  /// The initial time step, used to restart after events
+  double p_initialStep;
+
+  /// Have state events been given to the TS
+  bool p_eventsInstalled;
+
   /// Do what is necessary to build this instance
   void p_build(const std::string& option_prefix)
   {
@@ -119,6 +132,31 @@ protected:
       ierr = TSSetProblemType(p_ts, TS_NONLINEAR); CHKERRXX(ierr);
       // ierr = TSSetExactFinalTime(p_ts, TS_EXACTFINALTIME_MATCHSTEP); CHKERRXX(ierr);
 
+      // adaptive step settings from the configuration; these can
+      // still be overridden by options
+      TSAdapt adapt;
+      ierr = TSGetAdapt(p_ts, &adapt); CHKERRXX(ierr);
+      if (this->p_adaptiveSet) {
+        ierr = TSAdaptSetType(adapt, (this->p_adaptive ? TSADAPTBASIC : TSADAPTNONE));
+        CHKERRXX(ierr);
+      }
+      if (this->p_relativeTolerance > 0.0 || this->p_absoluteTolerance > 0.0) {
+        ierr = TSSetTolerances(p_ts, 
+                               (this->p_absoluteTolerance > 0.0 ? 
+                                this->p_absoluteTolerance : PETSC_DECIDE), NULL,
+                               (this->p_relativeTolerance > 0.0 ? 
+                                this->p_relativeTolerance : PETSC_DECIDE), NULL);
+        CHKERRXX(ierr);
+      }
+      if (this->p_minimumTimeStep > 0.0 || this->p_maximumTimeStep > 0.0) {
+        ierr = TSAdaptSetStepLimits(adapt,
+                                    (this->p_minimumTimeStep > 0.0 ?
+                                     this->p_minimumTimeStep : PETSC_DECIDE),
+                                    (this->p_maximumTimeStep > 0.0 ?
+                                     this->p_maximumTimeStep : PETSC_DECIDE));
+        CHKERRXX(ierr);
+      }
+
       ierr = TSSetFromOptions(p_ts); CHKERRXX(ierr);
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
@@ -147,46 +185,123 @@ protected:
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
     }
-  
+    p_initialStep = deltat0;
+    this->p_resetTimeEvents(t0);
   }                                      
 
+  /// Give state events to the TS, if necessary
+  void p_installStateEvents(void)
+  {
+    if (!this->p_stateEventsChanged) return;
+    if (p_eventsInstalled) {
+      throw gridpack::Exception("DAESolver: state events cannot be changed after the first solve()");
+    }
+#if PETSC_VERSION_LT(3,7,0)
+    if (!this->p_stateEvents.empty()) {
+      throw gridpack::Exception("DAESolver: state events require PETSc 3.7 or newer");
+    }
+#else
+    PetscErrorCode ierr(0);
+    int n(this->p_stateEvents.size());
+    if (n > 0) {
+      std::vector<PetscInt> direction(n);
+      std::vector<PetscBool> terminate(n);
+      for (int i = 0; i < n; ++i) {
+        direction[i] = this->p_stateEvents[i].direction;
+        terminate[i] = (this->p_stateEvents[i].terminate ? PETSC_TRUE : PETSC_FALSE);
+      }
+      try {
+        ierr = TSSetEventHandler(p_ts, n, &direction[0], &terminate[0],
+                                 EventIndicator, PostEvent, this); 
+        CHKERRXX(ierr);
+      } catch (const PETSC_EXCEPTION_TYPE& e) {
+        throw PETScException(ierr, e);
+      }
+      p_eventsInstalled = true;
+    }
+#endif
+    this->p_stateEventsChanged = false;
+  }
+
+  /// Call a time event handler and restart
+  void p_handleTimeEvent(TimeEvent& event, const double& t)
+  {
+    PetscErrorCode ierr(0);
+    try {
+      Vec u;
+      ierr = TSGetSolution(p_ts, &u); CHKERRXX(ierr);
+      boost::scoped_ptr<VectorType> 
+        x(new VectorType(new PETScVectorImplementation<T, I>(u, false)));
+      event.done = true;
+      event.handler(t, *x);
+      ierr = TSSetTimeStep(p_ts, p_initialStep); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+  }
 
   /// Solve the system
+  /**
+   * If there are time events before @c maxtime, the TS is run to each
+   * in turn, exactly, and restarted after the event is handled. 
+   */
   void p_solve(double& maxtime, int& maxsteps)
   {
     PetscErrorCode ierr(0);
     try {
-      ierr = TSSetDuration(p_ts, maxsteps, maxtime); CHKERRXX(ierr);
-      ierr = TSSetExactFinalTime(p_ts, TS_EXACTFINALTIME_MATCHSTEP); CHKERRXX(ierr); 
-      ierr = TSSolve(p_ts, PETSC_NULL);
-      // std::cout << this->processor_rank() << ": "
-      //           << "DAESolver::solve() returned " << ierr 
-      //           << std::endl;
-      CHKERRXX(ierr);
+      p_installStateEvents();
+
+      double t0(SolverStatistics::now());
+      TSConvergedReason reason(TS_CONVERGED_ITERATING);
+      PetscInt steps(0), lits(0);
+      PetscReal tlast;
+      ierr = TSGetTime(p_ts, &tlast); CHKERRXX(ierr);
+
+      while (steps < maxsteps) {
+        TimeEvent *next(this->p_nextTimeEvent(maxtime));
+        double tstop(next ? next->time : maxtime);
+
+        ierr = TSSetDuration(p_ts, maxsteps - steps, tstop); CHKERRXX(ierr);
+        ierr = TSSetExactFinalTime(p_ts, TS_EXACTFINALTIME_MATCHSTEP); CHKERRXX(ierr); 
+        ierr = TSSolve(p_ts, PETSC_NULL); CHKERRXX(ierr);
+
+        PetscInt nstep, its;
+        ierr = TSGetConvergedReason(p_ts, &reason); CHKERRXX(ierr);
+        ierr = TSGetTimeStepNumber(p_ts, &nstep); CHKERRXX(ierr);
+        ierr = TSGetKSPIterations(p_ts, &its); CHKERRXX(ierr);
+        ierr = TSGetSolveTime(p_ts, &tlast); CHKERRXX(ierr);
+        steps += nstep;
+        lits += its;
+
+        if (reason < 0 || next == NULL) break;
+
+        // stopped short (step limit or terminating state event)
+        if (tlast < tstop - 1.0e-12*std::max(1.0, std::abs(tstop))) break;
 
-      TSConvergedReason reason;
-      ierr = TSGetConvergedReason(p_ts, &reason); CHKERRXX(ierr);
+        p_handleTimeEvent(*next, tstop);
+        if (tstop >= maxtime) break;
+      }
+      maxsteps = steps;
 
-      PetscInt nstep;
-      ierr = TSGetTimeStepNumber(p_ts,&nstep);CHKERRXX(ierr);
-      maxsteps = nstep;
+      this->p_stats.solveTime += SolverStatistics::now() - t0;
+      this->p_stats.record(steps, reason, 0.0);
+      this->p_stats.recordLinear(lits);
 
       if (reason >= 0) {
 
-        PetscReal tlast;
-        ierr = TSGetSolveTime(p_ts,&tlast);CHKERRXX(ierr);
         maxtime = tlast;
       
-        std::cout << this->processor_rank() << ": "
-                  << "PETSc DAE Solver converged after " << maxsteps << " steps, "
-                  << "actual time = " << maxtime
-                  << std::endl;
+        if (this->p_verbose) {
+          std::cout << this->processor_rank() << ": "
+                    << "PETSc DAE Solver converged after " << maxsteps << " steps, "
+                    << "actual time = " << maxtime
+                    << std::endl;
+        }
 
       } else {
         boost::format f("%d: PETSc DAE Solver diverged after %d steps, reason : %d");
         std::string msg = 
           boost::str(f % this->processor_rank() % maxsteps % reason );
-        std::cerr << msg << std::cerr;
         throw gridpack::Exception(msg);
       }
     
@@ -303,6 +418,52 @@ protected:
     return ierr;
   }
 
+#if PETSC_VERSION_GE(3,7,0)
+
+  /// Routine to compute state event indicators for PETSc
+  static PetscErrorCode EventIndicator(TS ts, PetscReal t, Vec U, 
+                                       PetscScalar *fvalue, void *dummy)
+  {
+    PetscErrorCode ierr(0);
+
+    // Necessary C cast
+    PETScDAESolverImplementation *solver =
+      (PETScDAESolverImplementation *)dummy;
+
+    boost::scoped_ptr<VectorType> 
+      utmp(new VectorType(new PETScVectorImplementation<T, I>(U, false)));
+
+    for (size_t i = 0; i < solver->p_stateEvents.size(); ++i) {
+      fvalue[i] = solver->p_stateEvents[i].indicator(t, *utmp);
+    }
+    return ierr;
+  }
+
+  /// Routine called by PETSc when state events have been located
+  static PetscErrorCode PostEvent(TS ts, PetscInt nevents, PetscInt event_list[],
+                                  PetscReal t, Vec U, PetscBool forward, 
+                                  void *dummy)
+  {
+    PetscErrorCode ierr(0);
+
+    // Necessary C cast
+    PETScDAESolverImplementation *solver =
+      (PETScDAESolverImplementation *)dummy;
+
+    boost::scoped_ptr<VectorType> 
+      utmp(new VectorType(new PETScVectorImplementation<T, I>(U, false)));
+
+    for (PetscInt i = 0; i < nevents; ++i) {
+      solver->p_stateEvents[event_list[i]].handler(t, *utmp);
+    }
+
+    // restart with a small step after the discontinuity
+    ierr = TSSetTimeStep(ts, solver->p_initialStep); CHKERRQ(ierr);
+    return ierr;
+  }
+
+#endif
+
   /// Routine called before each time step
   static PetscErrorCode PreTimeStep(TS ts)
   {
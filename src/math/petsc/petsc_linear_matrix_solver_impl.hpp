@@ -212,6 +212,21 @@ protected:
       MatFactorInfo  info;
       IS perm, iperm;
 
+      // Most external packages cannot factor block sparse (BAIJ)
+      // matrices, so give them a point (AIJ) copy
+      Mat Apoint(PETSC_NULL);
+      PetscBool isbaij(PETSC_FALSE), available(PETSC_TRUE);
+      ierr = PetscObjectTypeCompareAny((PetscObject)(*A), &isbaij,
+                                       MATSEQBAIJ, MATMPIBAIJ, ""); CHKERRXX(ierr);
+      if (isbaij) {
+        ierr = MatGetFactorAvailable(*A, p_solverPackage, p_factorType, &available);
+        CHKERRXX(ierr);
+      }
+      if (!available) {
+        ierr = MatConvert(*A, MATAIJ, MAT_INITIAL_MATRIX, &Apoint); CHKERRXX(ierr);
+        A = &Apoint;
+      }
+
       ierr = MatGetOrdering(*A, p_orderingType, &perm, &iperm); CHKERRXX(ierr);
       ierr = MatGetFactor(*A, p_solverPackage, p_factorType, &p_Fmat);CHKERRXX(ierr);
       info.fill = p_fill;
@@ -222,6 +237,9 @@ protected:
 
       ierr = ISDestroy(&perm); CHKERRXX(ierr);
       ierr = ISDestroy(&iperm); CHKERRXX(ierr);
+      if (Apoint != PETSC_NULL) {
+        ierr = MatDestroy(&Apoint); CHKERRXX(ierr);
+      }
 
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
@@ -229,21 +247,65 @@ protected:
     p_factored = true;
   }
 
+  /// Is a RHS or solution matrix dense?
+  /**
+   * MatMatSolve() only accepts dense matrices.
+   */
+  bool p_isDense(const Mat& M) const
+  {
+    PetscErrorCode ierr(0);
+    PetscBool dense;
+    try {
+      ierr = PetscObjectTypeCompareAny((PetscObject)M, &dense,
+                                       MATSEQDENSE, MATMPIDENSE, ""); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    return dense;
+  }
+
+  /// Throw an exception unless a RHS or solution matrix is dense
+  void p_checkDense(const Mat& M, const char *name) const
+  {
+    if (!p_isDense(M)) {
+      PetscErrorCode ierr(0);
+      MatType mtype;
+      try {
+        ierr = MatGetType(M, &mtype); CHKERRXX(ierr);
+      } catch (const PETSC_EXCEPTION_TYPE& e) {
+        throw PETScException(ierr, e);
+      }
+      std::string msg = 
+        boost::str(boost::format("%s: solve: %s must be Dense, not \"%s\"") %
+                   this->configurationKey() % name % mtype);
+      throw Exception(msg);
+    }
+  }
+
   /// Solve w/ the specified RHS Matrix (specialized)
   MatrixType *p_solve(const MatrixType& B) const
   {
     PetscErrorCode ierr(0);
     Mat X;
 
-    // FIXME: enforce B is dense, or copy and convert
     const Mat *Bmat(PETScMatrix(B));
 
     try {
       if (!p_factored) {
         p_factor();
       }
+      // MatMatSolve() needs a dense RHS, so make a dense copy of
+      // anything else; the result is dense either way
+      Mat Bdense(PETSC_NULL);
+      if (!p_isDense(*Bmat)) {
+        ierr = MatConvert(*Bmat, MATDENSE, MAT_INITIAL_MATRIX, &Bdense); CHKERRXX(ierr);
+        Bmat = &Bdense;
+      }
       ierr = MatDuplicate(*Bmat, MAT_DO_NOT_COPY_VALUES, &X); CHKERRXX(ierr);
       ierr = MatMatSolve(p_Fmat, *Bmat, X); CHKERRXX(ierr);
+      if (Bdense != PETSC_NULL) {
+        ierr = MatDestroy(&Bdense); CHKERRXX(ierr);
+      }
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
     }
@@ -261,6 +323,26 @@ protected:
     return result;
   }
 
+  /// Solve w/ the specified RHS Matrix, in place (specialized)
+  void p_solve(const MatrixType& B, MatrixType& X) const
+  {
+    PetscErrorCode ierr(0);
+
+    const Mat *Bmat(PETScMatrix(B));
+    Mat *Xmat(PETScMatrix(X));
+    p_checkDense(*Bmat, "B");
+    p_checkDense(*Xmat, "X");
+
+    try {
+      if (!p_factored) {
+        p_factor();
+      }
+      ierr = MatMatSolve(p_Fmat, *Bmat, *Xmat); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+  }
+
 };
 
 template <typename T, typename I>
@@ -42,9 +42,29 @@ LinearSolverT<T, I>::LinearSolverT(LinearSolverT<T, I>::MatrixType& A)
   // empty
 }
 
+template <typename T, typename I>
+LinearSolverT<T, I>::LinearSolverT(LinearSolverT<T, I>::MatrixType& A,
+                                   LinearSolverAnalysisPtr analysis)
+  : parallel::WrappedDistributed(),
+    utility::WrappedConfigurable(),
+    utility::Uncopyable(),
+    p_solver(new PETScLinearSolverImplementation<T, I>(A, analysis))
+{
+  p_setDistributed(p_solver.get());
+  p_setConfigurable(p_solver.get());
+}
+
 template
 LinearSolverT<ComplexType>::LinearSolverT(LinearSolverT<ComplexType>::MatrixType& A);
 
+template
+LinearSolverT<ComplexType>::LinearSolverT(LinearSolverT<ComplexType>::MatrixType& A,
+                                          LinearSolverAnalysisPtr analysis);
+
+template
+LinearSolverT<RealType>::LinearSolverT(LinearSolverT<RealType>::MatrixType& A,
+                                       LinearSolverAnalysisPtr analysis);
+
 template
 LinearSolverT<RealType>::LinearSolverT(LinearSolverT<RealType>::MatrixType& A);
 
@@ -0,0 +1,244 @@
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   petsc_linear_solver_analysis.cpp
+ *
+ * @brief  PETSc specific part of LinearSolverAnalysis
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#include <boost/functional/hash.hpp>
+#include "petsc/petsc_exception.hpp"
+#include "petsc/petsc_linear_solver_analysis.hpp"
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  class LinearSolverAnalysisImplementation
+// -------------------------------------------------------------
+
+// -------------------------------------------------------------
+// LinearSolverAnalysisImplementation:: constructors / destructor
+// -------------------------------------------------------------
+LinearSolverAnalysisImplementation::LinearSolverAnalysisImplementation(void)
+  : utility::Uncopyable(),
+    p_haveKSP(false),
+    p_haveMatrix(false),
+    p_matrixType(),
+    p_nSymbolic(0),
+    p_nNumeric(0)
+{
+  p_fingerprint[0] = 0;
+  p_fingerprint[1] = 0;
+}
+
+LinearSolverAnalysisImplementation::~LinearSolverAnalysisImplementation(void)
+{
+  PetscErrorCode ierr(0);
+  try {
+    PetscBool ok;
+    ierr = PetscInitialized(&ok);
+    if (ok) {
+      if (p_haveMatrix) {
+        ierr = MatDestroy(&p_matrix); CHKERRXX(ierr);
+      }
+      if (p_haveKSP) {
+        ierr = KSPDestroy(&p_KSP); CHKERRXX(ierr);
+      }
+    }
+  } catch (...) {
+    // just eat it
+  }
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysisImplementation::solver
+// -------------------------------------------------------------
+KSP
+LinearSolverAnalysisImplementation::solver(void)
+{
+  PetscErrorCode ierr(0);
+  try {
+    ierr = PetscObjectReference((PetscObject)p_KSP); CHKERRXX(ierr);
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+  return p_KSP;
+}
+
+void
+LinearSolverAnalysisImplementation::solver(KSP ksp)
+{
+  PetscErrorCode ierr(0);
+  try {
+    ierr = PetscObjectReference((PetscObject)ksp); CHKERRXX(ierr);
+    if (p_haveKSP) {
+      ierr = KSPDestroy(&p_KSP); CHKERRXX(ierr);
+    }
+    p_KSP = ksp;
+    p_haveKSP = true;
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysisImplementation::p_computeFingerprint
+// -------------------------------------------------------------
+void
+LinearSolverAnalysisImplementation::p_computeFingerprint(Mat A,
+                                                         unsigned long *fp)
+{
+  PetscErrorCode ierr(0);
+  try {
+    PetscInt lo, hi, ncols;
+    const PetscInt *cols;
+    std::size_t h(0);
+    unsigned long nnz(0);
+
+    ierr = MatGetOwnershipRange(A, &lo, &hi); CHKERRXX(ierr);
+    boost::hash_combine(h, lo);
+    boost::hash_combine(h, hi);
+    for (PetscInt i = lo; i < hi; ++i) {
+      ierr = MatGetRow(A, i, &ncols, &cols, NULL); CHKERRXX(ierr);
+      boost::hash_combine(h, i);
+      for (PetscInt j = 0; j < ncols; ++j) {
+        boost::hash_combine(h, cols[j]);
+      }
+      nnz += ncols;
+      ierr = MatRestoreRow(A, i, &ncols, &cols, NULL); CHKERRXX(ierr);
+    }
+
+    // the sum of local hashes is independent of the order in which
+    // processes contribute, so all processes get the same result
+    unsigned long local[2];
+    local[0] = static_cast<unsigned long>(h);
+    local[1] = nnz;
+    MPI_Comm comm;
+    ierr = PetscObjectGetComm((PetscObject)A, &comm); CHKERRXX(ierr);
+    ierr = MPI_Allreduce(local, fp, 2, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+    CHKERRXX(ierr);
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysisImplementation::setOperators
+// -------------------------------------------------------------
+void
+LinearSolverAnalysisImplementation::setOperators(Mat A)
+{
+  PetscErrorCode ierr(0);
+  try {
+    MatType atype;
+    ierr = MatGetType(A, &atype); CHKERRXX(ierr);
+    unsigned long fp[2];
+    p_computeFingerprint(A, &fp[0]);
+
+    bool same(p_haveMatrix &&
+              p_matrixType == atype &&
+              fp[0] == p_fingerprint[0] &&
+              fp[1] == p_fingerprint[1]);
+
+    if (same) {
+      ierr = MatCopy(A, p_matrix, SAME_NONZERO_PATTERN); CHKERRXX(ierr);
+    } else {
+      if (p_haveMatrix) {
+        ierr = MatDestroy(&p_matrix); CHKERRXX(ierr);
+      }
+      ierr = MatDuplicate(A, MAT_COPY_VALUES, &p_matrix); CHKERRXX(ierr);
+      p_haveMatrix = true;
+      p_matrixType = atype;
+      p_fingerprint[0] = fp[0];
+      p_fingerprint[1] = fp[1];
+      p_nSymbolic++;
+    }
+#if PETSC_VERSION_LT(3,5,0)
+    ierr = KSPSetOperators(p_KSP, p_matrix, p_matrix,
+                           (same ? SAME_NONZERO_PATTERN : DIFFERENT_NONZERO_PATTERN));
+    CHKERRXX(ierr);
+#else
+    ierr = KSPSetOperators(p_KSP, p_matrix, p_matrix); CHKERRXX(ierr);
+#endif
+    p_nNumeric++;
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysisImplementation::reset
+// -------------------------------------------------------------
+void
+LinearSolverAnalysisImplementation::reset(void)
+{
+  PetscErrorCode ierr(0);
+  try {
+    if (p_haveMatrix) {
+      ierr = MatDestroy(&p_matrix); CHKERRXX(ierr);
+    }
+    p_haveMatrix = false;
+    p_matrixType.clear();
+    p_fingerprint[0] = 0;
+    p_fingerprint[1] = 0;
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+// -------------------------------------------------------------
+//  class LinearSolverAnalysis
+// -------------------------------------------------------------
+
+// -------------------------------------------------------------
+// LinearSolverAnalysis:: constructors / destructor
+// -------------------------------------------------------------
+LinearSolverAnalysis::LinearSolverAnalysis(const parallel::Communicator& comm)
+  : parallel::Distributed(comm),
+    utility::Uncopyable(),
+    p_impl(new LinearSolverAnalysisImplementation())
+{
+}
+
+LinearSolverAnalysis::~LinearSolverAnalysis(void)
+{
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysis::symbolicFactorizations
+// -------------------------------------------------------------
+int
+LinearSolverAnalysis::symbolicFactorizations(void) const
+{
+  return p_impl->symbolicFactorizations();
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysis::numericFactorizations
+// -------------------------------------------------------------
+int
+LinearSolverAnalysis::numericFactorizations(void) const
+{
+  return p_impl->numericFactorizations();
+}
+
+// -------------------------------------------------------------
+// LinearSolverAnalysis::reset
+// -------------------------------------------------------------
+void
+LinearSolverAnalysis::reset(void)
+{
+  p_impl->reset();
+}
+
+} // namespace math
+} // namespace gridpack
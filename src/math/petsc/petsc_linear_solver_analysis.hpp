@@ -0,0 +1,115 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   petsc_linear_solver_analysis.hpp
+ *
+ * @brief  PETSc specific part of LinearSolverAnalysis
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _petsc_linear_solver_analysis_hpp_
+#define _petsc_linear_solver_analysis_hpp_
+
+#include <string>
+#include <petscksp.h>
+#include "linear_solver_analysis.hpp"
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  class LinearSolverAnalysisImplementation
+// -------------------------------------------------------------
+/// Keeps a PETSc KSP and a private copy of its coefficient matrix
+/**
+ * PETSc only does a numeric refactorization if the operator given to
+ * KSPSetOperators() is the same Mat with the same nonzero state.  A
+ * new Mat, even one with an identical pattern, causes the
+ * preconditioner (e.g. LU) to redo the ordering and symbolic
+ * factorization.  So, the KSP here is always handed the same private
+ * Mat.  Coefficient values are copied into it with MatCopy() using
+ * SAME_NONZERO_PATTERN, which does not change its nonzero state.
+ */
+class LinearSolverAnalysisImplementation
+  : private utility::Uncopyable
+{
+public:
+
+  /// Default constructor.
+  LinearSolverAnalysisImplementation(void);
+
+  /// Destructor
+  ~LinearSolverAnalysisImplementation(void);
+
+  /// Has a KSP been assigned
+  bool haveSolver(void) const
+  {
+    return p_haveKSP;
+  }
+
+  /// Get the KSP (a reference is added, caller must KSPDestroy)
+  KSP solver(void);
+
+  /// Adopt a KSP to share (a reference is added)
+  void solver(KSP ksp);
+
+  /// Make the specified matrix the KSP operator, reusing analysis if possible
+  void setOperators(Mat A);
+
+  /// Discard the cached matrix and pattern
+  void reset(void);
+
+  /// Number of times a new pattern was seen
+  int symbolicFactorizations(void) const
+  {
+    return p_nSymbolic;
+  }
+
+  /// Number of times new values were set
+  int numericFactorizations(void) const
+  {
+    return p_nNumeric;
+  }
+
+protected:
+
+  /// The shared KSP
+  KSP p_KSP;
+
+  /// Has ::p_KSP been assigned
+  bool p_haveKSP;
+
+  /// Private copy of the coefficient matrix
+  Mat p_matrix;
+
+  /// Has ::p_matrix been created
+  bool p_haveMatrix;
+
+  /// The type of ::p_matrix
+  std::string p_matrixType;
+
+  /// Global pattern fingerprint of ::p_matrix
+  unsigned long p_fingerprint[2];
+
+  /// Number of times a new pattern was seen
+  int p_nSymbolic;
+
+  /// Number of times new values were set
+  int p_nNumeric;
+
+  /// Compute a global fingerprint (hash, nonzero count) of the pattern of A
+  static void p_computeFingerprint(Mat A, unsigned long *fp);
+};
+
+} // namespace math
+} // namespace gridpack
+
+#endif
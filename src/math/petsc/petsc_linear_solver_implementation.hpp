@@ -28,6 +28,9 @@
 #include "petsc_configurable.hpp"
 #include "petsc/petsc_matrix_extractor.hpp"
 #include "petsc/petsc_vector_extractor.hpp"
+#include "petsc/petsc_linear_solver_analysis.hpp"
+#include "sparse_lu.hpp"
+#include "small_matrix.hpp"
 
 namespace gridpack {
 namespace math {
@@ -50,7 +53,35 @@ public:
   PETScLinearSolverImplementation(MatrixType& A)
     : LinearSolverImplementation<T, I>(A),
       PETScConfigurable(this->communicator()),
-      p_matrixSet(false)
+      p_KSP(NULL),
+      p_matrixSet(false),
+      p_analysis(),
+      p_useNativeLU(false),
+      p_mixedPrecision(false),
+      p_refineTolerance(1.0e-12),
+      p_refineMaxIterations(10),
+      p_refineFailed(false),
+      p_blockDiagonal(false),
+      p_blockSize(1),
+      p_pointMatrix(PETSC_NULL)
+  {
+  }
+
+  /// Construct a solver that uses a shared ordering/symbolic factorization
+  PETScLinearSolverImplementation(MatrixType& A, LinearSolverAnalysisPtr analysis)
+    : LinearSolverImplementation<T, I>(A),
+      PETScConfigurable(this->communicator()),
+      p_KSP(NULL),
+      p_matrixSet(false),
+      p_analysis(analysis),
+      p_useNativeLU(false),
+      p_mixedPrecision(false),
+      p_refineTolerance(1.0e-12),
+      p_refineMaxIterations(10),
+      p_refineFailed(false),
+      p_blockDiagonal(false),
+      p_blockSize(1),
+      p_pointMatrix(PETSC_NULL)
   {
   }
 
@@ -63,6 +94,9 @@ public:
       ierr = PetscInitialized(&ok);
       if (ok) {
         ierr = KSPDestroy(&p_KSP); CHKERRXX(ierr);
+        if (p_pointMatrix != PETSC_NULL) {
+          ierr = MatDestroy(&p_pointMatrix); CHKERRXX(ierr);
+        }
       }
     } catch (...) {
       // just eat it
@@ -78,11 +112,72 @@ protected:
   /// For constant matrices, has the coefficient matrix been set
   mutable bool p_matrixSet;
 
+  /// Shared ordering and symbolic factorization, if any
+  LinearSolverAnalysisPtr p_analysis;
+
+  /// Use the built-in serial sparse LU instead of a KSP
+  bool p_useNativeLU;
+
+  /// The built-in sparse LU factorization
+  mutable SparseLU<PetscScalar> p_lu;
+
+  /// A place for PETSc to put the KSP residual history
+  mutable std::vector<PetscReal> p_kspHistory;
+
+  /// Single precision type used for mixed precision
+  typedef typename LowPrecision<PetscScalar>::type LowScalar;
+
+  /// Factor in single precision and refine (only w/ built-in LU)
+  bool p_mixedPrecision;
+
+  /// Relative residual needed by mixed precision refinement
+  double p_refineTolerance;
+
+  /// Maximum number of refinement iterations
+  int p_refineMaxIterations;
+
+  /// The single precision factorization
+  mutable SparseLU<LowScalar> p_luLow;
+
+  /// Did refinement fail with the current coefficient matrix
+  mutable bool p_refineFailed;
+
+  /// Work space for refinement
+  mutable std::vector<LowScalar> p_lowWork;
+  mutable std::vector<PetscScalar> p_refineResidual;
+
+  /// Buffers for the CSR form of the coefficient matrix
+  mutable std::vector<int> p_csrRowPtr, p_csrColIdx;
+  mutable std::vector<PetscScalar> p_csrValues;
+
+  /// Is the coefficient matrix Diagonal or BlockDiagonal
+  mutable bool p_blockDiagonal;
+
+  /// The (library) size of the diagonal blocks
+  mutable PetscInt p_blockSize;
+
+  /// Inverses of the local diagonal blocks, each row-major
+  mutable std::vector<PetscScalar> p_blockInverse;
+
+  /// Point (AIJ) copy of a BAIJ coefficient matrix, if one is needed
+  mutable Mat p_pointMatrix;
+
   /// Do what is necessary to build this instance
   void p_build(const std::string& option_prefix)
   {
     PetscErrorCode ierr;
     try  {
+      // No KSP is needed with the built-in LU
+      if (p_useNativeLU) {
+        return;
+      }
+
+      // If the shared analysis already has a KSP, use it as is
+      if (p_analysis && p_analysis->implementation()->haveSolver()) {
+        p_KSP = p_analysis->implementation()->solver();
+        return;
+      }
+
       parallel::Communicator comm(this->communicator());
       if (this->p_doSerial) {
         comm = this->communicator().self();
@@ -105,61 +200,445 @@ protected:
                               LinearSolverImplementation<T, I>::p_maxIterations); CHKERRXX(ierr);
 
       ierr = KSPSetFromOptions(p_KSP);CHKERRXX(ierr);
+
+      if (p_analysis) {
+        p_analysis->implementation()->solver(p_KSP);
+      }
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
     }
   }  
 
-  /// Solve w/ the specified RHS and estimate (result in x)
-  void p_solveImpl(MatrixType& A, const VectorType& b, VectorType& x) const
+  /// Get the matrix the KSP should use for the coefficient matrix
+  /**
+   * Block sparse (BAIJ) matrices are used directly unless the
+   * preconditioner is a factorization from a package that cannot
+   * factor BAIJ (e.g. SuperLU_DIST).  In that case, a point (AIJ)
+   * copy is made, and refreshed each time it is needed.
+   */
+  Mat p_operator(Mat *Amat) const
   {
     PetscErrorCode ierr(0);
-    try {
-      Mat *Amat(PETScMatrix(A));
+    PetscBool isbaij(PETSC_FALSE);
+    ierr = PetscObjectTypeCompareAny((PetscObject)(*Amat), &isbaij,
+                                     MATSEQBAIJ, MATMPIBAIJ, ""); CHKERRXX(ierr);
+    if (!isbaij) return *Amat;
+
+    PC pc;
+    PetscBool islu(PETSC_FALSE), ischol(PETSC_FALSE);
+    ierr = KSPGetPC(p_KSP, &pc); CHKERRXX(ierr);
+    ierr = PetscObjectTypeCompareAny((PetscObject)pc, &islu,
+                                     PCLU, PCILU, ""); CHKERRXX(ierr);
+    ierr = PetscObjectTypeCompareAny((PetscObject)pc, &ischol,
+                                     PCCHOLESKY, PCICC, ""); CHKERRXX(ierr);
+    if (!islu && !ischol) return *Amat;
 
+    MatSolverPackage pkg(PETSC_NULL);
+    PetscBool available(PETSC_FALSE);
+    ierr = PCFactorGetMatSolverPackage(pc, &pkg); CHKERRXX(ierr);
+    ierr = MatGetFactorAvailable(*Amat, (pkg != PETSC_NULL ? pkg : MATSOLVERPETSC),
+                                 (islu ? MAT_FACTOR_LU : MAT_FACTOR_CHOLESKY),
+                                 &available); CHKERRXX(ierr);
+    if (available) return *Amat;
+
+    ierr = MatConvert(*Amat, MATAIJ,
+                      (p_pointMatrix != PETSC_NULL ? MAT_REUSE_MATRIX : MAT_INITIAL_MATRIX),
+                      &p_pointMatrix); CHKERRXX(ierr);
+    return p_pointMatrix;
+  }
+
+  /// Give the coefficient matrix to the KSP, if necessary
+  void p_setOperators(Mat *Amat) const
+  {
+    PetscErrorCode ierr(0);
+    try {
       if (p_matrixSet && this->p_constSerialMatrix) {
         // KSPSetOperators can be skipped
+      } else if (p_analysis) {
+        p_analysis->implementation()->setOperators(p_operator(Amat));
+        p_matrixSet = true;
+        this->p_stats.setups++;
       } else {
+        Mat A(p_operator(Amat));
 #if PETSC_VERSION_LT(3,5,0)
-        ierr = KSPSetOperators(p_KSP, *Amat, *Amat, SAME_NONZERO_PATTERN); CHKERRXX(ierr);
+        ierr = KSPSetOperators(p_KSP, A, A, SAME_NONZERO_PATTERN); CHKERRXX(ierr);
 #else
-        ierr = KSPSetOperators(p_KSP, *Amat, *Amat); CHKERRXX(ierr);
+        ierr = KSPSetOperators(p_KSP, A, A); CHKERRXX(ierr);
 #endif
         p_matrixSet = true;
+        this->p_stats.setups++;
+      }
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+  }
+
+  /// Factor (or refactor) the coefficient matrix with the built-in LU
+  /**
+   * The matrix is extracted row by row into CSR form. If its pattern
+   * matches the last one, only a numeric refactorization, reusing
+   * the previous ordering and pivots, is done.
+   */
+  void p_nativeFactor(Mat A) const
+  {
+    PetscErrorCode ierr(0);
+    double t0(SolverStatistics::now());
+    try {
+      PetscInt nrows, ncols, lo, hi;
+      ierr = MatGetSize(A, &nrows, &ncols); CHKERRXX(ierr);
+      ierr = MatGetOwnershipRange(A, &lo, &hi); CHKERRXX(ierr);
+      if (nrows != ncols || lo != 0 || hi != nrows) {
+        throw Exception("LinearSolver: built-in sparse LU requires a square matrix on one process");
       }
 
-      this->p_resolveImpl(b, x);
-          
+      int n(nrows);
+      std::vector<PetscScalar> previous;
+      previous.swap(p_csrValues);
+      p_csrRowPtr.resize(n + 1);
+      p_csrColIdx.clear();
+      p_csrRowPtr[0] = 0;
+      for (PetscInt i = 0; i < nrows; ++i) {
+        PetscInt nc;
+        const PetscInt *cols;
+        const PetscScalar *vals;
+        ierr = MatGetRow(A, i, &nc, &cols, &vals); CHKERRXX(ierr);
+        p_csrColIdx.insert(p_csrColIdx.end(), cols, cols + nc);
+        p_csrValues.insert(p_csrValues.end(), vals, vals + nc);
+        ierr = MatRestoreRow(A, i, &nc, &cols, &vals); CHKERRXX(ierr);
+        p_csrRowPtr[i+1] = p_csrColIdx.size();
+      }
+
+      // the factorization in use is still good if nothing changed
+      if (p_csrValues == previous) {
+        bool current;
+        if (p_mixedPrecision && !p_refineFailed) {
+          current = (p_luLow.factored() &&
+                     p_luLow.samePattern(n, &p_csrRowPtr[0], &p_csrColIdx[0]));
+        } else {
+          current = (p_lu.factored() &&
+                     p_lu.samePattern(n, &p_csrRowPtr[0], &p_csrColIdx[0]));
+        }
+        if (current) {
+          this->p_stats.setupTime += SolverStatistics::now() - t0;
+          return;
+        }
+      }
+      this->p_stats.setups++;
+
+      if (p_mixedPrecision) {
+        p_refineFailed = false;
+        std::vector<LowScalar> low(p_csrValues.size());
+        for (size_t k = 0; k < low.size(); ++k) {
+          low[k] = static_cast<LowScalar>(p_csrValues[k]);
+        }
+        try {
+          if (!p_luLow.samePattern(n, &p_csrRowPtr[0], &p_csrColIdx[0])) {
+            p_luLow.analyze(n, &p_csrRowPtr[0], &p_csrColIdx[0]);
+            p_luLow.factor(&low[0]);
+          } else if (!p_luLow.factored() || !p_luLow.refactor(&low[0])) {
+            p_luLow.factor(&low[0]);
+          }
+          this->p_stats.setupTime += SolverStatistics::now() - t0;
+          return;
+        } catch (const Exception&) {
+          // singular in single precision, try double
+          p_refineFailed = true;
+          this->p_stats.refinementFallbacks++;
+        }
+      }
+
+      if (!p_lu.samePattern(n, &p_csrRowPtr[0], &p_csrColIdx[0])) {
+        p_lu.analyze(n, &p_csrRowPtr[0], &p_csrColIdx[0]);
+        p_lu.factor(&p_csrValues[0]);
+      } else if (!p_lu.factored() || !p_lu.refactor(&p_csrValues[0])) {
+        p_lu.factor(&p_csrValues[0]);
+      }
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
-    } catch (const Exception& e) {
-      throw e;
     }
+    this->p_stats.setupTime += SolverStatistics::now() - t0;
+  }
+
+  /// Solve w/ the single precision factorization and iterative refinement
+  /**
+   * The correction is computed in single precision, but the residual
+   * \f$\mathbf{r} = \mathbf{b} - \mathbf{A}\mathbf{x}\f$ is always
+   * computed in double precision with the original coefficients.
+   *
+   * @param b right hand side
+   * @param x solution
+   * @param its number of refinement iterations (out)
+   * @param rnorm final residual infinity norm (out)
+   *
+   * @return true if the residual converged to ::p_refineTolerance
+   */
+  bool p_refine(const PetscScalar *b, PetscScalar *x, 
+                int& its, double& rnorm) const
+  {
+    const int n(p_luLow.size());
+    p_lowWork.resize(n);
+    p_refineResidual.resize(n);
+
+    double bnorm(0.0);
+    for (int i = 0; i < n; ++i) {
+      bnorm = std::max<double>(bnorm, std::abs(b[i]));
+      p_refineResidual[i] = b[i];
+      x[i] = 0.0;
+    }
+    its = 0;
+    rnorm = 0.0;
+    if (bnorm == 0.0) return true;
+
+    double rnormold;
+    rnorm = bnorm;
+    for (int it = 0; it <= p_refineMaxIterations; ++it) {
+      its = it + 1;
+      for (int i = 0; i < n; ++i) {
+        p_lowWork[i] = static_cast<LowScalar>(p_refineResidual[i]);
+      }
+      p_luLow.solve(&p_lowWork[0]);
+      for (int i = 0; i < n; ++i) {
+        x[i] += static_cast<PetscScalar>(p_lowWork[i]);
+      }
+
+      // residual in double precision
+      rnormold = rnorm;
+      rnorm = 0.0;
+      for (int i = 0; i < n; ++i) {
+        PetscScalar r(b[i]);
+        for (int k = p_csrRowPtr[i]; k < p_csrRowPtr[i+1]; ++k) {
+          r -= p_csrValues[k]*x[p_csrColIdx[k]];
+        }
+        p_refineResidual[i] = r;
+        rnorm = std::max<double>(rnorm, std::abs(r));
+      }
+      if (rnorm <= p_refineTolerance*bnorm) return true;
+      if (!(rnorm < rnormold)) break;  // stagnating or diverging
+    }
+    return false;
+  }
+
+  /// Is the specified matrix marked as Diagonal or BlockDiagonal
+  static bool p_isBlockDiagonal(const Mat& A)
+  {
+    MatrixStorageType stype;
+    return (PetscMatrixWrapper::storageMark(A, stype) &&
+            (stype == Diagonal || stype == BlockDiagonal));
+  }
+
+  /// "Factor" a Diagonal or BlockDiagonal coefficient matrix
+  /**
+   * All diagonal blocks are local, so they are just inverted, all
+   * at once.
+   */
+  void p_blockDiagonalFactor(Mat A) const
+  {
+    PetscErrorCode ierr(0);
+    double t0(SolverStatistics::now());
+    this->p_stats.setups++;
+    try {
+      PetscInt lo, hi;
+      ierr = MatGetBlockSize(A, &p_blockSize); CHKERRXX(ierr);
+      ierr = MatGetOwnershipRange(A, &lo, &hi); CHKERRXX(ierr);
+      PetscInt bs(p_blockSize), nb((hi - lo)/bs);
+      p_blockInverse.resize(nb*bs*bs);
+      std::vector<PetscInt> idx(bs);
+      for (PetscInt b = 0; b < nb; ++b) {
+        for (PetscInt k = 0; k < bs; ++k) idx[k] = lo + b*bs + k;
+        PetscScalar *blk(&p_blockInverse[b*bs*bs]);
+        ierr = MatGetValues(A, bs, &idx[0], bs, &idx[0], blk); CHKERRXX(ierr);
+      }
+      int bad(-1);
+      if (nb > 0) bad = invertSmallMatrices<PetscScalar>(bs, nb, &p_blockInverse[0]);
+      if (bad >= 0) {
+        std::string msg = 
+          boost::str(boost::format("LinearSolver: diagonal block at row %d is singular") %
+                     (lo + bad*bs));
+        throw Exception(msg);
+      }
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    this->p_stats.setupTime += SolverStatistics::now() - t0;
+  }
+
+  /// Solve w/ the inverted diagonal blocks
+  void p_blockDiagonalResolve(const VectorType& b, VectorType& x) const
+  {
+    PetscErrorCode ierr(0);
+    double t0(SolverStatistics::now());
+    try {
+      const Vec *bvec(PETScVector(b));
+      Vec *xvec(PETScVector(x));
+      const PetscScalar *barray;
+      PetscScalar *xarray;
+      PetscInt n, bs(p_blockSize);
+      ierr = VecGetLocalSize(*bvec, &n); CHKERRXX(ierr);
+      ierr = VecGetArrayRead(*bvec, &barray); CHKERRXX(ierr);
+      ierr = VecGetArray(*xvec, &xarray); CHKERRXX(ierr);
+      for (PetscInt i0 = 0; i0 < n; i0 += bs) {
+        const PetscScalar *blk(&p_blockInverse[i0*bs]);
+        for (PetscInt i = 0; i < bs; ++i) {
+          PetscScalar sum(0.0);
+          for (PetscInt j = 0; j < bs; ++j) {
+            sum += blk[i*bs + j]*barray[i0 + j];
+          }
+          xarray[i0 + i] = sum;
+        }
+      }
+      ierr = VecRestoreArray(*xvec, &xarray); CHKERRXX(ierr);
+      ierr = VecRestoreArrayRead(*bvec, &barray); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    this->p_stats.solveTime += SolverStatistics::now() - t0;
+    this->p_stats.record(1, 0, 0.0);
+  }
+
+  /// Solve w/ the built-in LU and existing factorization
+  void p_nativeResolve(const VectorType& b, VectorType& x) const
+  {
+    PetscErrorCode ierr(0);
+    double t0(SolverStatistics::now());
+    try {
+      const Vec *bvec(PETScVector(b));
+      Vec *xvec(PETScVector(x));
+      PetscScalar *xarray;
+      if (p_mixedPrecision && !p_refineFailed) {
+        const PetscScalar *barray;
+        bool ok;
+        int its;
+        double rnorm;
+        ierr = VecGetArrayRead(*bvec, &barray); CHKERRXX(ierr);
+        ierr = VecGetArray(*xvec, &xarray); CHKERRXX(ierr);
+        ok = p_refine(barray, xarray, its, rnorm);
+        ierr = VecRestoreArray(*xvec, &xarray); CHKERRXX(ierr);
+        ierr = VecRestoreArrayRead(*bvec, &barray); CHKERRXX(ierr);
+        if (ok) {
+          this->p_stats.solveTime += SolverStatistics::now() - t0;
+          this->p_stats.record(its, 0, rnorm);
+          this->p_stats.usedFallback = false;
+          return;
+        }
+
+        // refinement did not converge: factor in double precision
+        // and use that until the coefficient matrix changes
+        p_refineFailed = true;
+        this->p_stats.refinementFallbacks++;
+        if (this->p_verbose && this->processor_rank() == 0) {
+          std::cerr << this->configurationKey() 
+                    << ": mixed precision refinement failed, "
+                    << "using double precision factorization" << std::endl;
+        }
+        int n(p_luLow.size());
+        if (!p_lu.samePattern(n, &p_csrRowPtr[0], &p_csrColIdx[0])) {
+          p_lu.analyze(n, &p_csrRowPtr[0], &p_csrColIdx[0]);
+        }
+        p_lu.factor(&p_csrValues[0]);
+      }
+      ierr = VecCopy(*bvec, *xvec); CHKERRXX(ierr);
+      ierr = VecGetArray(*xvec, &xarray); CHKERRXX(ierr);
+      p_lu.solve(xarray);
+      ierr = VecRestoreArray(*xvec, &xarray); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    this->p_stats.solveTime += SolverStatistics::now() - t0;
+    this->p_stats.record(1, 0, 0.0);
+    this->p_stats.usedFallback = p_mixedPrecision;
+  }
+
+  /// Factor, or give the KSP, the coefficient matrix
+  /**
+   * (Block) diagonal matrices and the built-in LU are factored here.
+   * Otherwise, the matrix is given to the KSP, which sets up its
+   * preconditioner on the first p_resolveImpl().
+   */
+  void p_factorImpl(MatrixType& A) const
+  {
+    Mat *Amat(PETScMatrix(A));
+
+    // (block) diagonal matrices need no KSP: invert the blocks
+    if (p_isBlockDiagonal(*Amat)) {
+      if (!(p_matrixSet && p_blockDiagonal && this->p_constSerialMatrix)) {
+        p_blockDiagonalFactor(*Amat);
+        p_matrixSet = true;
+        p_blockDiagonal = true;
+      }
+      return;
+    }
+    p_blockDiagonal = false;
+
+    if (p_useNativeLU) {
+      if (!(p_matrixSet && this->p_constSerialMatrix)) {
+        p_nativeFactor(*Amat);
+        p_matrixSet = true;
+      }
+      return;
+    }
+
+    p_setOperators(Amat);
+  }
+
+  /// Solve w/ the specified RHS and estimate (result in x)
+  void p_solveImpl(MatrixType& A, const VectorType& b, VectorType& x) const
+  {
+    this->p_factorImpl(A);
+    this->p_resolveImpl(b, x);
   }
 
   /// Solve again w/ the specified RHS, put result in specified vector (specialized)
   void p_resolveImpl(const VectorType& b, VectorType& x) const
   {
+    if (p_blockDiagonal) {
+      p_blockDiagonalResolve(b, x);
+      return;
+    }
+    if (p_useNativeLU) {
+      p_nativeResolve(b, x);
+      return;
+    }
     PetscErrorCode ierr(0);
     int me(this->processor_rank());
     try {
       const Vec *bvec(PETScVector(b));
       Vec *xvec(PETScVector(x));
 
+      // do the setup (i.e. preconditioner/factorization) separately
+      // so it can be timed
+      double t0(SolverStatistics::now());
+      ierr = KSPSetUp(p_KSP); CHKERRXX(ierr);
+      double t1(SolverStatistics::now());
+
+      p_kspHistory.resize(this->p_maxIterations + 1);
+      ierr = KSPSetResidualHistory(p_KSP, &p_kspHistory[0], 
+                                   p_kspHistory.size(), PETSC_TRUE); CHKERRXX(ierr);
       ierr = KSPSolve(p_KSP, *bvec, *xvec); CHKERRXX(ierr);
+      double t2(SolverStatistics::now());
+
       int its;
       KSPConvergedReason reason;
       PetscReal rnorm;
       ierr = KSPGetIterationNumber(p_KSP, &its); CHKERRXX(ierr);
       ierr = KSPGetConvergedReason(p_KSP, &reason); CHKERRXX(ierr);
       ierr = KSPGetResidualNorm(p_KSP, &rnorm); CHKERRXX(ierr);
+
+      SolverStatistics& stats(this->p_stats);
+      stats.setupTime += (t1 - t0);
+      stats.solveTime += (t2 - t1);
+      stats.record(its, reason, rnorm);
+      PetscReal *hist;
+      PetscInt nhist;
+      ierr = KSPGetResidualHistory(p_KSP, &hist, &nhist); CHKERRXX(ierr);
+      stats.residualHistory.assign(hist, hist + nhist);
+
       std::string msg;
       if (reason < 0) {
         msg = 
           boost::str(boost::format("%d: PETSc KSP diverged after %d iterations, reason: %d") % 
                      me % its % reason);
         throw Exception(msg);
-      } else if (me == 0) {
+      } else if (this->p_verbose && me == 0) {
         msg = 
           boost::str(boost::format("%d: PETSc KSP converged after %d iterations, reason: %d") % 
                      me % its % reason);
@@ -173,10 +652,100 @@ protected:
   }    
   
 
+  /// Solve multiple systems w/ each column of the Matrix a single RHS, in place
+  /**
+   * If the preconditioner is a direct factorization and both @c B and
+   * @c X are dense, the factorization is applied to all columns at
+   * once with MatMatSolve().  With newer PETSc, KSPMatSolve() is used
+   * for other dense cases.  Otherwise, columns are solved one at a
+   * time.
+   */
+  void p_solve(const MatrixType& B, MatrixType& X) const
+  {
+    if (this->p_doSerial || p_useNativeLU ||
+        p_isBlockDiagonal(*PETScMatrix(this->p_matrix))) {
+      LinearSolverImplementation<T, I>::p_solve(B, X);
+      return;
+    }
+    if (X.rows() != B.rows() || X.cols() != B.cols()) {
+      throw Exception("LinearSolver::solve(B, X): X must be the same size as B");
+    }
+
+    PetscErrorCode ierr(0);
+    bool done(false);
+    try {
+      Mat *Amat(PETScMatrix(this->p_matrix));
+      const Mat *Bmat(PETScMatrix(B));
+      Mat *Xmat(PETScMatrix(X));
+
+      PetscBool bdense, xdense;
+      ierr = PetscObjectTypeCompareAny((PetscObject)(*Bmat), &bdense,
+                                       MATSEQDENSE, MATMPIDENSE, ""); CHKERRXX(ierr);
+      ierr = PetscObjectTypeCompareAny((PetscObject)(*Xmat), &xdense,
+                                       MATSEQDENSE, MATMPIDENSE, ""); CHKERRXX(ierr);
+
+      if (bdense && xdense) {
+        p_setOperators(Amat);
+        double t0(SolverStatistics::now());
+        ierr = KSPSetUp(p_KSP); CHKERRXX(ierr);
+        double t1(SolverStatistics::now());
+        this->p_stats.setupTime += (t1 - t0);
+
+        PC pc;
+        PetscBool direct;
+        ierr = KSPGetPC(p_KSP, &pc); CHKERRXX(ierr);
+        ierr = PetscObjectTypeCompareAny((PetscObject)pc, &direct,
+                                         PCLU, PCCHOLESKY, ""); CHKERRXX(ierr);
+        if (direct) {
+          Mat F;
+          ierr = PCFactorGetMatrix(pc, &F); CHKERRXX(ierr);
+          ierr = MatMatSolve(F, *Bmat, *Xmat); CHKERRXX(ierr);
+          this->p_stats.solveTime += SolverStatistics::now() - t1;
+          this->p_stats.record(1, 0, 0.0);
+          done = true;
+        } 
+#if PETSC_VERSION_GE(3,14,0)
+        else {
+          ierr = KSPMatSolve(p_KSP, *Bmat, *Xmat); CHKERRXX(ierr);
+          int its;
+          KSPConvergedReason reason;
+          ierr = KSPGetIterationNumber(p_KSP, &its); CHKERRXX(ierr);
+          ierr = KSPGetConvergedReason(p_KSP, &reason); CHKERRXX(ierr);
+          this->p_stats.solveTime += SolverStatistics::now() - t1;
+          this->p_stats.record(its, reason, 0.0);
+          done = true;
+        }
+#endif
+      }
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+
+    if (!done) {
+      LinearSolverImplementation<T, I>::p_solve(B, X);
+    }
+  }
+
   /// Specialized way to configure from property tree
   void p_configure(utility::Configuration::CursorPtr props)
   {
     LinearSolverImplementation<T, I>::p_configure(props);
+    if (props) {
+      p_useNativeLU = props->get("NativeSparseLU", p_useNativeLU);
+      p_mixedPrecision = props->get("MixedPrecision", p_mixedPrecision);
+      p_refineTolerance = 
+        props->get("RefinementTolerance", p_refineTolerance);
+      p_refineMaxIterations = 
+        props->get("RefinementMaxIterations", p_refineMaxIterations);
+    }
+    // mixed precision is done with the built-in LU
+    if (p_mixedPrecision) {
+      p_useNativeLU = true;
+    }
+    // the built-in LU is serial only; in parallel, collect the system
+    if (p_useNativeLU && this->processor_size() > 1) {
+      this->p_doSerial = true;
+    }
     this->build(props);
   }
 
@@ -54,6 +54,15 @@ MatrixT<T, I>::MatrixT(const parallel::Communicator& comm,
     p_matrix_impl.reset(new PETScMatrixImplementation<T, I>(comm,
                                                             local_rows, cols, true));
     break;
+  case Diagonal:
+  case BlockDiagonal:
+    if (local_rows != cols) {
+      throw Exception("MatrixT: diagonal matrix must have same local rows and columns");
+    }
+    p_matrix_impl.reset(new PETScMatrixImplementation<T, I>(comm,
+                                                            local_rows, cols, 
+                                                            Diagonal, 1));
+    break;
   default:
     BOOST_ASSERT(false);
   }
@@ -127,6 +136,53 @@ MatrixT<RealType>::MatrixT(const parallel::Communicator& comm,
                               const int& cols,
                               const int *nz_by_row);
 
+template <typename T, typename I>
+MatrixT<T, I>::MatrixT(const parallel::Communicator& comm,
+                       const int& local_rows,
+                       const int& cols,
+                       const MatrixStorageType& storage_type,
+                       const int& block_size)
+  : parallel::WrappedDistributed(), utility::Uncopyable(),
+    p_matrix_impl()
+{
+  int bs(block_size);
+  switch (storage_type) {
+  case Diagonal:
+    bs = 1;
+    break;
+  case BlockDiagonal:
+    if (bs < 1 || local_rows % bs != 0) {
+      throw Exception("MatrixT: local rows must be a multiple of the block size");
+    }
+    break;
+  default:
+    throw Exception("MatrixT: block size only applies to (block) diagonal matrices");
+  }
+  if (local_rows != cols) {
+    throw Exception("MatrixT: diagonal matrix must have same local rows and columns");
+  }
+  p_matrix_impl.reset(new PETScMatrixImplementation<T, I>(comm,
+                                                          local_rows, cols, 
+                                                          (bs > 1 ? BlockDiagonal : Diagonal),
+                                                          bs));
+  BOOST_ASSERT(p_matrix_impl);
+  p_setDistributed(p_matrix_impl.get());
+}
+
+template 
+MatrixT<ComplexType>::MatrixT(const parallel::Communicator& comm,
+                              const int& local_rows,
+                              const int& cols,
+                              const MatrixStorageType& storage_type,
+                              const int& block_size);
+
+template 
+MatrixT<RealType>::MatrixT(const parallel::Communicator& comm,
+                           const int& local_rows,
+                           const int& cols,
+                           const MatrixStorageType& storage_type,
+                           const int& block_size);
+
 
 // -------------------------------------------------------------
 // Matrix::createDense
@@ -17,12 +17,7 @@
 // -------------------------------------------------------------
 
 
-#define GA_DENSE_TRANSPOSE 0
-
-#if GA_DENSE_TRANSPOSE
-#include <ga.h>
-#endif
-
+#include <algorithm>
 #include <boost/assert.hpp>
 #include <boost/format.hpp>
 #include "matrix.hpp"
@@ -90,106 +85,7 @@ transpose(const MatrixT<T, I>& A)
   
   PetscErrorCode ierr(0);
   try {
-#if GA_DENSE_TRANSPOSE
-    MatType type;
-    MatGetType(*pA,&type);
-    if (strcmp(type,MATMPIDENSE) == 0 && A.processor_size() > 1) {
-      // This is a hack to get around problems with changing distributions in
-      // PETSc. Copy the matrix to a global array, do the transpose in GA, and
-      // then copy to a new PETSc matrix while preserving the distribution of the
-      // original PETSc matrix.
-      // Get dimensions of matrix A and allocate local arrays
-      int lrows(A.localRows());
-      int grows(A.rows());
-      int gcols(A.cols());
-      ComplexType vals[lrows*gcols];
-      int nprocs = A.processor_size();
-      int me = A.processor_rank();
-      int tmapc[nprocs+1];
-      int mapc[nprocs+1];
-      //printf("p[%d] (transpose) Got to 1\n",me);
-      // Set up global arrays with same row partition as A
-      int i, j;
-      for (i=0; i<nprocs+1; i++) tmapc[i] = 0;
-      tmapc[me] = lrows;
-      GA_Pgroup_igop(A.communicator().getGroup(),tmapc,nprocs+1,"+");
-      mapc[0] = 0;
-      for (i=1; i<nprocs; i++) mapc[i] = mapc[i-1]+tmapc[i-1];
-      mapc[nprocs] = 0;
-      int dims[2],blocks[2];
-      dims[0] = grows;
-      dims[1] = gcols;
-      blocks[0] = nprocs;
-      blocks[1] = 1;
-      //printf("p[%d] (transpose) Got to 2\n",me);
-      int g_tmp = GA_Create_handle();
-      GA_Set_data(g_tmp,2,dims,C_DCPL);
-      GA_Set_irreg_distr(g_tmp,mapc,blocks);
-      GA_Set_pgroup(g_tmp,A.communicator().getGroup());
-      if (!GA_Allocate(g_tmp)) {
-        //TODO: some kind of error
-      }
-      int g_trns = GA_Create_handle();
-      GA_Set_data(g_trns,2,dims,C_DCPL);
-      GA_Set_irreg_distr(g_trns,mapc,blocks);
-      GA_Set_pgroup(g_trns,A.communicator().getGroup());
-      if (!GA_Allocate(g_trns)) {
-        //TODO: some kind of error
-      }
-      //printf("p[%d] (transpose) Got to 3\n",me);
-      // Get low and high row indices for matrix A and copy local row block of A
-      // to g_tmp
-      int llo,lhi, ncount;
-      A.localRowRange(llo,lhi);
-      ncount = 0;
-      for (i=llo; i<lhi; i++) {
-        for (j=0; j<gcols; j++) {
-          A.getElement(i,j,vals[ncount]);
-          ncount++;
-        }
-      }
-      int lo[2],hi[2];
-      lo[0] = llo;
-      lo[1] = 0;
-      hi[0] = lhi-1;
-      hi[1] = gcols-1;
-      int ld = gcols;
-      //printf("p[%d] (transpose) Got to 4\n",me);
-      // Transpose g_tmp
-      NGA_Put(g_tmp,lo,hi,vals,&ld);
-      GA_Transpose(g_tmp, g_trns);
-      NGA_Get(g_trns,lo,hi,vals,&ld);
-      // Copy g_trns to new PETSc matrix
-      GA_Pgroup_sync(A.communicator().getGroup());
-      //printf("p[%d] (transpose) Got to 5\n",me);
-      ierr = MatCreate(A.communicator(), &pAtrans); CHKERRXX(ierr);
-      ierr = MatSetSizes(pAtrans, lrows,lrows,PETSC_DETERMINE,PETSC_DETERMINE); CHKERRXX(ierr);
-      //printf("p[%d] (transpose) Got to 5a\n",me);
-      ierr = MatSetType(pAtrans, type); CHKERRXX(ierr);
-      //printf("p[%d] (transpose) Got to 5b\n",me);
-      ierr = MatMPIDenseSetPreallocation(pAtrans, PETSC_NULL); CHKERRXX(ierr);
-      //printf("p[%d] (transpose) Got to 5c\n",me);
-      ncount = 0;
-      for (i=llo; i<lhi; i++) {
-        for (j=0; j<gcols; j++) {
-          ierr = MatSetValue(pAtrans,i,j,vals[ncount],INSERT_VALUES); CHKERRXX(ierr);
-          ncount++;
-        }
-      }
-      //printf("p[%d] (transpose) Got to 5d\n",me);
-      ierr = MatAssemblyBegin(pAtrans, MAT_FINAL_ASSEMBLY); CHKERRXX(ierr);
-      ierr = MatAssemblyEnd(pAtrans, MAT_FINAL_ASSEMBLY); CHKERRXX(ierr);
-      //printf("p[%d] (transpose) Got to 6\n",me);
-      GA_Destroy(g_tmp);
-      GA_Destroy(g_trns);
-      GA_Pgroup_sync(A.communicator().getGroup());
-      //printf("p[%d] (transpose) Got to 7\n",me);
-    } else {
-      ierr = MatTranspose(*pA, MAT_INITIAL_MATRIX, &pAtrans); CHKERRXX(ierr);
-    }
-#else
     ierr = MatTranspose(*pA, MAT_INITIAL_MATRIX, &pAtrans); CHKERRXX(ierr);
-#endif
   } catch (const PETSC_EXCEPTION_TYPE& e) {
     throw PETScException(ierr, e);
   }
@@ -446,19 +342,109 @@ multiply_dense(const Mat& A, const Mat& B, Mat& C)
   return ierr;
 }
 
+// -------------------------------------------------------------
+// multiply_sparse
+// -------------------------------------------------------------
+/**
+ * Sparse product with MatMatMult(). Complex matrices on a real PETSc
+ * may be stored as blocked (BAIJ) matrices, for which MatMatMult() is
+ * generally not available, so those are converted to AIJ first.  The
+ * product is always done sparse; nothing is densified.
+ */
+static
+PetscErrorCode
+multiply_sparse(const Mat& A, const Mat& B, Mat *C)
+{
+  PetscErrorCode ierr(0);
+  PetscBool ablocked, bblocked;
+  Mat Aaij(A), Baij(B);
+
+  ierr = PetscObjectTypeCompareAny((PetscObject)A, &ablocked,
+                                   MATSEQBAIJ, MATMPIBAIJ, ""); CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompareAny((PetscObject)B, &bblocked,
+                                   MATSEQBAIJ, MATMPIBAIJ, ""); CHKERRQ(ierr);
+  if (ablocked) {
+    ierr = MatConvert(A, MATAIJ, MAT_INITIAL_MATRIX, &Aaij); CHKERRQ(ierr);
+  }
+  if (bblocked) {
+    ierr = MatConvert(B, MATAIJ, MAT_INITIAL_MATRIX, &Baij); CHKERRQ(ierr);
+  }
+  ierr = MatMatMult(Aaij, Baij, MAT_INITIAL_MATRIX, PETSC_DEFAULT, C); CHKERRQ(ierr);
+  if (ablocked) {
+    ierr = MatDestroy(&Aaij); CHKERRQ(ierr);
+  }
+  if (bblocked) {
+    ierr = MatDestroy(&Baij); CHKERRQ(ierr);
+  }
+  return ierr;
+}
+
+// -------------------------------------------------------------
+// multiply_diagonal
+// -------------------------------------------------------------
+/**
+ * If A (or B) is diagonal, the product is just B (or A) with its rows
+ * (or columns) scaled.  The result keeps the nonzero pattern of the
+ * non-diagonal operand and no symbolic product is needed.
+ */
+static
+PetscErrorCode
+multiply_diagonal(const Mat& A, const bool& adiag, 
+                  const Mat& B, const bool& bdiag, Mat *C)
+{
+  PetscErrorCode ierr(0);
+  const Mat& D(adiag ? A : B);
+  Vec d;
+#if PETSC_VERSION_LT(3,6,0)
+  ierr = MatGetVecs(D, PETSC_NULL, &d); CHKERRQ(ierr);
+#else
+  ierr = MatCreateVecs(D, PETSC_NULL, &d); CHKERRQ(ierr);
+#endif
+  ierr = MatGetDiagonal(D, d); CHKERRQ(ierr);
+  if (adiag) {
+    ierr = MatDuplicate(B, MAT_COPY_VALUES, C); CHKERRQ(ierr);
+    ierr = MatDiagonalScale(*C, d, PETSC_NULL); CHKERRQ(ierr);
+  } else {
+    ierr = MatDuplicate(A, MAT_COPY_VALUES, C); CHKERRQ(ierr);
+    ierr = MatDiagonalScale(*C, PETSC_NULL, d); CHKERRQ(ierr);
+  }
+  ierr = VecDestroy(&d); CHKERRQ(ierr);
+  return ierr;
+}
+
 // -------------------------------------------------------------
 // (Matrix) multiply
 // -------------------------------------------------------------
+/**
+ * If either operand has Diagonal storage (and the library is used
+ * directly), the product is done by scaling.  
+ */
 template <typename T, typename I>
 void
 multiply(const MatrixT<T, I>& A, const MatrixT<T, I>& B, MatrixT<T, I>& result)
 {
   PetscErrorCode ierr(0);
+  MatrixStorageType astype(A.storageType()), bstype(B.storageType());
+  bool adiag(PETScMatrixImplementation<T, I>::useLibrary && astype == Diagonal);
+  bool bdiag(PETScMatrixImplementation<T, I>::useLibrary && bstype == Diagonal);
+
+  if (adiag || bdiag) {
+    const Mat *Amat(PETScMatrix(A));
+    const Mat *Bmat(PETScMatrix(B));
+    Mat *Cmat(PETScMatrix(result));
+    try {
+      ierr = MatDestroy(Cmat); CHKERRXX(ierr);
+      ierr = multiply_diagonal(*Amat, adiag, *Bmat, bdiag, Cmat); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    if (adiag && bdiag) {
+      PetscMatrixWrapper::storageMark(*Cmat, Diagonal);
+    }
 
   // special method required for parallel dense*dense
-  if (A.communicator().size() > 1 &&
-      A.storageType() == Dense &&
-      B.storageType() == Dense) {
+  } else if (A.communicator().size() > 1 &&
+             astype == Dense && bstype == Dense) {
     const Mat *Amat(PETScMatrix(A));
     const Mat *Bmat(PETScMatrix(B));
     Mat *Cmat(PETScMatrix(result));
@@ -470,7 +456,7 @@ multiply(const MatrixT<T, I>& A, const MatrixT<T, I>& B, MatrixT<T, I>& result)
     
     try {
       ierr = MatDestroy(Cmat); CHKERRXX(ierr);
-      ierr = MatMatMult(*Amat, *Bmat, MAT_INITIAL_MATRIX, PETSC_DEFAULT, Cmat); CHKERRXX(ierr);
+      ierr = multiply_sparse(*Amat, *Bmat, Cmat); CHKERRXX(ierr);
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
     }
@@ -495,10 +481,29 @@ multiply(const MatrixT<T, I>& A, const MatrixT<T, I>& B)
 {
   PetscErrorCode ierr(0);
   MatrixT<T, I> *result;
+  MatrixStorageType astype(A.storageType()), bstype(B.storageType());
+  bool adiag(PETScMatrixImplementation<T, I>::useLibrary && astype == Diagonal);
+  bool bdiag(PETScMatrixImplementation<T, I>::useLibrary && bstype == Diagonal);
+
+  if (adiag || bdiag) {
+    const Mat *Amat(PETScMatrix(A));
+    const Mat *Bmat(PETScMatrix(B));
+    Mat Cmat;
+    try {
+      ierr = multiply_diagonal(*Amat, adiag, *Bmat, bdiag, &Cmat); CHKERRXX(ierr);
+    } catch (const PETSC_EXCEPTION_TYPE& e) {
+      throw PETScException(ierr, e);
+    }
+    if (adiag && bdiag) {
+      PetscMatrixWrapper::storageMark(Cmat, Diagonal);
+    }
+    PETScMatrixImplementation<T, I> *result_impl = 
+      new PETScMatrixImplementation<T, I>(Cmat, false);
+    result = new MatrixT<T, I>(result_impl);
+
   // special method required for parallel dense*dense
-  if (A.communicator().size() > 1 &&
-      A.storageType() == Dense &&
-      B.storageType() == Dense) {
+  } else if (A.communicator().size() > 1 &&
+             astype == Dense && bstype == Dense) {
     const Mat *Amat(PETScMatrix(A));
     const Mat *Bmat(PETScMatrix(B));
     Mat Cmat;
@@ -513,7 +518,7 @@ multiply(const MatrixT<T, I>& A, const MatrixT<T, I>& B)
     Mat Cmat;
 
     try {
-      ierr = MatMatMult(*Amat, *Bmat, MAT_INITIAL_MATRIX, PETSC_DEFAULT, &Cmat); CHKERRXX(ierr);
+      ierr = multiply_sparse(*Amat, *Bmat, &Cmat); CHKERRXX(ierr);
     } catch (const PETSC_EXCEPTION_TYPE& e) {
       throw PETScException(ierr, e);
     }
@@ -543,6 +548,12 @@ MatrixT<T, I>::storageType(void) const
   MatrixStorageType result;
   PetscErrorCode ierr;
   const Mat *mat(PETScMatrix(*this));
+
+  // Diagonal and BlockDiagonal are regular PETSc types, but marked
+  if (PetscMatrixWrapper::storageMark(*mat, result)) {
+    return result;
+  }
+
   try {
     MatType thetype;
     ierr = MatGetType(*mat, &thetype); CHKERRXX(ierr);
@@ -557,7 +568,10 @@ MatrixT<T, I>::storageType(void) const
       result = Dense;
     } else if (stype == MATAIJ || 
                stype == MATSEQAIJ || 
-               stype == MATMPIAIJ) {
+               stype == MATMPIAIJ ||
+               stype == MATBAIJ || 
+               stype == MATSEQBAIJ || 
+               stype == MATMPIBAIJ) {
       result = Sparse;
     } else {
       std::string msg("Matrix: unexpected PETSc storage type: ");
@@ -590,8 +604,42 @@ storageType(const MatrixT<T, I>& A, const MatrixStorageType& new_type)
 
   MatrixT<T, I> *result;
   MatType new_mat_type(MATSEQAIJ);
+  MatrixStorageType old_type(A.storageType());
+
+  if (old_type != new_type &&
+      (new_type == Diagonal || new_type == BlockDiagonal)) {
+
+    // only the diagonal (blocks) are copied; a BlockDiagonal result
+    // uses the block size of A
+    PetscInt bs(1);
+    if (new_type == BlockDiagonal) {
+      PetscErrorCode ierr(0);
+      const Mat *Amat(PETScMatrix(A));
+      try {
+        ierr = MatGetBlockSize(*Amat, &bs); CHKERRXX(ierr);
+      } catch (const PETSC_EXCEPTION_TYPE& e) {
+        throw PETScException(ierr, e);
+      }
+      bs /= PETScMatrixImplementation<T, I>::elementSize;
+      bs = std::max<PetscInt>(bs, 1);
+    }
+    result = new MatrixT<T, I>(A.communicator(), A.localRows(), A.localCols(),
+                               new_type, bs);
+    I lo, hi;
+    A.localRowRange(lo, hi);
+    for (I i = lo; i < hi; ++i) {
+      I jlo((i/bs)*bs);
+      for (I j = jlo; j < jlo + bs; ++j) {
+        T x;
+        A.getElement(i, j, x);
+        if (x != static_cast<T>(0.0)) {
+          result->setElement(i, j, x);
+        }
+      }
+    }
+    result->ready();
 
-  if (A.storageType() != new_type) {
+  } else if (old_type != new_type) {
     switch (new_type) {
     case (Dense):
       if (nproc > 1) {
@@ -607,6 +655,8 @@ storageType(const MatrixT<T, I>& A, const MatrixStorageType& new_type)
         new_mat_type = MATSEQAIJ;
       } 
       break;
+    default:
+      BOOST_ASSERT(false);
     }
   
     const Mat *Amat(PETScMatrix(A));
@@ -56,9 +56,10 @@ PetscMatrixWrapper::getCommunicator(const Mat& m)
  */
 PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
                                        const PetscInt& local_rows, const PetscInt& local_cols,
-                                       const bool& dense)
+                                       const bool& dense,
+                                       const PetscInt& block_size)
   : ImplementationVisitable(),
-    p_matrix(), p_matrixWrapped(false)
+    p_matrix(), p_matrixWrapped(false), p_blockSize(block_size)
 {
   p_build_matrix(comm, local_rows, local_cols);
   if (dense) {
@@ -70,9 +71,10 @@ PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
 
 PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
                                        const PetscInt& local_rows, const PetscInt& local_cols,
-                                       const PetscInt& max_nonzero_per_row)
+                                       const PetscInt& max_nonzero_per_row,
+                                       const PetscInt& block_size)
   : ImplementationVisitable(),
-    p_matrix(), p_matrixWrapped(false)
+    p_matrix(), p_matrixWrapped(false), p_blockSize(block_size)
 {
   p_build_matrix(comm, local_rows, local_cols);
   p_set_sparse_matrix(max_nonzero_per_row);
@@ -80,27 +82,44 @@ PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
 
 PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
                                        const PetscInt& local_rows, const PetscInt& local_cols,
-                                       const PetscInt *nonzeros_by_row)
+                                       const PetscInt *nonzeros_by_row,
+                                       const PetscInt& block_size)
   : ImplementationVisitable(),
-    p_matrix(), p_matrixWrapped(false)
+    p_matrix(), p_matrixWrapped(false), p_blockSize(block_size)
 {
   p_build_matrix(comm, local_rows, local_cols);
   p_set_sparse_matrix(nonzeros_by_row);
 }
 
+PetscMatrixWrapper::PetscMatrixWrapper(const parallel::Communicator& comm,
+                                       const PetscInt& local_rows, const PetscInt& local_cols,
+                                       const MatrixStorageType& stype,
+                                       const PetscInt& block_size)
+  : ImplementationVisitable(),
+    p_matrix(), p_matrixWrapped(false), p_blockSize(block_size)
+{
+  p_build_matrix(comm, local_rows, local_cols);
+  p_set_block_diagonal_matrix(stype);
+}
+
 PetscMatrixWrapper::PetscMatrixWrapper(Mat& m, const bool& copyMat)
   : ImplementationVisitable(),
-    p_matrix(), p_matrixWrapped(false)
+    p_matrix(), p_matrixWrapped(false), p_blockSize(1)
 {
   PetscErrorCode ierr;
   try {
 
     if (copyMat) {
       ierr = MatDuplicate(m, MAT_COPY_VALUES, &p_matrix); CHKERRXX(ierr);
+      MatrixStorageType stype;
+      if (storageMark(m, stype)) {
+        storageMark(p_matrix, stype);
+      }
     } else {
       p_matrix = m;
       p_matrixWrapped = true;
     }
+    ierr = MatGetBlockSize(p_matrix, &p_blockSize); CHKERRXX(ierr);
 
   } catch (const PETSC_EXCEPTION_TYPE& e) {
     throw PETScException(ierr, e);
@@ -147,6 +166,9 @@ PetscMatrixWrapper::p_build_matrix(const parallel::Communicator& comm,
     
     ierr = MatCreate(comm, &p_matrix); CHKERRXX(ierr);
     ierr = MatSetSizes(p_matrix, lrows, lcols, grows, gcols); CHKERRXX(ierr);
+    if (p_blockSize > 1) {
+      ierr = MatSetBlockSize(p_matrix, p_blockSize); CHKERRXX(ierr);
+    }
   } catch (const PETSC_EXCEPTION_TYPE& e) {
     throw PETScException(ierr, e);
   }
@@ -202,6 +224,18 @@ PetscMatrixWrapper::p_set_sparse_matrix(const PetscInt& max_nz_per_row)
   PetscInt offdiagonal_non_zero_guess(static_cast<PetscInt>(diagonal_non_zero_guess));
   offdiagonal_non_zero_guess = std::max(offdiagonal_non_zero_guess, 10);
 
+  if (p_blockSize > 1) {
+    PetscInt nbrows(this->localRows()/p_blockSize);
+    PetscInt nd((diagonal_non_zero_guess + p_blockSize - 1)/p_blockSize);
+    PetscInt no((offdiagonal_non_zero_guess + p_blockSize - 1)/p_blockSize);
+    std::vector<PetscInt> dnz(nbrows, nd), onz(nbrows, no);
+    if (getCommunicator(p_matrix).size() == 1) {
+      for (PetscInt i = 0; i < nbrows; ++i) dnz[i] += no;
+    }
+    p_set_blocked_sparse_matrix(dnz, onz);
+    return;
+  }
+
   try {
     parallel::Communicator comm(getCommunicator(p_matrix));
     if (comm.size() == 1) {
@@ -227,8 +261,22 @@ PetscMatrixWrapper::p_set_sparse_matrix(const PetscInt& max_nz_per_row)
 void 
 PetscMatrixWrapper::p_set_sparse_matrix(const PetscInt *nz_by_row)
 {
-  std::vector<PetscInt> diagnz;
   PetscInt lrows(this->localRows());
+
+  if (p_blockSize > 1) {
+    // the counts are given by point row; all rows in a block row
+    // have the same structure, so use the first of each
+    PetscInt nbrows(lrows/p_blockSize);
+    std::vector<PetscInt> dnz(nbrows), onz(nbrows);
+    for (PetscInt i = 0; i < nbrows; ++i) {
+      dnz[i] = (nz_by_row[i*p_blockSize] + p_blockSize - 1)/p_blockSize;
+      onz[i] = dnz[i];
+    }
+    p_set_blocked_sparse_matrix(dnz, onz);
+    return;
+  }
+
+  std::vector<PetscInt> diagnz;
   diagnz.reserve(lrows);
   std::copy(nz_by_row, nz_by_row+lrows, 
             std::back_inserter(diagnz));
@@ -260,6 +308,128 @@ PetscMatrixWrapper::p_set_sparse_matrix(const PetscInt *nz_by_row)
   }
 }
 
+// -------------------------------------------------------------
+// PetscMatrixWrapper::p_set_blocked_sparse_matrix
+// -------------------------------------------------------------
+/** 
+ * If the block size is larger than one, the matrix is created with
+ * block sparse (BAIJ) storage, which stores one column index per
+ * block and lets PETSc's own factorizations and preconditioners work
+ * on whole blocks.  Point (AIJ) storage, with the block size kept,
+ * can still be selected at run time with the @c -mat_type @c aij
+ * option.  Factorization packages that cannot handle BAIJ are given
+ * a point copy by the linear solvers.
+ * 
+ * @param dnz number of diagonal blocks in each local block row
+ * @param onz number of off-diagonal blocks in each local block row
+ */
+void 
+PetscMatrixWrapper::p_set_blocked_sparse_matrix(const std::vector<PetscInt>& dnz,
+                                                const std::vector<PetscInt>& onz)
+{
+  PetscErrorCode ierr(0);
+  try {
+    parallel::Communicator comm(getCommunicator(p_matrix));
+    if (p_blockSize > 1) {
+      ierr = MatSetType(p_matrix, (comm.size() == 1 ? MATSEQBAIJ : MATMPIBAIJ));
+    } else {
+      ierr = MatSetType(p_matrix, (comm.size() == 1 ? MATSEQAIJ : MATMPIAIJ));
+    }
+    CHKERRXX(ierr);
+    ierr = MatSetFromOptions(p_matrix); CHKERRXX(ierr);
+    const PetscInt *pd(dnz.empty() ? PETSC_NULL : &dnz[0]);
+    const PetscInt *po(onz.empty() ? PETSC_NULL : &onz[0]);
+    ierr = MatXAIJSetPreallocation(p_matrix, p_blockSize, pd, po,
+                                   PETSC_NULL, PETSC_NULL); CHKERRXX(ierr);
+    ierr = MatSetUp(p_matrix); CHKERRXX(ierr);
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+// -------------------------------------------------------------
+// PetscMatrixWrapper::p_set_block_diagonal_matrix
+// -------------------------------------------------------------
+/** 
+ * Diagonal and BlockDiagonal matrices are ordinary AIJ matrices
+ * preallocated with a single (diagonal) block per block row and
+ * nothing off-process.  They are marked (see storageMark()) so that
+ * operations can recognize them and use simpler algorithms.
+ * 
+ * @param stype Diagonal or BlockDiagonal
+ */
+void 
+PetscMatrixWrapper::p_set_block_diagonal_matrix(const MatrixStorageType& stype)
+{
+  PetscInt nbrows(this->localRows()/p_blockSize);
+  std::vector<PetscInt> dnz(nbrows, 1), onz(nbrows, 0);
+  p_set_blocked_sparse_matrix(dnz, onz);
+  storageMark(p_matrix, stype);
+}
+
+// -------------------------------------------------------------
+// PetscMatrixWrapper::storageMark
+// -------------------------------------------------------------
+/// The name used to attach the storage type to a PETSc Mat
+static const char *storage_mark_name = "GridPACK_MatrixStorageType";
+
+/// Permanent storage for the marks (containers only hold a pointer)
+static int storage_marks[] = { Dense, Sparse, Diagonal, BlockDiagonal };
+
+void
+PetscMatrixWrapper::storageMark(Mat m, const MatrixStorageType& stype)
+{
+  PetscErrorCode ierr(0);
+  try {
+    PetscContainer c;
+    ierr = PetscContainerCreate(PetscObjectComm((PetscObject)m), &c); CHKERRXX(ierr);
+    ierr = PetscContainerSetPointer(c, &storage_marks[static_cast<int>(stype)]); 
+    CHKERRXX(ierr);
+    ierr = PetscObjectCompose((PetscObject)m, storage_mark_name, (PetscObject)c);
+    CHKERRXX(ierr);
+    ierr = PetscContainerDestroy(&c); CHKERRXX(ierr);
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+}
+
+bool
+PetscMatrixWrapper::storageMark(const Mat& m, MatrixStorageType& stype)
+{
+  PetscErrorCode ierr(0);
+  bool result(false);
+  try {
+    PetscObject c(PETSC_NULL);
+    ierr = PetscObjectQuery((PetscObject)m, storage_mark_name, &c); CHKERRXX(ierr);
+    if (c != PETSC_NULL) {
+      void *p;
+      ierr = PetscContainerGetPointer((PetscContainer)c, &p); CHKERRXX(ierr);
+      stype = static_cast<MatrixStorageType>(*static_cast<int *>(p));
+      result = true;
+    }
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+  return result;
+}
+
+// -------------------------------------------------------------
+// PetscMatrixWrapper::blockStorage
+// -------------------------------------------------------------
+bool
+PetscMatrixWrapper::blockStorage(void) const
+{
+  PetscErrorCode ierr(0);
+  PetscBool isbaij(PETSC_FALSE);
+  try {
+    ierr = PetscObjectTypeCompareAny((PetscObject)p_matrix, &isbaij,
+                                     MATSEQBAIJ, MATMPIBAIJ, ""); CHKERRXX(ierr);
+  } catch (const PETSC_EXCEPTION_TYPE& e) {
+    throw PETScException(ierr, e);
+  }
+  return isbaij;
+}
+
 // -------------------------------------------------------------
 // PetscMatrixWrapper::localRowRange
 // -------------------------------------------------------------
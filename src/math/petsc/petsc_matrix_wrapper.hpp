@@ -15,9 +15,11 @@
 #ifndef _petsc_matrix_wrapper_hpp_
 #define _petsc_matrix_wrapper_hpp_
 
+#include <vector>
 #include <petscmat.h>
 #include "parallel/communicator.hpp"
 #include "implementation_visitable.hpp"
+#include "matrix_storage_type.hpp"
 
 namespace gridpack {
 namespace math {
@@ -38,23 +40,48 @@ public:
   static parallel::Communicator getCommunicator(const Mat& m);
 
   /// Default constructor.
+  /**
+   * If @c block_size is larger than one, the matrix is built from
+   * dense blocks of that size and the local row and column counts
+   * must be multiples of it.
+   */
   PetscMatrixWrapper(const parallel::Communicator& comm,
                      const PetscInt& local_rows, const PetscInt& local_cols,
-                     const bool& dense = false);
+                     const bool& dense = false,
+                     const PetscInt& block_size = 1);
 
   /// Construct a sparse matrix allocating the same number of nonzeros in all rows
   PetscMatrixWrapper(const parallel::Communicator& comm,
                      const PetscInt& local_rows, const PetscInt& local_cols,
-                     const PetscInt& max_nonzero_per_row);
+                     const PetscInt& max_nonzero_per_row,
+                     const PetscInt& block_size = 1);
 
   /// Construct a sparse matrix with nonzero count specified for each (local) row
   PetscMatrixWrapper(const parallel::Communicator& comm,
                      const PetscInt& local_rows, const PetscInt& local_cols,
-                     const PetscInt *nonzeros_by_row);
+                     const PetscInt *nonzeros_by_row,
+                     const PetscInt& block_size = 1);
+
+  /// Construct a Diagonal or BlockDiagonal matrix
+  /**
+   * Exactly one (dense) block of size @c block_size is allocated in
+   * each block row, on the diagonal.  A Diagonal matrix is just a
+   * BlockDiagonal matrix with a block size of one. 
+   */
+  PetscMatrixWrapper(const parallel::Communicator& comm,
+                     const PetscInt& local_rows, const PetscInt& local_cols,
+                     const MatrixStorageType& stype,
+                     const PetscInt& block_size);
 
   /// Constructor that wraps an existing Mat instance
   PetscMatrixWrapper(Mat& m, const bool& copymat = true);
 
+  /// Mark a PETSc matrix with a specific GridPACK storage type
+  static void storageMark(Mat m, const MatrixStorageType& stype);
+
+  /// Get the GridPACK storage type mark of a PETSc matrix, if any
+  static bool storageMark(const Mat& m, MatrixStorageType& stype);
+
   /// Destructor
   ~PetscMatrixWrapper(void);
 
@@ -73,6 +100,15 @@ public:
   /// Get the number of local rows in this matirx (specialized)
   PetscInt localCols(void) const;
 
+  /// Get the size of the dense blocks used to store this matrix
+  PetscInt blockSize(void) const
+  {
+    return p_blockSize;
+  }
+
+  /// Is this matrix stored in PETSc's block sparse (BAIJ) format?
+  bool blockStorage(void) const;
+
   /// Replace all elements with their real parts
   void real(void);
 
@@ -123,6 +159,9 @@ protected:
   /// Was @c p_matrix created or just wrapped
   bool p_matrixWrapped;
 
+  /// The size of the dense blocks that make up the matrix
+  PetscInt p_blockSize;
+
   /// Build the generic PETSc matrix instance
   void p_build_matrix(const parallel::Communicator& comm,
                       const PetscInt& local_rows, const PetscInt& cols);
@@ -139,6 +178,13 @@ protected:
   /// Set up a sparse matrix and preallocate it using known nonzeros for each row
   void p_set_sparse_matrix(const PetscInt *nz_by_row);
 
+  /// Set up a sparse matrix of blocks, preallocated by block row
+  void p_set_blocked_sparse_matrix(const std::vector<PetscInt>& dnz,
+                                   const std::vector<PetscInt>& onz);
+
+  /// Set up a matrix with only diagonal blocks
+  void p_set_block_diagonal_matrix(const MatrixStorageType& stype);
+
   /// Allow visits by implemetation visitor
   void p_accept(ImplementationVisitor& visitor);
 
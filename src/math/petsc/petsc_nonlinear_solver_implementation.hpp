@@ -56,7 +56,8 @@ public:
       PETScConfigurable(this->communicator()),
       p_snes(), 
       p_petsc_J(), p_petsc_F(),
-      p_petsc_X()                 // set by p_solve()
+      p_petsc_X(),                // set by p_solve()
+      p_haveMF(false), p_jacobianCalls(0), p_jacobianBuilds(0)
   {
     
   }
@@ -70,7 +71,8 @@ public:
       PETScConfigurable(this->communicator()),
       p_snes(), 
       p_petsc_J(), p_petsc_F(),
-      p_petsc_X()                 // set by p_solve()
+      p_petsc_X(),                // set by p_solve()
+      p_haveMF(false), p_jacobianCalls(0), p_jacobianBuilds(0)
   {
     
   }
@@ -84,6 +86,10 @@ public:
       ierr = PetscInitialized(&ok); CHKERRXX(ierr);
       if (ok) {
         ierr = SNESDestroy(&p_snes); CHKERRXX(ierr);
+        if (p_haveMF) {
+          ierr = MatDestroy(&p_mfJ); CHKERRXX(ierr);
+          ierr = VecDestroy(&p_mfBase); CHKERRXX(ierr);
+        }
       }
     } catch (...) {
       // just eat it
@@ -104,6 +110,24 @@ protected:
   /// A pointer to the PETSc vector part of ::p_X
   Vec *p_petsc_X;
 
+  /// Has the matrix-free operator been created
+  bool p_haveMF;
+
+  /// The matrix-free Jacobian operator (matrix-free mode only)
+  Mat p_mfJ;
+
+  /// The solution estimate at which ::p_mfJ is linearized (exact products only)
+  Vec p_mfBase;
+
+  /// Number of Jacobian requests from SNES in the current solve
+  int p_jacobianCalls;
+
+  /// Number of times the assembled Jacobian was built in the current solve
+  int p_jacobianBuilds;
+
+  /// A place for PETSc to put the function norm history
+  std::vector<PetscReal> p_history;
+
   /// Do what is necessary to build this instance
   void p_build(const std::string& option_prefix)
   {
@@ -119,7 +143,31 @@ protected:
 
       p_petsc_J = PETScMatrix(*(this->p_J));
     
-      if (!this->p_jacobian.empty()) {
+      if (this->p_matrixFree) {
+
+        // The Jacobian is only applied through products, either
+        // supplied by the user or finite differences of the function.
+        // The assembled Jacobian, if available, is only used to
+        // build the preconditioner
+        
+        ierr = VecDuplicate(*p_petsc_F, &p_mfBase); CHKERRXX(ierr);
+        if (this->p_jvProduct.empty()) {
+          ierr = MatCreateSNESMF(p_snes, &p_mfJ); CHKERRXX(ierr);
+        } else {
+          PetscInt m, n, M, N;
+          ierr = MatGetLocalSize(*p_petsc_J, &m, &n); CHKERRXX(ierr);
+          ierr = MatGetSize(*p_petsc_J, &M, &N); CHKERRXX(ierr);
+          ierr = MatCreateShell(this->communicator(), m, n, M, N, 
+                                static_cast<void *>(this), &p_mfJ); CHKERRXX(ierr);
+          ierr = MatShellSetOperation(p_mfJ, MATOP_MULT, 
+                                      (void (*)(void))(JacobianProduct)); CHKERRXX(ierr);
+        }
+        p_haveMF = true;
+        ierr = SNESSetJacobian(p_snes, p_mfJ, 
+                               (this->p_jacobian.empty() ? p_mfJ : *p_petsc_J),
+                               FormJacobian, 
+                               static_cast<void *>(this)); CHKERRXX(ierr);
+      } else if (!this->p_jacobian.empty()) {
         ierr = SNESSetJacobian(p_snes, *p_petsc_J, *p_petsc_J, FormJacobian, 
                                static_cast<void *>(this)); CHKERRXX(ierr);
       }
@@ -134,7 +182,13 @@ protected:
       ierr = KSPGetPC(ksp, &pc); CHKERRXX(ierr);
       ierr = PCSetOptionsPrefix(pc, option_prefix.c_str()); CHKERRXX(ierr);
 
-      ierr = SNESMonitorSet(p_snes, MonitorNorms, PETSC_NULL, PETSC_NULL); CHKERRXX(ierr);
+      if (this->p_verbose) {
+        ierr = SNESMonitorSet(p_snes, MonitorNorms, PETSC_NULL, PETSC_NULL); CHKERRXX(ierr);
+      }
+
+      p_history.resize(this->p_maxIterations + 1);
+      ierr = SNESSetConvergenceHistory(p_snes, &p_history[0], PETSC_NULL,
+                                       p_history.size(), PETSC_TRUE); CHKERRXX(ierr);
 
       ierr = SNESSetTolerances(p_snes, 
                                this->p_functionTolerance, 
@@ -159,13 +213,28 @@ protected:
     PetscErrorCode ierr(0);
     p_petsc_X = PETScVector(*(this->p_X));
     int me(this->processor_rank());
+    p_jacobianCalls = 0;
+    p_jacobianBuilds = 0;
 
     try {
+      double t0(SolverStatistics::now());
       ierr = SNESSolve(p_snes, NULL, *p_petsc_X); CHKERRXX(ierr);
       SNESConvergedReason reason;
-      PetscInt iter;
+      PetscInt iter, lits;
       ierr = SNESGetConvergedReason(p_snes, &reason); CHKERRXX(ierr);
       ierr = SNESGetIterationNumber(p_snes, &iter); CHKERRXX(ierr);
+      ierr = SNESGetLinearSolveIterations(p_snes, &lits); CHKERRXX(ierr);
+
+      PetscReal *hist;
+      PetscInt nhist;
+      ierr = SNESGetConvergenceHistory(p_snes, &hist, PETSC_NULL, &nhist); CHKERRXX(ierr);
+
+      SolverStatistics& stats(this->p_stats);
+      stats.solveTime += SolverStatistics::now() - t0;
+      stats.setups += p_jacobianBuilds;
+      stats.record(iter, reason, (nhist > 0 ? hist[nhist-1] : 0.0));
+      stats.recordLinear(lits);
+      stats.residualHistory.assign(hist, hist + nhist);
 
       std::string msg;
       if (reason < 0) {
@@ -173,7 +242,7 @@ protected:
           boost::str(boost::format("%d: PETSc SNES diverged after %d iterations, reason: %d") % 
                      me % iter % reason);
         throw Exception(msg);
-      } else if (me == 0) {
+      } else if (this->p_verbose && me == 0) {
         msg = 
           boost::str(boost::format("%d: PETSc SNES converged after %d iterations, reason: %d") % 
                      me % iter % reason);
@@ -195,33 +264,88 @@ protected:
   }
 
 
-#if PETSC_VERSION_LT(3,5,0)
-  /// Routine to assemble Jacobian that is sent to PETSc
-  static PetscErrorCode FormJacobian(SNES snes, Vec x, Mat *jac, Mat *B, 
-                                     MatStructure *flag, void *dummy)
+  /// Update the Jacobian operator and, if necessary, the preconditioner matrix 
+  /**
+   * In matrix-free mode, the operator is linearized at @c x each
+   * time, but the (expensive) assembled Jacobian is only rebuilt
+   * every ::p_preconditionerInterval calls.
+   *
+   * @param rebuilt set to true if the preconditioner matrix was rebuilt
+   */
+  static PetscErrorCode p_formJacobian(PetscNonlinearSolverImplementation *solver,
+                                       Vec x, Mat jac, Mat B, bool *rebuilt)
   {
     PetscErrorCode ierr(0);
+    *rebuilt = true;
+    if (solver->p_matrixFree) {
+      ierr = VecCopy(x, solver->p_mfBase); CHKERRQ(ierr);
+
+      // for finite difference operators, this sets the base
+      ierr = MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+      ierr = MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+      
+      *rebuilt = (B != jac && 
+                  solver->p_jacobianCalls % solver->p_preconditionerInterval == 0);
+      if (*rebuilt) {
+        (solver->p_jacobian)(*(solver->p_X), *(solver->p_J));
+        solver->p_jacobianBuilds++;
+      }
+    } else {
+      // Should be the case, but just make sure
+      BOOST_ASSERT(jac == *(solver->p_petsc_J));
+      BOOST_ASSERT(B == *(solver->p_petsc_J));
+
+      // Not sure about this
+      BOOST_ASSERT(x == *(solver->p_petsc_X));
+
+      // May need to do this, which seems slow.
+      // ierr = VecCopy(x, *(solver->p_petsc_X)); CHKERRQ(ierr);
+
+      // Call the user-specified function (object) to form the Jacobian
+      (solver->p_jacobian)(*(solver->p_X), *(solver->p_J));
+      solver->p_jacobianBuilds++;
+    }
+    solver->p_jacobianCalls++;
+    return ierr;
+  }
+
+  /// Routine to compute the user-supplied Jacobian-vector product 
+  static PetscErrorCode JacobianProduct(Mat J, Vec v, Vec Jv)
+  {
+    PetscErrorCode ierr(0);
+    void *dummy;
+    ierr = MatShellGetContext(J, &dummy); CHKERRQ(ierr);
 
     // Necessary C cast
     PetscNonlinearSolverImplementation *solver =
       (PetscNonlinearSolverImplementation *)dummy;
 
-    // Copy PETSc's current estimate into 
+    boost::scoped_ptr< VectorType > 
+      xtmp(new VectorType(new PETScVectorImplementation<T, I>(solver->p_mfBase, false)));
+    boost::scoped_ptr< VectorType > 
+      vtmp(new VectorType(new PETScVectorImplementation<T, I>(v, false)));
+    boost::scoped_ptr< VectorType > 
+      jvtmp(new VectorType(new PETScVectorImplementation<T, I>(Jv, false)));
 
-    // Should be the case, but just make sure
-    BOOST_ASSERT(*jac == *solver->p_petsc_J);
-    BOOST_ASSERT(*B == *solver->p_petsc_J);
+    (solver->p_jvProduct)(*xtmp, *vtmp, *jvtmp);
 
-    // Not sure about this
-    BOOST_ASSERT(x == *(solver->p_petsc_X));
+    return ierr;
+  }
 
-    // May need to do this, which seems slow.
-    // ierr = VecCopy(x, *(solver->p_petsc_X)); CHKERRQ(ierr);
+#if PETSC_VERSION_LT(3,5,0)
+  /// Routine to assemble Jacobian that is sent to PETSc
+  static PetscErrorCode FormJacobian(SNES snes, Vec x, Mat *jac, Mat *B, 
+                                     MatStructure *flag, void *dummy)
+  {
+    PetscErrorCode ierr(0);
 
-    // Call the user-specified function (object) to form the Jacobian
-    (solver->p_jacobian)(*(solver->p_X), *(solver->p_J));
+    // Necessary C cast
+    PetscNonlinearSolverImplementation *solver =
+      (PetscNonlinearSolverImplementation *)dummy;
 
-    *flag = SAME_NONZERO_PATTERN;
+    bool rebuilt;
+    ierr = p_formJacobian(solver, x, *jac, *B, &rebuilt); CHKERRQ(ierr);
+    *flag = (rebuilt ? SAME_NONZERO_PATTERN : SAME_PRECONDITIONER);
 
     return ierr;
   }
@@ -237,20 +361,8 @@ protected:
     PetscNonlinearSolverImplementation *solver =
       (PetscNonlinearSolverImplementation *)dummy;
 
-    // Copy PETSc's current estimate into 
-
-    // Should be the case, but just make sure
-    BOOST_ASSERT(jac == *(solver->p_petsc_J));
-    BOOST_ASSERT(B == *(solver->p_petsc_J));
-
-    // Not sure about this
-    BOOST_ASSERT(x == *(solver->p_petsc_X));
-
-    // May need to do this, which seems slow.
-    // ierr = VecCopy(x, *(solver->p_petsc_X)); CHKERRQ(ierr);
-
-    // Call the user-specified function (object) to form the Jacobian
-    (solver->p_jacobian)(*(solver->p_X), *(solver->p_J));
+    bool rebuilt;
+    ierr = p_formJacobian(solver, x, jac, B, &rebuilt); CHKERRQ(ierr);
 
     return ierr;
   }
@@ -0,0 +1,438 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   small_matrix.hpp
+ *
+ * @brief  Batched LU, solve, and inverse of many small dense matrices
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _small_matrix_hpp_
+#define _small_matrix_hpp_
+
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <boost/static_assert.hpp>
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  class SmallMatrixBatch
+// -------------------------------------------------------------
+/// A batch of small dense matrices of the same (fixed) order
+/**
+ * Many component calculations need to solve or invert tiny dense
+ * systems (e.g. 2x2 power flow blocks, or machine model blocks).
+ * Using a library Matrix for these costs far more in object
+ * creation than in arithmetic.  This holds @c count matrices of
+ * order @c N, factors all of them at once with LU and partial
+ * pivoting, and can then solve or invert with the factors.
+ *
+ * Storage is structure-of-arrays: element (i,j) of all matrices is
+ * contiguous.  So, every inner loop is over the matrices in the
+ * batch, has no branches, and can be vectorized by the compiler.
+ * Pivot choice and row swaps are done with selects, not branches,
+ * for the same reason.
+ *
+ * @c T can be any floating point type for which @c std::abs is
+ * defined, real or complex.
+ */
+template <typename T, int N>
+class SmallMatrixBatch
+{
+public:
+
+  BOOST_STATIC_ASSERT(N >= 2 && N <= 16);
+
+  /// The order of all matrices
+  static const int order = N;
+
+  /// Default constructor.
+  explicit SmallMatrixBatch(const int& count = 0)
+    : p_count(0), p_factored(false)
+  {
+    resize(count);
+  }
+
+  /// Destructor
+  ~SmallMatrixBatch(void)
+  {}
+
+  /// Change the number of matrices (contents are zeroed)
+  void resize(const int& count)
+  {
+    p_count = count;
+    p_a.assign(N*N*p_count, T(0.0));
+    p_dinv.assign(N*p_count, T(0.0));
+    p_pivot.assign(N*p_count, 0);
+    p_ok.assign(p_count, 1);
+    p_factored = false;
+  }
+
+  /// The number of matrices
+  int count(void) const
+  {
+    return p_count;
+  }
+
+  /// Has factor() been called (since the last change)
+  bool factored(void) const
+  {
+    return p_factored;
+  }
+
+  /// Element (i,j) of matrix m
+  T& operator() (const int& m, const int& i, const int& j)
+  {
+    p_factored = false;
+    return p_a[p_index(i, j) + m];
+  }
+
+  /// Element (i,j) of matrix m (or its factors, if factored)
+  const T& operator() (const int& m, const int& i, const int& j) const
+  {
+    return p_a[p_index(i, j) + m];
+  }
+
+  /// Set matrix m from a dense, row-major array
+  void set(const int& m, const T *a)
+  {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        p_a[p_index(i, j) + m] = a[i*N + j];
+      }
+    }
+    p_factored = false;
+  }
+
+  /// Get matrix m (or its factors, if factored) as a dense, row-major array
+  void get(const int& m, T *a) const
+  {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        a[i*N + j] = p_a[p_index(i, j) + m];
+      }
+    }
+  }
+
+  /// Was matrix m found to be singular by factor()
+  bool singular(const int& m) const
+  {
+    return (p_ok[m] == 0);
+  }
+
+  /// Compute the LU factorization of all matrices in place
+  /**
+   * A matrix with an exactly zero pivot is marked singular() and its
+   * factors are not usable; the others are unaffected.
+   *
+   * @return true if no matrix is singular
+   */
+  bool factor(void)
+  {
+    const int nb(p_count);
+    std::vector<double> best(nb);
+
+    for (int m = 0; m < nb; ++m) p_ok[m] = 1;
+
+    for (int k = 0; k < N; ++k) {
+      int *piv(&p_pivot[k*nb]);
+
+      // choose the pivot row
+      const T *akk(&p_a[p_index(k, k)]);
+      for (int m = 0; m < nb; ++m) {
+        piv[m] = k;
+        best[m] = std::abs(akk[m]);
+      }
+      for (int r = k + 1; r < N; ++r) {
+        const T *ark(&p_a[p_index(r, k)]);
+        for (int m = 0; m < nb; ++m) {
+          double v(std::abs(ark[m]));
+          bool better(v > best[m]);
+          best[m] = better ? v : best[m];
+          piv[m] = better ? r : piv[m];
+        }
+      }
+
+      // swap rows k and piv (all columns, so L is permuted too)
+      for (int r = k + 1; r < N; ++r) {
+        for (int j = 0; j < N; ++j) {
+          T *akj(&p_a[p_index(k, j)]);
+          T *arj(&p_a[p_index(r, j)]);
+          for (int m = 0; m < nb; ++m) {
+            bool swap(piv[m] == r);
+            T x(akj[m]), y(arj[m]);
+            akj[m] = swap ? y : x;
+            arj[m] = swap ? x : y;
+          }
+        }
+      }
+
+      // scale the column of L
+      T *dinv(&p_dinv[k*nb]);
+      akk = &p_a[p_index(k, k)];
+      for (int m = 0; m < nb; ++m) {
+        bool zero(best[m] == 0.0);
+        p_ok[m] = zero ? 0 : p_ok[m];
+        dinv[m] = zero ? T(0.0) : T(1.0)/(zero ? T(1.0) : akk[m]);
+      }
+      for (int r = k + 1; r < N; ++r) {
+        T *ark(&p_a[p_index(r, k)]);
+        for (int m = 0; m < nb; ++m) {
+          ark[m] *= dinv[m];
+        }
+
+        // update the trailing submatrix
+        for (int j = k + 1; j < N; ++j) {
+          const T *akj(&p_a[p_index(k, j)]);
+          T *arj(&p_a[p_index(r, j)]);
+          for (int m = 0; m < nb; ++m) {
+            arj[m] -= ark[m]*akj[m];
+          }
+        }
+      }
+    }
+    p_factored = true;
+    return (std::count(p_ok.begin(), p_ok.end(), 0) == 0);
+  }
+
+  /// Solve all systems with the factors, in place
+  /**
+   * @param b right hand sides, overwritten by solutions; element i of
+   * the right hand side for matrix m is @c b[i*count() + m]
+   */
+  void solve(T *b) const
+  {
+    const int nb(p_count);
+
+    // row interchanges, in the order they were done
+    for (int k = 0; k < N; ++k) {
+      const int *piv(&p_pivot[k*nb]);
+      T *bk(&b[k*nb]);
+      for (int m = 0; m < nb; ++m) {
+        int p(piv[m]);
+        T x(bk[m]);
+        bk[m] = b[p*nb + m];
+        b[p*nb + m] = x;
+      }
+    }
+
+    // forward substitution with unit lower triangle
+    for (int i = 1; i < N; ++i) {
+      T *bi(&b[i*nb]);
+      for (int j = 0; j < i; ++j) {
+        const T *aij(&p_a[p_index(i, j)]);
+        const T *bj(&b[j*nb]);
+        for (int m = 0; m < nb; ++m) {
+          bi[m] -= aij[m]*bj[m];
+        }
+      }
+    }
+
+    // back substitution with upper triangle
+    for (int i = N - 1; i >= 0; --i) {
+      T *bi(&b[i*nb]);
+      for (int j = i + 1; j < N; ++j) {
+        const T *aij(&p_a[p_index(i, j)]);
+        const T *bj(&b[j*nb]);
+        for (int m = 0; m < nb; ++m) {
+          bi[m] -= aij[m]*bj[m];
+        }
+      }
+      const T *dinv(&p_dinv[i*nb]);
+      for (int m = 0; m < nb; ++m) {
+        bi[m] *= dinv[m];
+      }
+    }
+  }
+
+  /// Solve a single system with the factors of matrix m, in place
+  /**
+   * @param b contiguous right hand side of length N, overwritten by the solution
+   */
+  void solve(const int& m, T *b) const
+  {
+    const int nb(p_count);
+    for (int k = 0; k < N; ++k) {
+      std::swap(b[k], b[p_pivot[k*nb + m]]);
+    }
+    for (int i = 1; i < N; ++i) {
+      for (int j = 0; j < i; ++j) {
+        b[i] -= p_a[p_index(i, j) + m]*b[j];
+      }
+    }
+    for (int i = N - 1; i >= 0; --i) {
+      for (int j = i + 1; j < N; ++j) {
+        b[i] -= p_a[p_index(i, j) + m]*b[j];
+      }
+      b[i] *= p_dinv[i*nb + m];
+    }
+  }
+
+  /// Compute the inverse of all matrices with the factors
+  void inverse(SmallMatrixBatch<T, N>& inv) const
+  {
+    const int nb(p_count);
+    inv.resize(nb);
+    std::vector<T> col(N*nb);
+    for (int j = 0; j < N; ++j) {
+      std::fill(col.begin(), col.end(), T(0.0));
+      std::fill(col.begin() + j*nb, col.begin() + (j+1)*nb, T(1.0));
+      solve(&col[0]);
+      for (int i = 0; i < N; ++i) {
+        std::copy(col.begin() + i*nb, col.begin() + (i+1)*nb,
+                  inv.p_a.begin() + inv.p_index(i, j));
+      }
+    }
+  }
+
+protected:
+
+  /// The number of matrices
+  int p_count;
+
+  /// Has factor() been called
+  bool p_factored;
+
+  /// Matrix elements (or factors), structure-of-arrays
+  std::vector<T> p_a;
+
+  /// Inverse of the diagonal of U
+  std::vector<T> p_dinv;
+
+  /// Pivot row chosen at each step, for each matrix
+  std::vector<int> p_pivot;
+
+  /// Flag for each matrix that is not singular
+  std::vector<char> p_ok;
+
+  /// Start of the (i,j) elements in ::p_a
+  int p_index(const int& i, const int& j) const
+  {
+    return (i*N + j)*p_count;
+  }
+};
+
+// -------------------------------------------------------------
+// invertSmallMatrixBatch
+// -------------------------------------------------------------
+/// Invert @c count matrices of order @c N, each dense and row-major, in place
+template <typename T, int N>
+int
+invertSmallMatrixBatch(const int& count, T *a)
+{
+  SmallMatrixBatch<T, N> batch(count), inv;
+  for (int m = 0; m < count; ++m) {
+    batch.set(m, a + m*N*N);
+  }
+  batch.factor();
+  batch.inverse(inv);
+  int result(-1);
+  for (int m = 0; m < count; ++m) {
+    if (batch.singular(m)) {
+      if (result < 0) result = m;
+    } else {
+      inv.get(m, a + m*N*N);
+    }
+  }
+  return result;
+}
+
+// -------------------------------------------------------------
+// invertSmallMatrices
+// -------------------------------------------------------------
+/// Invert a number of small, dense, row-major matrices of any order in place
+/**
+ * Orders from 2 to 16 use SmallMatrixBatch; others are done one at
+ * a time with Gauss-Jordan elimination.
+ *
+ * @param n order of each matrix
+ * @param count number of matrices
+ * @param a matrices, each n*n row-major, one after the other
+ *
+ * @return index of the first singular matrix, or -1 if none
+ */
+template <typename T>
+int
+invertSmallMatrices(const int& n, const int& count, T *a)
+{
+  switch (n) {
+  case 2: return invertSmallMatrixBatch<T, 2>(count, a);
+  case 3: return invertSmallMatrixBatch<T, 3>(count, a);
+  case 4: return invertSmallMatrixBatch<T, 4>(count, a);
+  case 5: return invertSmallMatrixBatch<T, 5>(count, a);
+  case 6: return invertSmallMatrixBatch<T, 6>(count, a);
+  case 7: return invertSmallMatrixBatch<T, 7>(count, a);
+  case 8: return invertSmallMatrixBatch<T, 8>(count, a);
+  case 9: return invertSmallMatrixBatch<T, 9>(count, a);
+  case 10: return invertSmallMatrixBatch<T, 10>(count, a);
+  case 11: return invertSmallMatrixBatch<T, 11>(count, a);
+  case 12: return invertSmallMatrixBatch<T, 12>(count, a);
+  case 13: return invertSmallMatrixBatch<T, 13>(count, a);
+  case 14: return invertSmallMatrixBatch<T, 14>(count, a);
+  case 15: return invertSmallMatrixBatch<T, 15>(count, a);
+  case 16: return invertSmallMatrixBatch<T, 16>(count, a);
+  default:
+    break;
+  }
+
+  int result(-1);
+  std::vector<T> inv(n*n), b(n*n);
+  for (int m = 0; m < count && n > 0; ++m) {
+    std::copy(a + m*n*n, a + (m+1)*n*n, b.begin());
+    std::fill(inv.begin(), inv.end(), T(0.0));
+    for (int i = 0; i < n; ++i) inv[i*n + i] = T(1.0);
+    bool ok(true);
+    for (int k = 0; k < n && ok; ++k) {
+      int p(k);
+      for (int i = k + 1; i < n; ++i) {
+        if (std::abs(b[i*n + k]) > std::abs(b[p*n + k])) p = i;
+      }
+      if (std::abs(b[p*n + k]) == 0.0) {
+        ok = false;
+        break;
+      }
+      if (p != k) {
+        for (int j = 0; j < n; ++j) {
+          std::swap(b[k*n + j], b[p*n + j]);
+          std::swap(inv[k*n + j], inv[p*n + j]);
+        }
+      }
+      T d(T(1.0)/b[k*n + k]);
+      for (int j = 0; j < n; ++j) {
+        b[k*n + j] *= d;
+        inv[k*n + j] *= d;
+      }
+      for (int i = 0; i < n; ++i) {
+        if (i == k) continue;
+        T f(b[i*n + k]);
+        for (int j = 0; j < n; ++j) {
+          b[i*n + j] -= f*b[k*n + j];
+          inv[i*n + j] -= f*inv[k*n + j];
+        }
+      }
+    }
+    if (ok) {
+      std::copy(inv.begin(), inv.end(), a + m*n*n);
+    } else if (result < 0) {
+      result = m;
+    }
+  }
+  return result;
+}
+
+} // namespace math
+} // namespace gridpack
+
+#endif
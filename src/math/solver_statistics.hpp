@@ -0,0 +1,174 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   solver_statistics.hpp
+ *
+ * @brief  Performance and convergence information collected by solvers
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _solver_statistics_hpp_
+#define _solver_statistics_hpp_
+
+#include <vector>
+#include <ostream>
+#include <mpi.h>
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  struct SolverStatistics
+// -------------------------------------------------------------
+/// Convergence and timing information collected by a solver
+/**
+ * Each LinearSolver, NonlinearSolver, and DAESolver keeps one of
+ * these.  It is updated by every solve, and is meant to be inspected
+ * by the caller rather than printed.  Quantities describing the @em
+ * last solve are replaced by each solve; counts and times are
+ * accumulated until reset().
+ *
+ * The meaning of an "iteration" depends on the solver: Krylov
+ * iterations for a LinearSolver, (Newton) iterations for a
+ * NonlinearSolver, and time steps for a DAESolver.  For the latter
+ * two, the iterations of the inner (linear) solver are counted
+ * separately.
+ *
+ * Times are wall clock seconds on the calling process.  Setup time
+ * includes preconditioner construction, which is where direct
+ * factorizations happen.
+ */
+struct SolverStatistics
+{
+  /// Default constructor.
+  SolverStatistics(void)
+  {
+    reset();
+  }
+
+  /// Zero everything
+  void reset(void)
+  {
+    solves = 0;
+    failures = 0;
+    iterations = 0;
+    totalIterations = 0;
+    linearIterations = 0;
+    totalLinearIterations = 0;
+    reason = 0;
+    converged = true;
+    residualNorm = 0.0;
+    residualHistory.clear();
+    setups = 0;
+    setupTime = 0.0;
+    solveTime = 0.0;
+    refinementFallbacks = 0;
+    usedFallback = false;
+  }
+
+  /// Number of solves since reset()
+  int solves;
+
+  /// Number of solves that failed since reset()
+  int failures;
+
+  /// Number of iterations performed by the last solve
+  int iterations;
+
+  /// Number of iterations performed since reset()
+  int totalIterations;
+
+  /// Number of inner linear iterations performed by the last solve
+  int linearIterations;
+
+  /// Number of inner linear iterations since reset()
+  int totalLinearIterations;
+
+  /// Convergence reason of the last solve (library specific, negative is failure)
+  int reason;
+
+  /// Did the last solve converge
+  bool converged;
+
+  /// Final residual norm of the last solve
+  double residualNorm;
+
+  /// Residual norm at each iteration of the last solve (if available)
+  std::vector<double> residualHistory;
+
+  /// Number of setups (e.g. factorizations) since reset()
+  int setups;
+
+  /// Time spent in setup since reset()
+  double setupTime;
+
+  /// Time spent solving (not including setup) since reset()
+  double solveTime;
+
+  /// Number of times mixed precision refinement failed and a double
+  /// precision factorization was used instead, since reset()
+  int refinementFallbacks;
+
+  /// Did the last solve use the double precision fallback
+  bool usedFallback;
+
+  /// Record the end of a solve
+  void record(const int& its, const int& why, const double& rnorm)
+  {
+    solves++;
+    iterations = its;
+    totalIterations += its;
+    reason = why;
+    converged = (why >= 0);
+    if (!converged) failures++;
+    residualNorm = rnorm;
+  }
+
+  /// Record the inner linear iterations of the last solve
+  void recordLinear(const int& its)
+  {
+    linearIterations = its;
+    totalLinearIterations += its;
+  }
+
+  /// Get the current wall clock time, for timing
+  static double now(void)
+  {
+    return MPI_Wtime();
+  }
+
+  /// Print a brief summary
+  void print(std::ostream& out) const
+  {
+    out << "solves = " << solves
+        << ", failures = " << failures
+        << ", iterations = " << iterations
+        << " (total " << totalIterations << ")";
+    if (totalLinearIterations > 0) {
+      out << ", linear iterations = " << linearIterations
+          << " (total " << totalLinearIterations << ")";
+    }
+    out << ", reason = " << reason
+        << ", residual = " << residualNorm
+        << ", setups = " << setups
+        << ", setup time = " << setupTime
+        << ", solve time = " << solveTime;
+    if (refinementFallbacks > 0) {
+      out << ", refinement fallbacks = " << refinementFallbacks;
+    }
+    out << std::endl;
+  }
+};
+
+} // namespace math
+} // namespace gridpack
+
+#endif
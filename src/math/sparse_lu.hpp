@@ -0,0 +1,480 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   sparse_lu.hpp
+ *
+ * @brief  A small, serial, sparse direct solver
+ *
+ *
+ */
+// -------------------------------------------------------------
+
+#ifndef _sparse_lu_hpp_
+#define _sparse_lu_hpp_
+
+#include <cmath>
+#include <complex>
+#include <set>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <gridpack/utilities/exception.hpp>
+
+namespace gridpack {
+namespace math {
+
+// -------------------------------------------------------------
+//  struct LowPrecision
+// -------------------------------------------------------------
+/// The single precision counterpart of a floating point type
+template <typename T> struct LowPrecision { typedef float type; };
+
+template <typename T> 
+struct LowPrecision< std::complex<T> > { typedef std::complex<float> type; };
+
+// -------------------------------------------------------------
+//  class SparseLU
+// -------------------------------------------------------------
+/// A serial sparse LU factorization
+/**
+ * This is a simple left-looking (Gilbert-Peierls) sparse LU
+ * factorization, in the style of KLU, intended for the modest sized,
+ * very sparse systems that arise from power grid networks when they
+ * are solved on a single process.  It has much less per-solve
+ * overhead than a general purpose library solver.
+ *
+ * Use is in three phases:
+ *
+ *  -# analyze() takes the pattern of the coefficient matrix, in
+ *     compressed sparse row (CSR) form, and computes a fill-reducing
+ *     column ordering (minimum degree on the pattern of
+ *     \f$A+A^T\f$);
+ *  -# factor() computes the numeric factorization, choosing row
+ *     pivots with a threshold that prefers the diagonal;
+ *  -# solve() solves for any number of right hand sides.
+ *
+ * If the coefficient values change, but not the pattern, refactor()
+ * repeats the numeric factorization using the pivot sequence and
+ * L/U patterns of the last factor(), which is considerably
+ * cheaper. Block triangular form is not computed, since network
+ * matrices are almost always irreducible.
+ *
+ * @c T can be any floating point type for which @c std::abs is
+ * defined, real or complex.
+ */
+template <typename T>
+class SparseLU
+{
+public:
+
+  /// Default constructor.
+  SparseLU(void)
+    : p_n(0), p_analyzed(false), p_factored(false),
+      p_pivotTolerance(0.001)
+  {}
+
+  /// Destructor
+  ~SparseLU(void)
+  {}
+
+  /// Has analyze() been called
+  bool analyzed(void) const
+  {
+    return p_analyzed;
+  }
+
+  /// Has a numeric factorization been computed
+  bool factored(void) const
+  {
+    return p_factored;
+  }
+
+  /// The order of the system
+  int size(void) const
+  {
+    return p_n;
+  }
+
+  /// Number of nonzeros in L (not including unit diagonal)
+  int nonzerosL(void) const
+  {
+    return static_cast<int>(p_Li.size());
+  }
+
+  /// Number of nonzeros in U (including diagonal)
+  int nonzerosU(void) const
+  {
+    return static_cast<int>(p_Ui.size() + p_Udiag.size());
+  }
+
+  /// Set the relative threshold for accepting a diagonal pivot
+  void pivotTolerance(const double& tol)
+  {
+    p_pivotTolerance = tol;
+  }
+
+  /// Is the specified CSR pattern the same as that analyzed
+  bool samePattern(const int& n, const int *rowptr, const int *colidx) const
+  {
+    if (!p_analyzed || n != p_n) return false;
+    if (!std::equal(rowptr, rowptr + n + 1, p_rowptr.begin())) return false;
+    return std::equal(colidx, colidx + rowptr[n], p_colidx.begin());
+  }
+
+  /// Analyze the pattern of a square CSR matrix
+  /**
+   * @param n number of rows (and columns)
+   * @param rowptr row start offsets (length n+1)
+   * @param colidx column indexes (length rowptr[n])
+   */
+  void analyze(const int& n, const int *rowptr, const int *colidx)
+  {
+    p_n = n;
+    p_rowptr.assign(rowptr, rowptr + n + 1);
+    int nnz(rowptr[n]);
+    p_colidx.assign(colidx, colidx + nnz);
+
+    // build the column compressed pattern and a map from CSR to CSC
+    // positions, so values can be scattered quickly
+
+    p_Ap.assign(n + 1, 0);
+    p_Ai.resize(nnz);
+    p_csrToCsc.resize(nnz);
+    for (int k = 0; k < nnz; ++k) {
+      int j(colidx[k]);
+      if (j < 0 || j >= n) {
+        throw Exception("SparseLU::analyze: column index out of range");
+      }
+      p_Ap[j+1]++;
+    }
+    for (int j = 0; j < n; ++j) p_Ap[j+1] += p_Ap[j];
+    std::vector<int> next(p_Ap.begin(), p_Ap.end() - 1);
+    for (int i = 0; i < n; ++i) {
+      for (int k = rowptr[i]; k < rowptr[i+1]; ++k) {
+        int pos(next[colidx[k]]++);
+        p_Ai[pos] = i;
+        p_csrToCsc[k] = pos;
+      }
+    }
+    p_Ax.resize(nnz);
+
+    p_minimumDegree();
+
+    p_analyzed = true;
+    p_factored = false;
+  }
+
+  /// Compute the numeric factorization, choosing pivots
+  /**
+   * @param values CSR values, in the same order as the analyzed pattern
+   */
+  void factor(const T *values)
+  {
+    if (!p_analyzed) {
+      throw Exception("SparseLU::factor: analyze() must be called first");
+    }
+    p_scatter(values);
+
+    const int n(p_n);
+    p_Lp.assign(1, 0); p_Li.clear(); p_Lx.clear();
+    p_Up.assign(1, 0); p_Ui.clear(); p_Ux.clear();
+    p_Udiag.assign(n, T(0.0));
+    p_pinv.assign(n, -1);
+    p_prow.assign(n, -1);
+
+    std::vector<T> x(n, T(0.0));
+    std::vector<int> stack(n), pstack(n), topo(n);
+    std::vector<int> mark(n, -1);
+
+    for (int k = 0; k < n; ++k) {
+      const int j(p_Q[k]);
+
+      // symbolic: rows reachable from the pattern of A(:,j) through
+      // the graph of L, in topological order (stored in topo[top..n-1])
+      int top(n);
+      for (int q = p_Ap[j]; q < p_Ap[j+1]; ++q) {
+        int i(p_Ai[q]);
+        if (mark[i] != k) top = p_reach(i, k, top, mark, stack, pstack, topo);
+      }
+
+      // numeric
+      for (int t = top; t < n; ++t) x[topo[t]] = T(0.0);
+      for (int q = p_Ap[j]; q < p_Ap[j+1]; ++q) x[p_Ai[q]] = p_Ax[q];
+      for (int t = top; t < n; ++t) {
+        int i(topo[t]);
+        int p(p_pinv[i]);
+        if (p < 0) continue;
+        T xi(x[i]);
+        for (int q = p_Lp[p]; q < p_Lp[p+1]; ++q) {
+          x[p_Li[q]] -= p_Lx[q]*xi;
+        }
+      }
+
+      // choose the pivot: the diagonal, if it's big enough, otherwise
+      // the largest candidate
+      int ipiv(-1);
+      double amax(-1.0);
+      for (int t = top; t < n; ++t) {
+        int i(topo[t]);
+        if (p_pinv[i] < 0) {
+          double a(std::abs(x[i]));
+          if (a > amax) {
+            amax = a;
+            ipiv = i;
+          }
+        }
+      }
+      if (ipiv < 0 || amax <= 0.0) {
+        p_factored = false;
+        throw Exception("SparseLU::factor: matrix is singular");
+      }
+      if (p_pinv[j] < 0 && mark[j] == k &&
+          std::abs(x[j]) >= p_pivotTolerance*amax) {
+        ipiv = j;
+      }
+      T pivot(x[ipiv]);
+      p_pinv[ipiv] = k;
+      p_prow[k] = ipiv;
+      p_Udiag[k] = pivot;
+
+      // store U(:,k) in topological order (refactor() depends on
+      // this) and L(:,k) scaled by the pivot
+      for (int t = top; t < n; ++t) {
+        int i(topo[t]);
+        int p(p_pinv[i]);
+        if (i == ipiv) continue;
+        if (p >= 0) {
+          p_Ui.push_back(p);
+          p_Ux.push_back(x[i]);
+        } else {
+          p_Li.push_back(i);
+          p_Lx.push_back(x[i]/pivot);
+        }
+        x[i] = T(0.0);
+      }
+      x[ipiv] = T(0.0);
+      p_Lp.push_back(static_cast<int>(p_Li.size()));
+      p_Up.push_back(static_cast<int>(p_Ui.size()));
+    }
+    p_factored = true;
+  }
+
+  /// Repeat the numeric factorization with new values, same pivots
+  /**
+   * The values must have the same pattern as the last analyze().  The
+   * pivot sequence from the last factor() is reused. If a pivot
+   * becomes zero, false is returned and the factorization is not
+   * usable; call factor() in that case.
+   *
+   * @param values CSR values, in the same order as the analyzed pattern
+   *
+   * @return true if successful
+   */
+  bool refactor(const T *values)
+  {
+    if (!p_factored) {
+      throw Exception("SparseLU::refactor: factor() must be called first");
+    }
+    p_scatter(values);
+
+    const int n(p_n);
+    std::vector<T> &x(p_work);
+    x.assign(n, T(0.0));
+
+    for (int k = 0; k < n; ++k) {
+      const int j(p_Q[k]);
+      for (int q = p_Ap[j]; q < p_Ap[j+1]; ++q) x[p_Ai[q]] = p_Ax[q];
+
+      for (int q = p_Up[k]; q < p_Up[k+1]; ++q) {
+        int p(p_Ui[q]);
+        T xi(x[p_prow[p]]);
+        p_Ux[q] = xi;
+        x[p_prow[p]] = T(0.0);
+        for (int r = p_Lp[p]; r < p_Lp[p+1]; ++r) {
+          x[p_Li[r]] -= p_Lx[r]*xi;
+        }
+      }
+
+      T pivot(x[p_prow[k]]);
+      x[p_prow[k]] = T(0.0);
+      if (!(std::abs(pivot) > 0.0)) {
+        p_factored = false;
+        return false;
+      }
+      p_Udiag[k] = pivot;
+      for (int r = p_Lp[k]; r < p_Lp[k+1]; ++r) {
+        p_Lx[r] = x[p_Li[r]]/pivot;
+        x[p_Li[r]] = T(0.0);
+      }
+    }
+    return true;
+  }
+
+  /// Solve in place: on entry @c x is the RHS, on exit the solution
+  void solve(T *x) const
+  {
+    if (!p_factored) {
+      throw Exception("SparseLU::solve: not factored");
+    }
+    const int n(p_n);
+    std::vector<T> &z(p_work);
+    z.resize(n);
+
+    // forward: L z = P b (L rows are original row indexes)
+    for (int p = 0; p < n; ++p) {
+      T zp(x[p_prow[p]]);
+      z[p] = zp;
+      for (int q = p_Lp[p]; q < p_Lp[p+1]; ++q) {
+        x[p_Li[q]] -= p_Lx[q]*zp;
+      }
+    }
+
+    // backward: U w = z (column oriented)
+    for (int k = n - 1; k >= 0; --k) {
+      T wk(z[k]/p_Udiag[k]);
+      z[k] = wk;
+      for (int q = p_Up[k]; q < p_Up[k+1]; ++q) {
+        z[p_Ui[q]] -= p_Ux[q]*wk;
+      }
+    }
+
+    // x = Q w
+    for (int k = 0; k < n; ++k) x[p_Q[k]] = z[k];
+  }
+
+protected:
+
+  /// System order
+  int p_n;
+
+  /// Has the pattern been analyzed
+  bool p_analyzed;
+
+  /// Is there a usable numeric factorization
+  bool p_factored;
+
+  /// Relative threshold for diagonal pivots
+  double p_pivotTolerance;
+
+  /// Analyzed CSR pattern
+  std::vector<int> p_rowptr, p_colidx;
+
+  /// Coefficient matrix in compressed sparse column form
+  std::vector<int> p_Ap, p_Ai;
+  std::vector<T> p_Ax;
+
+  /// Position of each CSR value in ::p_Ax
+  std::vector<int> p_csrToCsc;
+
+  /// Column ordering: step k eliminates column p_Q[k]
+  std::vector<int> p_Q;
+
+  /// Row pivots: p_pinv[row] is the step, p_prow[step] is the row
+  std::vector<int> p_pinv, p_prow;
+
+  /// L, by column (step), with original row indexes, unit diagonal not stored
+  std::vector<int> p_Lp, p_Li;
+  std::vector<T> p_Lx;
+
+  /// U, by column (step), with step row indexes, diagonal separate
+  std::vector<int> p_Up, p_Ui;
+  std::vector<T> p_Ux;
+  std::vector<T> p_Udiag;
+
+  /// Work space
+  mutable std::vector<T> p_work;
+
+  /// Put CSR values into ::p_Ax
+  void p_scatter(const T *values)
+  {
+    int nnz(p_rowptr[p_n]);
+    for (int k = 0; k < nnz; ++k) p_Ax[p_csrToCsc[k]] = values[k];
+  }
+
+  /// Depth first search from row i through the graph of L (non-recursive)
+  int p_reach(int i, const int& k, int top,
+              std::vector<int>& mark, std::vector<int>& stack,
+              std::vector<int>& pstack, std::vector<int>& topo) const
+  {
+    int head(0);
+    stack[0] = i;
+    while (head >= 0) {
+      int r(stack[head]);
+      int p(p_pinv[r]);
+      if (mark[r] != k) {
+        mark[r] = k;
+        pstack[head] = (p < 0 ? 0 : p_Lp[p]);
+      }
+      bool done(true);
+      if (p >= 0) {
+        int end(p_Lp[p+1]);
+        for (int q = pstack[head]; q < end; ++q) {
+          int c(p_Li[q]);
+          if (mark[c] == k) continue;
+          pstack[head] = q + 1;
+          stack[++head] = c;
+          done = false;
+          break;
+        }
+      }
+      if (done) {
+        head--;
+        topo[--top] = r;
+      }
+    }
+    return top;
+  }
+
+  /// Compute ::p_Q by minimum degree on the pattern of A+A^T
+  void p_minimumDegree(void)
+  {
+    const int n(p_n);
+    std::vector< std::set<int> > adj(n);
+    for (int i = 0; i < n; ++i) {
+      for (int k = p_rowptr[i]; k < p_rowptr[i+1]; ++k) {
+        int j(p_colidx[k]);
+        if (i != j) {
+          adj[i].insert(j);
+          adj[j].insert(i);
+        }
+      }
+    }
+
+    std::set< std::pair<int, int> > degree;
+    for (int i = 0; i < n; ++i) {
+      degree.insert(std::make_pair(static_cast<int>(adj[i].size()), i));
+    }
+
+    p_Q.clear();
+    p_Q.reserve(n);
+    while (!degree.empty()) {
+      int v(degree.begin()->second);
+      degree.erase(degree.begin());
+      p_Q.push_back(v);
+
+      // eliminate v: its neighbors become a clique
+      std::vector<int> nbr(adj[v].begin(), adj[v].end());
+      for (size_t a = 0; a < nbr.size(); ++a) {
+        int u(nbr[a]);
+        degree.erase(std::make_pair(static_cast<int>(adj[u].size()), u));
+        adj[u].erase(v);
+        for (size_t b = 0; b < nbr.size(); ++b) {
+          if (b != a) adj[u].insert(nbr[b]);
+        }
+        degree.insert(std::make_pair(static_cast<int>(adj[u].size()), u));
+      }
+      adj[v].clear();
+    }
+  }
+};
+
+} // namespace math
+} // namespace gridpack
+
+#endif
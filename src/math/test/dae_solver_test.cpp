@@ -18,8 +18,11 @@
 // -------------------------------------------------------------
 
 #include <iostream>
+#include <cmath>
 #include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/assert.hpp>
+#include <petscversion.h>
 #include "dae_solver.hpp"
 
 #include "test_main.cpp"
@@ -361,6 +364,127 @@ protected:
 };
 
 
+// -------------------------------------------------------------
+//  class SwitchedDecayProblem
+// -------------------------------------------------------------
+/// x' = -k x, where k changes from 1 to 2 at t = 1
+/**
+ * The change in k is a time event.  A state event locates the time
+ * x falls to 0.5, which should be ln(2).
+ */
+class SwitchedDecayProblem 
+  : public Problem
+{
+public:
+
+  /// Default constructor.
+  SwitchedDecayProblem()
+    : Problem(1, 2.0, 2.0),
+      p_k(1.0), p_crossing(-1.0)
+  {}
+
+  /// Destructor
+  ~SwitchedDecayProblem(void)
+  {}
+
+  /// Build a Jacobian
+  void operator() (const double& time, 
+                   const VectorType& X, const VectorType& Xdot, 
+                   const double& shift, MatrixType& J)
+  {
+    int lo, hi;
+    X.localIndexRange(lo, hi);
+    J.setElement(lo+0, lo+0, shift + p_k);
+    J.ready();
+  }
+
+  /// Build the RHS vector
+  void operator() (const double& t, 
+                   const VectorType& X, const VectorType& Xdot, 
+                   VectorType& F)
+  {
+    int lo, hi;
+    X.localIndexRange(lo, hi);
+    TestType x, xdot;
+    X.getElement(lo, x);
+    Xdot.getElement(lo, xdot);
+    F.setElement(lo+0, xdot + p_k*x);
+    F.ready();
+  }
+
+  /// Get the initial solution
+  VectorType *initial(const gridpack::parallel::Communicator& comm)
+  {
+    VectorType *result = 
+      new VectorType(comm, this->size());
+    result->fill(1.0);
+    result->ready();
+    return result;
+  }
+
+  /// Time event: change the decay rate
+  void faster(const double& t, VectorType& x)
+  {
+    p_k = 2.0;
+  }
+
+  /// State event indicator
+  double half(const double& t, const VectorType& x)
+  {
+    return x.normInfinity() - 0.5;
+  }
+
+  /// State event handler
+  void crossed(const double& t, VectorType& x)
+  {
+    p_crossing = t;
+  }
+
+  /// Solve the problem with events, return the solution at the end
+  /**
+   * The state event is only added if @c stateEvent is true, because
+   * state events need PETSc 3.7 or newer.
+   */
+  double solveWithEvents(const gridpack::parallel::Communicator& comm,
+                         gridpack::utility::Configuration::CursorPtr conf,
+                         const bool& stateEvent)
+  {
+    TheSolverType::JacobianBuilder jbuilder = boost::ref(*this);
+    TheSolverType::FunctionBuilder fbuilder = boost::ref(*this);
+    TheSolverType solver(comm, p_size, jbuilder, fbuilder);
+    solver.configurationKey("EventDAESolver");
+    solver.configure(conf);
+
+    solver.addTimeEvent(1.0, boost::bind(&SwitchedDecayProblem::faster, this, _1, _2));
+    if (stateEvent) {
+      solver.addStateEvent(boost::bind(&SwitchedDecayProblem::half, this, _1, _2),
+                           boost::bind(&SwitchedDecayProblem::crossed, this, _1, _2),
+                           -1);
+    }
+
+    boost::scoped_ptr<VectorType> x(initial(comm));
+    solver.initialize(0.0, 0.001, *x);
+    double t(p_maxtime);
+    solver.solve(t, p_maxsteps);
+    BOOST_CHECK_CLOSE(t, p_maxtime, 1.0e-06);
+    return x->normInfinity();
+  }
+
+  /// The time of the state event
+  double crossing(void) const
+  {
+    return p_crossing;
+  }
+
+protected:
+
+  /// The decay rate
+  double p_k;
+
+  /// The time the state event was handled
+  double p_crossing;
+};
+
 
 BOOST_AUTO_TEST_SUITE(DAESolverTest)
 
@@ -393,6 +517,26 @@ BOOST_AUTO_TEST_CASE( CE )
 
 }
 
+BOOST_AUTO_TEST_CASE( Events )
+{
+  gridpack::parallel::Communicator world;
+
+  SwitchedDecayProblem p;
+
+  // state events are not available with older PETSc
+#if PETSC_VERSION_GE(3,7,0)
+  static const bool stateEvent(true);
+#else
+  static const bool stateEvent(false);
+#endif
+
+  double x(p.solveWithEvents(world, test_config, stateEvent));
+  BOOST_CHECK_CLOSE(x, exp(-3.0), 0.1);
+  if (stateEvent) {
+    BOOST_CHECK_CLOSE(p.crossing(), log(2.0), 0.1);
+  }
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
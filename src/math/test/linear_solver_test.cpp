@@ -17,10 +17,12 @@
 // -------------------------------------------------------------
 
 #include <iostream>
+#include <cmath>
 #include <boost/scoped_ptr.hpp>
 #include <boost/format.hpp>
 #include "linear_solver.hpp"
 #include "linear_matrix_solver.hpp"
+#include "low_rank_update_solver.hpp"
 
 #include "test_main.cpp"
 
@@ -197,6 +199,17 @@ BOOST_AUTO_TEST_CASE( Versteeg )
   l1norm = res->norm1();
   l2norm = res->norm2();
 
+  // both solves should be recorded
+  const gridpack::math::SolverStatistics& stats(solver->statistics());
+  BOOST_CHECK_EQUAL(stats.solves, 2);
+  BOOST_CHECK_EQUAL(stats.failures, 0);
+  BOOST_CHECK(stats.converged);
+  BOOST_CHECK(stats.totalIterations >= stats.iterations);
+  BOOST_CHECK(stats.setupTime >= 0.0);
+  BOOST_CHECK(stats.solveTime >= 0.0);
+  solver->resetStatistics();
+  BOOST_CHECK_EQUAL(solver->statistics().solves, 0);
+
   for (int p = 0; p < world.size(); ++p) {
     if (p == world.rank()) {
       int ilo, ihi;
@@ -218,6 +231,63 @@ BOOST_AUTO_TEST_CASE( Versteeg )
   }
 }
 
+// -------------------------------------------------------------
+/**
+ * Solve the Versteeg problem twice, with different solvers, sharing
+ * a LinearSolverAnalysis. The second coefficient matrix has the same
+ * pattern, so the symbolic analysis should only be done once.
+ */
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( VersteegSharedAnalysis )
+{
+  gridpack::parallel::Communicator world;
+
+  static const int imax = 3*world.size();
+  static const int jmax = 4*world.size();
+  static const int global_size = imax*jmax;
+  int local_size(global_size/world.size());
+
+  gridpack::math::LinearSolverAnalysisPtr 
+    analysis(new gridpack::math::LinearSolverAnalysis(world));
+
+  for (int k = 1; k <= 2; ++k) {
+    boost::scoped_ptr<gridpack::math::RealMatrix> 
+      A(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                       gridpack::math::Sparse));
+    boost::scoped_ptr<gridpack::math::RealVector>
+      b(new gridpack::math::RealVector(world, local_size)),
+      x(new gridpack::math::RealVector(world, local_size));
+
+    assemble(imax, jmax, *A, *b);
+    A->ready();
+    b->ready();
+
+    // same pattern, different values, same solution
+    A->scale(static_cast<double>(k));
+    b->scale(static_cast<double>(k));
+
+    x->fill(0.0);
+    x->ready();
+
+    boost::scoped_ptr<gridpack::math::RealLinearSolver> 
+      solver(new gridpack::math::RealLinearSolver(*A, analysis));
+
+    BOOST_REQUIRE(test_config);
+    solver->configure(test_config);
+    solver->solve(*b, *x);
+
+    boost::scoped_ptr<gridpack::math::RealVector>
+      res(multiply(*A, *x));
+    res->add(*b, -1.0);
+
+    double l2norm(res->norm2());
+    BOOST_CHECK(l2norm < 1.0e-05*k);
+  }
+
+  BOOST_CHECK_EQUAL(analysis->symbolicFactorizations(), 1);
+  BOOST_CHECK_EQUAL(analysis->numericFactorizations(), 2);
+}
+
 // FIXME
 BOOST_AUTO_TEST_CASE ( VersteegInverse )
 {
@@ -285,6 +355,271 @@ BOOST_AUTO_TEST_CASE ( VersteegInverse )
 }
 
 
+// -------------------------------------------------------------
+/// Test the blocked, in place, multiple RHS solve
+/**
+ * Solve the Versteeg problem with several right hand sides, each a
+ * multiple of the original, in a single call.
+ * 
+ */
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE ( VersteegBlockSolve )
+{
+  gridpack::parallel::Communicator world;
+
+  static const int imax = 3*world.size();
+  static const int jmax = 4*world.size();
+  static const int global_size = imax*jmax;
+  int local_size(global_size/world.size());
+  static const int local_cols = 2;
+  int ncols(local_cols*world.size());
+
+  boost::scoped_ptr<gridpack::math::RealMatrix> 
+    A(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                     gridpack::math::Sparse)),
+    B(new gridpack::math::RealMatrix(world, local_size, local_cols,
+                                     gridpack::math::Dense)),
+    X(new gridpack::math::RealMatrix(world, local_size, local_cols,
+                                     gridpack::math::Dense));
+  boost::scoped_ptr<gridpack::math::RealVector>
+    b(new gridpack::math::RealVector(world, local_size));
+
+  assemble(imax, jmax, *A, *b);
+  A->ready();
+  b->ready();
+
+  int ilo, ihi;
+  b->localIndexRange(ilo, ihi);
+  for (int i = ilo; i < ihi; ++i) {
+    gridpack::RealType v;
+    b->getElement(i, v);
+    for (int j = 0; j < ncols; ++j) {
+      B->setElement(i, j, v*static_cast<double>(j+1));
+    }
+  }
+  B->ready();
+  X->zero();
+  X->ready();
+
+  boost::scoped_ptr<gridpack::math::RealLinearSolver> 
+    solver(new gridpack::math::RealLinearSolver(*A));
+
+  BOOST_REQUIRE(test_config);
+  solver->configure(test_config);
+  solver->solve(*B, *X);
+
+  boost::scoped_ptr<gridpack::math::RealVector>
+    x(new gridpack::math::RealVector(world, local_size)),
+    bj(new gridpack::math::RealVector(world, local_size));
+  for (int j = 0; j < ncols; ++j) {
+    column(*X, j, *x);
+    column(*B, j, *bj);
+    boost::scoped_ptr<gridpack::math::RealVector> res(multiply(*A, *x));
+    res->add(*bj, -1.0);
+    double l2norm(res->norm2());
+    if (world.rank() == 0) {
+      std::cout << "Column " << j << " Residual L2 Norm = " << l2norm << std::endl;
+    }
+    BOOST_CHECK(l2norm < 1.0e-05*(j+1));
+  }
+}
+
+
+// -------------------------------------------------------------
+/// Test LowRankUpdateSolver against a direct solve of the modified system
+/**
+ * The Versteeg coefficient matrix is modified with a "branch" update
+ * between two neighboring cells, which only changes existing
+ * nonzeros.  The Woodbury solution and the fallback (explicitly
+ * refactored) solution are compared to a direct solution.
+ */
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( VersteegLowRankUpdate )
+{
+  gridpack::parallel::Communicator world;
+
+  static const int imax = 3*world.size();
+  static const int jmax = 4*world.size();
+  static const int global_size = imax*jmax;
+  int local_size(global_size/world.size());
+
+  boost::scoped_ptr<gridpack::math::RealMatrix> 
+    A(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                     gridpack::math::Sparse)),
+    Amod(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                        gridpack::math::Sparse));
+  boost::scoped_ptr<gridpack::math::RealVector>
+    b(new gridpack::math::RealVector(world, local_size)),
+    x(new gridpack::math::RealVector(world, local_size)),
+    xmod(new gridpack::math::RealVector(world, local_size));
+
+  assemble(imax, jmax, *A, *b);
+  A->ready();
+  b->ready();
+
+  // cells 0 and 1 are neighbors, so this does not change the pattern
+  static const double c(5.0);
+  assemble(imax, jmax, *Amod, *b);
+  Amod->ready();
+  int lo, hi;
+  Amod->localRowRange(lo, hi);
+  if (lo <= 0 && 0 < hi) {
+    Amod->addElement(0, 0, c);
+    Amod->addElement(0, 1, -c);
+  }
+  if (lo <= 1 && 1 < hi) {
+    Amod->addElement(1, 0, -c);
+    Amod->addElement(1, 1, c);
+  }
+  Amod->ready();
+  b->ready();
+
+  BOOST_REQUIRE(test_config);
+
+  xmod->zero();
+  xmod->ready();
+  gridpack::math::RealLinearSolver direct(*Amod);
+  direct.configure(test_config);
+  direct.solve(*b, *xmod);
+
+  gridpack::math::RealLowRankUpdateSolver solver(*A);
+  solver.configure(test_config);
+  solver.addBranchUpdate(0, 1, c);
+  BOOST_CHECK_EQUAL(solver.rank(), 1);
+
+  x->zero();
+  x->ready();
+  solver.solve(*b, *x);
+  BOOST_CHECK(!solver.refactored());
+  x->add(*xmod, -1.0);
+  BOOST_CHECK(x->norm2() < 1.0e-05*xmod->norm2());
+
+  // force the fallback
+  solver.maximumRank(0);
+  x->zero();
+  x->ready();
+  solver.solve(*b, *x);
+  BOOST_CHECK(solver.refactored());
+  x->add(*xmod, -1.0);
+  BOOST_CHECK(x->norm2() < 1.0e-05*xmod->norm2());
+
+  // back to the base system
+  solver.clearUpdates();
+  solver.maximumRank(8);
+  x->zero();
+  x->ready();
+  solver.solve(*b, *x);
+  boost::scoped_ptr<gridpack::math::RealVector> res(multiply(*A, *x));
+  res->add(*b, -1.0);
+  BOOST_CHECK(res->norm2() < 1.0e-05);
+}
+
+// -------------------------------------------------------------
+// BlockDiagonalSolve
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( BlockDiagonalSolve )
+{
+  gridpack::parallel::Communicator world;
+  static const int bs(2);
+  static const int local_size(4*bs);
+
+  boost::scoped_ptr<gridpack::math::RealMatrix> 
+    A(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                     gridpack::math::BlockDiagonal, bs));
+  boost::scoped_ptr<gridpack::math::RealVector>
+    b(new gridpack::math::RealVector(world, local_size)),
+    x(new gridpack::math::RealVector(world, local_size));
+  BOOST_CHECK_EQUAL(A->storageType(), gridpack::math::BlockDiagonal);
+
+  // each block is [ 0 a ; 1 1 ], which needs pivoting
+  int lo, hi;
+  A->localRowRange(lo, hi);
+  for (int i = lo; i < hi; i += bs) {
+    double a(static_cast<double>(i + 2));
+    A->setElement(i, i+1, a);
+    A->setElement(i+1, i, 1.0);
+    A->setElement(i+1, i+1, 1.0);
+    b->setElement(i, a);
+    b->setElement(i+1, 2.0);
+  }
+  A->ready();
+  b->ready();
+
+  BOOST_REQUIRE(test_config);
+  gridpack::math::RealLinearSolver solver(*A);
+  solver.configure(test_config);
+  x->zero();
+  x->ready();
+  solver.solve(*b, *x);
+
+  // the solution is all ones
+  boost::scoped_ptr<gridpack::math::RealVector> res(multiply(*A, *x));
+  res->add(*b, -1.0);
+  BOOST_CHECK(res->norm2() < 1.0e-10);
+  BOOST_CHECK_CLOSE(x->norm2(), std::sqrt(static_cast<double>(x->size())), 1.0e-08);
+  BOOST_CHECK_EQUAL(solver.statistics().iterations, 1);
+}
+
+// -------------------------------------------------------------
+/// Test mixed precision LU and its double precision fallback
+/**
+ * A tridiagonal system is solved with a single precision
+ * factorization and iterative refinement.  Then the first row is
+ * scaled by a factor that underflows in single precision, which makes
+ * the single precision factorization singular, so the solver must
+ * fall back to double precision.  In both cases, the solution (all
+ * ones) must have double precision accuracy.
+ */
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( MixedPrecisionFallback )
+{
+  gridpack::parallel::Communicator world;
+  static const int local_size(10);
+  static const int global_size(local_size*world.size());
+  static const double tiny(1.0e-50);
+
+  for (int pass = 0; pass < 2; ++pass) {
+    boost::scoped_ptr<gridpack::math::RealMatrix> 
+      A(new gridpack::math::RealMatrix(world, local_size, local_size, 
+                                       gridpack::math::Sparse));
+    boost::scoped_ptr<gridpack::math::RealVector>
+      x(new gridpack::math::RealVector(world, local_size)),
+      ones(new gridpack::math::RealVector(world, local_size));
+
+    int lo, hi;
+    A->localRowRange(lo, hi);
+    for (int i = lo; i < hi; ++i) {
+      double scale((pass == 1 && i == 0) ? tiny : 1.0);
+      A->setElement(i, i, 4.0*scale);
+      if (i > 0) A->setElement(i, i-1, -1.0*scale);
+      if (i < global_size - 1) A->setElement(i, i+1, -1.0*scale);
+    }
+    A->ready();
+    ones->fill(1.0);
+    ones->ready();
+    boost::scoped_ptr<gridpack::math::RealVector> b(multiply(*A, *ones));
+
+    BOOST_REQUIRE(test_config);
+    gridpack::math::RealLinearSolver solver(*A);
+    solver.configurationKey("MixedPrecisionLinearSolver");
+    solver.configure(test_config);
+
+    // solve twice to make sure the fallback is only counted once
+    for (int k = 0; k < 2; ++k) {
+      x->zero();
+      x->ready();
+      solver.solve(*b, *x);
+      x->add(*ones, -1.0);
+      BOOST_CHECK_SMALL(x->normInfinity(), 1.0e-12);
+    }
+
+    const gridpack::math::SolverStatistics& stats(solver.statistics());
+    BOOST_CHECK_EQUAL(stats.refinementFallbacks, pass);
+    BOOST_CHECK_EQUAL(stats.usedFallback, (pass == 1));
+    if (pass == 0) BOOST_CHECK(stats.iterations > 1);
+  }
+}
+
 // -------------------------------------------------------------
 /// Test matrix inversion with LinearMatrixSolver
 /**
@@ -960,6 +960,102 @@ BOOST_AUTO_TEST_CASE ( MatrixMatrixMultiplyDifferent )
   testMatrixMultiply(A.get(), B.get());
 }
 
+// -------------------------------------------------------------
+/// Transpose and matrix-matrix products should keep the storage type
+/**
+ * Sparse operands must give sparse results; nothing should be
+ * densified along the way, regardless of the element type.
+ */
+// -------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( ProductStorage )
+{
+  int global_size;
+  gridpack::parallel::Communicator world;
+  boost::scoped_ptr<TestMatrixType> 
+    A(make_and_fill_test_matrix(world, 3, global_size));
+
+  boost::scoped_ptr<TestMatrixType> 
+    At(gridpack::math::transpose(*A));
+  BOOST_CHECK_EQUAL(At->storageType(), the_storage_type);
+
+  boost::scoped_ptr<TestMatrixType> 
+    AtA(gridpack::math::multiply(*At, *A));
+  BOOST_CHECK_EQUAL(AtA->storageType(), the_storage_type);
+  BOOST_CHECK_EQUAL(AtA->rows(), global_size);
+  BOOST_CHECK_EQUAL(AtA->cols(), global_size);
+
+  // A is symmetric in pattern, and the (i,i) element of A^T A is the
+  // sum of the squares of column i of A
+  int lo, hi;
+  AtA->localRowRange(lo, hi);
+  for (int i = lo; i < hi; ++i) {
+    TestType x(0.0), y;
+    for (int k = std::max(i-1, 0); k <= std::min(i+1, global_size-1); ++k) {
+      TestType a(static_cast<double>(k));
+      x += a*a;
+    }
+    AtA->getElement(i, i, y);
+    if (std::abs(x) > 0.0) {
+      TEST_VALUE_CLOSE(x, y, delta);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( DiagonalStorage )
+{
+  int global_size;
+  gridpack::parallel::Communicator world;
+  boost::scoped_ptr<TestMatrixType> 
+    A(make_and_fill_test_matrix(world, 3, global_size));
+  boost::scoped_ptr<TestMatrixType> 
+    D(new TestMatrixType(world, local_size, local_size, 
+                         gridpack::math::Diagonal, 1));
+  BOOST_CHECK_EQUAL(D->storageType(), gridpack::math::Diagonal);
+
+  int lo, hi;
+  D->localRowRange(lo, hi);
+  for (int i = lo; i < hi; ++i) {
+    D->setElement(i, i, TEST_VALUE(static_cast<double>(i+1), 0.0));
+  }
+  D->ready();
+
+  // D*A scales rows and A*D scales columns 
+  boost::scoped_ptr<TestMatrixType> 
+    DA(gridpack::math::multiply(*D, *A)),
+    AD(gridpack::math::multiply(*A, *D));
+  BOOST_CHECK_EQUAL(DA->rows(), global_size);
+  BOOST_CHECK_EQUAL(AD->cols(), global_size);
+
+  for (int i = lo; i < hi; ++i) {
+    int jmin(std::max(i-1, 0)), jmax(std::min(i+1, global_size-1));
+    for (int j = jmin; j <= jmax; ++j) {
+      TestType a(static_cast<double>(i)), y;
+      DA->getElement(i, j, y);
+      TEST_VALUE_CLOSE(a*static_cast<double>(i+1), y, delta);
+      AD->getElement(i, j, y);
+      TEST_VALUE_CLOSE(a*static_cast<double>(j+1), y, delta);
+    }
+  }
+
+  // only the diagonal survives a conversion
+  boost::scoped_ptr<TestMatrixType> 
+    Ad(gridpack::math::storageType(*A, gridpack::math::Diagonal));
+  BOOST_CHECK_EQUAL(Ad->storageType(), gridpack::math::Diagonal);
+  boost::scoped_ptr<TestMatrixType> 
+    DD(gridpack::math::multiply(*D, *Ad));
+  BOOST_CHECK_EQUAL(DD->storageType(), gridpack::math::Diagonal);
+  for (int i = lo; i < hi; ++i) {
+    TestType y;
+    DD->getElement(i, i, y);
+    TEST_VALUE_CLOSE(static_cast<double>(i)*static_cast<double>(i+1), y, delta);
+  }
+
+  boost::scoped_ptr<TestMatrixType> 
+    B(gridpack::math::storageType(*D, gridpack::math::Sparse));
+  BOOST_CHECK_EQUAL(B->storageType(), gridpack::math::Sparse);
+  BOOST_CHECK_CLOSE(B->norm2(), D->norm2(), delta);
+}
+
 BOOST_AUTO_TEST_CASE( NonSquareTranspose )
 {
   gridpack::parallel::Communicator world;
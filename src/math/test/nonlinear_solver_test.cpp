@@ -345,6 +345,106 @@ BOOST_AUTO_TEST_CASE( example2 )
   X.print();
 }
 
+// -------------------------------------------------------------
+// Example 2 again, but matrix-free, with the Jacobian only used for
+// the preconditioner
+// -------------------------------------------------------------
+struct build_thing_product
+{
+  void operator() (const VectorType& X, const VectorType& V, 
+                   VectorType& JV) const
+  {
+    int n(X.size());
+    TestType d(static_cast<double>(n - 1));
+    d *= d;
+
+    int lo, hi;
+    X.localIndexRange(lo, hi);
+
+    std::vector<TestType> x(n), v(n);
+    X.getAllElements(&x[0]);
+    V.getAllElements(&v[0]);
+
+    for (int row = lo; row < hi; ++row) {
+      int i(row);
+      TestType jv;
+      if (row == 0 || row == n - 1) {
+        jv = v[i];
+      } else {
+        jv = d*(v[i-1] - 2.0*v[i] + v[i+1]) + 2.0*x[i]*v[i];
+      }
+      JV.setElement(row, jv);
+    }
+    JV.ready();
+  }
+};
+
+// Counts the calls that build the assembled Jacobian
+struct count_thing
+{
+  build_thing thing;
+  int *count;
+
+  count_thing(int *c) : count(c) {}
+
+  void operator() (const VectorType& X, MatrixType& J) const
+  {
+    (*count)++;
+    thing(X, J);
+  }
+
+  void operator() (const VectorType& X, VectorType& F) const
+  {
+    thing(X, F);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( example2_matrix_free )
+{
+  gridpack::parallel::Communicator world;
+  int local_size(4);
+
+  build_thing thing;
+  TheNonlinearSolver::JacobianBuilder j = thing;
+  TheNonlinearSolver::FunctionBuilder f = thing;
+
+  TheNonlinearSolver full(world, local_size, j, f);
+  full.configure(test_config);
+  VectorType Xfull(world, local_size);
+  Xfull.fill(0.5);
+  Xfull.ready();
+  full.solve(Xfull);
+
+  // once with finite differences and once with an exact product 
+  for (int exact = 0; exact < 2; ++exact) {
+    int builds(0);
+    count_thing counter(&builds);
+    TheNonlinearSolver::JacobianBuilder jcount = counter;
+    TheNonlinearSolver solver(world, local_size, jcount, f);
+    if (exact) {
+      solver.jacobianProduct(build_thing_product());
+    }
+    solver.configurationKey("MatrixFreeNonlinearSolver");
+    BOOST_REQUIRE(test_config);
+    solver.configure(test_config);
+
+    VectorType X(world, local_size);
+    X.fill(0.5);
+    X.ready();
+    solver.solve(X);
+
+    X.add(Xfull, -1.0);
+    BOOST_CHECK(X.normInfinity() < 1.0e-06);
+
+    // with a PreconditionerInterval, the Jacobian is not built
+    // every iteration
+    const gridpack::math::SolverStatistics& stats(solver.statistics());
+    BOOST_CHECK(builds > 0);
+    BOOST_CHECK(builds < stats.iterations);
+    BOOST_CHECK_EQUAL(stats.setups, builds);
+  }
+}
+
 BOOST_AUTO_TEST_CASE( example2_nr )
 {
   gridpack::parallel::Communicator world;
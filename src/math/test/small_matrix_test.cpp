@@ -0,0 +1,221 @@
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   small_matrix_test.cpp
+ *
+ * @brief  Unit tests for batched small dense matrix operations
+ *
+ * @test
+ */
+// -------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#include "gridpack/utilities/complex.hpp"
+#include "small_matrix.hpp"
+
+#define BOOST_TEST_NO_MAIN
+#define BOOST_TEST_ALTERNATIVE_INIT_API
+#include <boost/test/included/unit_test.hpp>
+
+// -------------------------------------------------------------
+// fillBatch
+// -------------------------------------------------------------
+/// Fill a batch with random matrices; the first needs pivoting
+template <typename T, int N>
+void
+fillBatch(gridpack::math::SmallMatrixBatch<T, N>& batch,
+          std::vector<T>& orig)
+{
+  std::srand(N);
+  int nb(batch.count());
+  orig.resize(nb*N*N);
+  for (int m = 0; m < nb; ++m) {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        double v(static_cast<double>(std::rand() % 100)/10.0 - 5.0);
+        if (i == j) v += (m == 0 ? -v : 10.0);
+        orig[(m*N + i)*N + j] = T(v);
+      }
+    }
+    batch.set(m, &orig[m*N*N]);
+  }
+}
+
+// -------------------------------------------------------------
+// batchSolveError
+// -------------------------------------------------------------
+/// Solve all systems in a batch with known solutions, return the max error
+template <typename T, int N>
+double
+batchSolveError(const int& nb)
+{
+  gridpack::math::SmallMatrixBatch<T, N> batch(nb);
+  std::vector<T> orig;
+  fillBatch(batch, orig);
+  BOOST_CHECK(batch.factor());
+
+  // b = A*x with x(i) = i + m + 1
+  std::vector<T> b(N*nb, T(0.0));
+  for (int m = 0; m < nb; ++m) {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        b[i*nb + m] += orig[(m*N + i)*N + j]*T(static_cast<double>(j + m + 1));
+      }
+    }
+  }
+  batch.solve(&b[0]);
+
+  double err(0.0);
+  for (int m = 0; m < nb; ++m) {
+    for (int i = 0; i < N; ++i) {
+      err = std::max(err, std::abs(b[i*nb + m] - T(static_cast<double>(i + m + 1))));
+    }
+  }
+  return err;
+}
+
+BOOST_AUTO_TEST_SUITE(SmallMatrixTest)
+
+BOOST_AUTO_TEST_CASE(RealBatchSolve)
+{
+  BOOST_CHECK_SMALL((batchSolveError<double, 2>(37)), 1.0e-10);
+  BOOST_CHECK_SMALL((batchSolveError<double, 4>(16)), 1.0e-10);
+  BOOST_CHECK_SMALL((batchSolveError<double, 9>(5)), 1.0e-10);
+  BOOST_CHECK_SMALL((batchSolveError<double, 16>(3)), 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(ComplexBatchSolve)
+{
+  BOOST_CHECK_SMALL((batchSolveError<gridpack::ComplexType, 2>(11)), 1.0e-10);
+  BOOST_CHECK_SMALL((batchSolveError<gridpack::ComplexType, 10>(4)), 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(SingleSolve)
+{
+  // the 9x9 system from small_matrix_solve
+  typedef gridpack::ComplexType C;
+  static const int N(9);
+  gridpack::math::SmallMatrixBatch<C, N> batch(1);
+  batch(0, 0, 0) = C(0, -33.8085);
+  batch(0, 0, 3) = C(0,  17.3611);
+  batch(0, 1, 1) = C(0, -24.3472);
+  batch(0, 1, 7) = C(0,  16);
+  batch(0, 2, 2) = C(0, -22.5806);
+  batch(0, 2, 5) = C(0,  17.0648);
+  batch(0, 3, 0) = C(0,  17.3611);
+  batch(0, 3, 3) = C(0, -39.9954);
+  batch(0, 3, 4) = C(0,  10.8696);
+  batch(0, 3, 8) = C(0,  11.7647);
+  batch(0, 4, 3) = C(0,  10.8696);
+  batch(0, 4, 4) = C(0.934, -17.0633);
+  batch(0, 4, 5) = C(0,  5.88235);
+  batch(0, 5, 2) = C(0,  17.0648);
+  batch(0, 5, 4) = C(0,  5.88235);
+  batch(0, 5, 5) = C(0, -32.8678);
+  batch(0, 5, 6) = C(0,  9.92063);
+  batch(0, 6, 5) = C(0,  9.92063);
+  batch(0, 6, 6) = C(1.03854, -24.173);
+  batch(0, 6, 7) = C(0,  13.8889);
+  batch(0, 7, 1) = C(0,  16);
+  batch(0, 7, 6) = C(0,  13.8889);
+  batch(0, 7, 7) = C(0, -36.1001);
+  batch(0, 7, 8) = C(0,  6.21118);
+  batch(0, 8, 3) = C(0,  11.7647);
+  batch(0, 8, 7) = C(0,  6.21118);
+  batch(0, 8, 8) = C(1.33901, -18.5115);
+  BOOST_REQUIRE(batch.factor());
+
+  // first column of the expected answer
+  std::vector<C> b(N, C(0.0));
+  b[0] = C(0, 16.4474);
+  batch.solve(0, &b[0]);
+  BOOST_CHECK_SMALL(std::abs(b[0] - C(-0.802694, 0.0362709)), 1.0e-05);
+  BOOST_CHECK_SMALL(std::abs(b[4] - C(-0.478041, 0.0933363)), 1.0e-05);
+  BOOST_CHECK_SMALL(std::abs(b[8] - C(-0.467188, 0.100364)), 1.0e-05);
+}
+
+BOOST_AUTO_TEST_CASE(Inverse)
+{
+  static const int N(5), nb(7);
+  gridpack::math::SmallMatrixBatch<double, N> batch(nb), inv;
+  std::vector<double> orig;
+  fillBatch(batch, orig);
+  batch.factor();
+  batch.inverse(inv);
+  BOOST_CHECK_EQUAL(inv.count(), nb);
+
+  double err(0.0);
+  for (int m = 0; m < nb; ++m) {
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        double s(0.0);
+        for (int k = 0; k < N; ++k) {
+          s += orig[(m*N + i)*N + k]*inv(m, k, j);
+        }
+        err = std::max(err, std::abs(s - (i == j ? 1.0 : 0.0)));
+      }
+    }
+  }
+  BOOST_CHECK_SMALL(err, 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(Singular)
+{
+  // the second matrix is singular, the others should not care
+  static const int N(3);
+  double a[3][N*N] = {
+    { 2, 1, 0,   1, 3, 1,   0, 1, 4 },
+    { 1, 2, 3,   2, 4, 6,   0, 1, 1 },
+    { 0, 1, 0,   1, 0, 0,   0, 0, 1 }
+  };
+  std::vector<double> work(&a[0][0], &a[0][0] + 3*N*N);
+  BOOST_CHECK_EQUAL(gridpack::math::invertSmallMatrices(N, 3, &work[0]), 1);
+
+  // the third is a permutation, which is its own inverse
+  for (int k = 0; k < N*N; ++k) {
+    BOOST_CHECK_EQUAL(work[2*N*N + k], a[2][k]);
+    BOOST_CHECK_EQUAL(work[N*N + k], a[1][k]);
+  }
+
+  // an order with no fixed size template
+  static const int n(17);
+  std::vector<double> big(n*n, 0.0), bigorig;
+  for (int i = 0; i < n; ++i) {
+    big[i*n + i] = 4.0;
+    if (i > 0) big[i*n + i - 1] = -1.0;
+    if (i < n - 1) big[i*n + i + 1] = -1.0;
+  }
+  bigorig = big;
+  BOOST_CHECK_EQUAL(gridpack::math::invertSmallMatrices(n, 1, &big[0]), -1);
+  double s(0.0);
+  for (int k = 0; k < n; ++k) s += bigorig[k]*big[k*n];
+  BOOST_CHECK_CLOSE(s, 1.0, 1.0e-08);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// -------------------------------------------------------------
+// init_function
+// -------------------------------------------------------------
+bool init_function()
+{
+  return true;
+}
+
+// -------------------------------------------------------------
+//  Main Program
+// -------------------------------------------------------------
+int
+main(int argc, char **argv)
+{
+  int result = ::boost::unit_test::unit_test_main( &init_function, argc, argv );
+  return result;
+}
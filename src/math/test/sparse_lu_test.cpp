@@ -0,0 +1,175 @@
+// -------------------------------------------------------------
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   sparse_lu_test.cpp
+ * 
+ * @brief  Unit tests for the built-in serial sparse LU
+ * 
+ * @test
+ */
+// -------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <cstdlib>
+
+#include "gridpack/utilities/complex.hpp"
+#include "sparse_lu.hpp"
+
+#define BOOST_TEST_NO_MAIN
+#define BOOST_TEST_ALTERNATIVE_INIT_API
+#include <boost/test/included/unit_test.hpp>
+
+// -------------------------------------------------------------
+// makeSystem
+// -------------------------------------------------------------
+/// Make a random, sparse, nonsymmetric system with known solution
+/**
+ * Each row has a tridiagonal band plus a few random entries. Every
+ * third diagonal is zero (if @c zeroDiag) so off-diagonal pivots are
+ * required.
+ */
+template <typename T>
+void
+makeSystem(const int& n, const bool& zeroDiag,
+           std::vector<int>& rowptr, std::vector<int>& colidx,
+           std::vector<T>& values)
+{
+  std::srand(n);
+  rowptr.assign(1, 0);
+  colidx.clear();
+  values.clear();
+  for (int i = 0; i < n; ++i) {
+    std::set<int> cols;
+    cols.insert(i);
+    if (i > 0) cols.insert(i-1);
+    if (i < n-1) cols.insert(i+1);
+    for (int k = 0; k < 2; ++k) cols.insert(std::rand() % n);
+    for (std::set<int>::iterator c = cols.begin(); c != cols.end(); ++c) {
+      double v(static_cast<double>(std::rand() % 100)/10.0 - 5.0);
+      if (*c == i) {
+        v = (zeroDiag && i % 3 == 0) ? 0.0 : v + 20.0;
+      }
+      colidx.push_back(*c);
+      values.push_back(T(v));
+    }
+    rowptr.push_back(colidx.size());
+  }
+}
+
+// -------------------------------------------------------------
+// solveError
+// -------------------------------------------------------------
+/// Solve a system with a known solution, return the max error
+template <typename T>
+double
+solveError(const gridpack::math::SparseLU<T>& lu, const int& n, 
+           const std::vector<int>& rowptr, const std::vector<int>& colidx,
+           const std::vector<T>& values)
+{
+  std::vector<T> xtrue(n), x(n, T(0.0));
+  for (int i = 0; i < n; ++i) xtrue[i] = T(static_cast<double>(i % 5 + 1));
+  for (int i = 0; i < n; ++i) {
+    for (int k = rowptr[i]; k < rowptr[i+1]; ++k) {
+      x[i] += values[k]*xtrue[colidx[k]];
+    }
+  }
+  lu.solve(&x[0]);
+  double err(0.0);
+  for (int i = 0; i < n; ++i) {
+    err = std::max(err, static_cast<double>(std::abs(x[i] - xtrue[i])));
+  }
+  return err;
+}
+
+BOOST_AUTO_TEST_SUITE(SparseLUTest)
+
+BOOST_AUTO_TEST_CASE(RealFactorSolve)
+{
+  static const int n(200);
+  std::vector<int> rowptr, colidx;
+  std::vector<gridpack::RealType> values;
+  makeSystem(n, false, rowptr, colidx, values);
+
+  gridpack::math::SparseLU<gridpack::RealType> lu;
+  lu.analyze(n, &rowptr[0], &colidx[0]);
+  BOOST_CHECK(lu.analyzed());
+  lu.factor(&values[0]);
+  BOOST_CHECK(lu.factored());
+  BOOST_CHECK(solveError(lu, n, rowptr, colidx, values) < 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(ZeroDiagonalPivoting)
+{
+  static const int n(150);
+  std::vector<int> rowptr, colidx;
+  std::vector<gridpack::RealType> values;
+  makeSystem(n, true, rowptr, colidx, values);
+
+  gridpack::math::SparseLU<gridpack::RealType> lu;
+  lu.analyze(n, &rowptr[0], &colidx[0]);
+  lu.factor(&values[0]);
+  BOOST_CHECK(solveError(lu, n, rowptr, colidx, values) < 1.0e-06);
+}
+
+BOOST_AUTO_TEST_CASE(Refactor)
+{
+  static const int n(200);
+  std::vector<int> rowptr, colidx;
+  std::vector<gridpack::RealType> values;
+  makeSystem(n, false, rowptr, colidx, values);
+
+  gridpack::math::SparseLU<gridpack::RealType> lu;
+  lu.analyze(n, &rowptr[0], &colidx[0]);
+  lu.factor(&values[0]);
+
+  // same pattern, new values
+  for (size_t k = 0; k < values.size(); ++k) {
+    values[k] *= 1.0 + 0.01*static_cast<double>(k % 7);
+  }
+  BOOST_CHECK(lu.samePattern(n, &rowptr[0], &colidx[0]));
+  BOOST_CHECK(lu.refactor(&values[0]));
+  BOOST_CHECK(solveError(lu, n, rowptr, colidx, values) < 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE(ComplexFactorSolve)
+{
+  static const int n(100);
+  std::vector<int> rowptr, colidx;
+  std::vector<gridpack::ComplexType> values;
+  makeSystem(n, true, rowptr, colidx, values);
+  for (size_t k = 0; k < values.size(); ++k) {
+    values[k] += gridpack::ComplexType(0.0, 0.5*static_cast<double>(k % 3));
+  }
+
+  gridpack::math::SparseLU<gridpack::ComplexType> lu;
+  lu.analyze(n, &rowptr[0], &colidx[0]);
+  lu.factor(&values[0]);
+  BOOST_CHECK(solveError(lu, n, rowptr, colidx, values) < 1.0e-06);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// -------------------------------------------------------------
+// init_function
+// -------------------------------------------------------------
+bool init_function()
+{
+  return true;
+}
+
+// -------------------------------------------------------------
+//  Main Program
+// -------------------------------------------------------------
+int
+main(int argc, char **argv)
+{
+  int result = ::boost::unit_test::unit_test_main( &init_function, argc, argv );
+  return result;
+}
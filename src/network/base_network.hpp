@@ -398,6 +398,7 @@ void addBus(int idx)
   bus->p_originalBusIndex = idx;
   bus->p_globalBusIndex = -1;
   p_buses.push_back(*bus);
+  p_busMatVecIndex.clear();
 }
 
 /**
@@ -527,6 +528,7 @@ bool setGlobalBusIndex(int idx, int g_idx)
     return false;
   } else {
     p_buses[idx].p_globalBusIndex = g_idx;
+    p_busMatVecIndex.clear();
     return true;
   }
 }
@@ -654,6 +656,7 @@ bool setActiveBus(int idx, bool flag)
   if (idx < 0 || idx >= p_buses.size()) {
     return false;
   } else {
+    if (p_buses[idx].p_activeBus != flag) p_busMatVecIndex.clear();
     p_buses[idx].p_activeBus = flag;
     return true;
   }
@@ -989,6 +992,7 @@ void assemble(void)
  */
 void partition(void)
 {
+  p_busMatVecIndex.clear();
   gridpack::utility::CoarseTimer *timer;
   timer = NULL;
 //  timer = gridpack::utility::CoarseTimer::instance();
@@ -1199,6 +1203,7 @@ void clean(void)
   std::map<int, int> branches;
   std::map<int, int>::iterator p;
   int i, j;
+  p_busMatVecIndex.clear();
   // remove all exchange buffers
   freeXCBus();
   freeXCBranch();
@@ -1378,6 +1383,7 @@ template <class _new_bus, class _new_branch> void clone(
 void resetGlobalIndices(bool flag)
 {
   int i;
+  p_busMatVecIndex.clear();
   int nprocs = communicator().size();
   int me = communicator().rank();
 
@@ -1525,6 +1531,7 @@ void resetGlobalIndices(bool flag)
 void clear(void)
 {
   int i, size;
+  p_busMatVecIndex.clear();
   // Clean up exchange buffers if they have been allocated
   if (p_busXCBufSize != 0 && p_busXCBuffers != NULL) {
     int size = p_buses.size();
@@ -2385,6 +2392,39 @@ void setMap(void)
   }
 }
 
+/**
+ * Store the MatVec indices of all local buses (active and ghost) so that
+ * they can be reused by any factory that sets up components on this
+ * network. The indices are discarded if buses are added, the network is
+ * repartitioned or buses change their active status or global index
+ * @param indices MatVec index of each local bus
+ */
+void setBusMatVecIndices(const std::vector<int> &indices)
+{
+  p_busMatVecIndex = indices;
+}
+
+/**
+ * Get the stored MatVec indices of all local buses
+ * @param indices MatVec index of each local bus
+ * @return false if no valid indices have been stored
+ */
+bool getBusMatVecIndices(std::vector<int> &indices) const
+{
+  if (p_busMatVecIndex.empty() ||
+      p_busMatVecIndex.size() != p_buses.size()) return false;
+  indices = p_busMatVecIndex;
+  return true;
+}
+
+/**
+ * Discard the stored MatVec indices
+ */
+void clearBusMatVecIndices(void)
+{
+  p_busMatVecIndex.clear();
+}
+
 /**
  * Find the local indices given the original index of a bus.
  * Ghost buses may show up more than once.
@@ -2514,6 +2554,12 @@ private:
    */
   std::multimap<int,int> p_busMap;
   std::multimap<std::pair<int,int>,int> p_branchMap;
+
+  /**
+   * MatVec indices of local buses, evaluated by the first factory that set
+   * up components on this network
+   */
+  std::vector<int> p_busMatVecIndex;
 };
 }  //namespace network
 }  //namespace gridpack
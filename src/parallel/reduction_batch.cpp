@@ -0,0 +1,284 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   reduction_batch.cpp
+ * 
+ * @brief  
+ * A utility for queueing up several global reductions and evaluating all
+ * of them with a single collective operation.
+ * 
+ */
+
+// -------------------------------------------------------------
+
+#include <cstdio>
+#include "gridpack/utilities/exception.hpp"
+#include "reduction_batch.hpp"
+
+namespace gridpack {
+namespace parallel {
+
+// User-defined reduction operation. The buffer consists of (operation,
+// value) pairs and the operation field is used to decide how the value
+// fields are combined. The operation fields are identical on all processors
+// so they pass through the reduction unchanged. Each pair is a single
+// element of a contiguous datatype, so len counts pairs and MPI never
+// splits a pair when it segments the buffer
+extern "C" {
+static void reduction_batch_op(void *in, void *inout, int *len,
+    MPI_Datatype *dtype)
+{
+  double *src = static_cast<double*>(in);
+  double *dest = static_cast<double*>(inout);
+  int i;
+  int npair = *len;
+  for (i=0; i<npair; i++) {
+    double x = src[2*i+1];
+    double &y = dest[2*i+1];
+    switch (static_cast<int>(dest[2*i])) {
+      case ReductionBatch::Sum:
+        y += x;
+        break;
+      case ReductionBatch::Max:
+        if (x > y) y = x;
+        break;
+      case ReductionBatch::Min:
+        if (x < y) y = x;
+        break;
+    }
+  }
+}
+
+// Delete callback for the attribute that is attached to MPI_COMM_SELF
+// when the reduction operation and pair datatype are created. Attributes on
+// MPI_COMM_SELF are deleted at the start of MPI_Finalize, so this frees the
+// shared MPI objects while MPI is still usable
+static int reduction_batch_free(MPI_Comm comm, int keyval, void *attr,
+    void *extra);
+}
+
+// Reduction operation and pair datatype shared by all batches. These are
+// created by the first batch and freed when MPI is finalized
+static bool s_typesCreated = false;
+static MPI_Op s_op;
+static MPI_Datatype s_type;
+
+extern "C" {
+static int reduction_batch_free(MPI_Comm comm, int keyval, void *attr,
+    void *extra)
+{
+  if (s_typesCreated) {
+    MPI_Op_free(&s_op);
+    MPI_Type_free(&s_type);
+    s_typesCreated = false;
+  }
+  MPI_Comm_free_keyval(&keyval);
+  return MPI_SUCCESS;
+}
+}
+
+// Create the reduction operation and pair datatype if this has not already
+// been done
+static void reduction_batch_create_types(void)
+{
+  if (s_typesCreated) return;
+  MPI_Op_create(&reduction_batch_op, 1, &s_op);
+  MPI_Type_contiguous(2, MPI_DOUBLE, &s_type);
+  MPI_Type_commit(&s_type);
+  int keyval;
+  MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &reduction_batch_free,
+      &keyval, NULL);
+  MPI_Comm_set_attr(MPI_COMM_SELF, keyval, NULL);
+  s_typesCreated = true;
+}
+
+// Default constructor
+ReductionBatch::ReductionBatch(const Communicator &comm)
+  : p_comm(static_cast<MPI_Comm>(comm)), p_reduced(false), p_pending(false),
+    p_request(MPI_REQUEST_NULL)
+{
+  reduction_batch_create_types();
+}
+
+// Default destructor
+ReductionBatch::~ReductionBatch(void)
+{
+  if (p_pending) wait();
+}
+
+// Add a value to the batch
+int ReductionBatch::p_add(ReductionOp op, double x)
+{
+  if (p_pending) {
+    char buf[256];
+    sprintf(buf,"ReductionBatch: cannot add values while reduction is pending\n");
+    printf("%s",buf);
+    throw gridpack::Exception(buf);
+  }
+  p_reduced = false;
+  int handle = p_send.size()/2;
+  p_send.push_back(static_cast<double>(op));
+  p_send.push_back(x);
+  return handle;
+}
+
+// Queue values for a global reduction
+int ReductionBatch::addSum(double x)
+{
+  return p_add(Sum, x);
+}
+
+int ReductionBatch::addSum(int x)
+{
+  return p_add(Sum, static_cast<double>(x));
+}
+
+int ReductionBatch::addSum(const double *x, int nvals)
+{
+  int i;
+  int handle = size();
+  for (i=0; i<nvals; i++) p_add(Sum, x[i]);
+  return handle;
+}
+
+int ReductionBatch::addSum(const int *x, int nvals)
+{
+  int i;
+  int handle = size();
+  for (i=0; i<nvals; i++) p_add(Sum, static_cast<double>(x[i]));
+  return handle;
+}
+
+int ReductionBatch::addMax(double x)
+{
+  return p_add(Max, x);
+}
+
+int ReductionBatch::addMax(int x)
+{
+  return p_add(Max, static_cast<double>(x));
+}
+
+int ReductionBatch::addMin(double x)
+{
+  return p_add(Min, x);
+}
+
+int ReductionBatch::addMin(int x)
+{
+  return p_add(Min, static_cast<double>(x));
+}
+
+// Queue a logical test that is evaluated over all processors
+int ReductionBatch::addAllTrue(bool flag)
+{
+  return p_add(Min, flag ? 1.0 : 0.0);
+}
+
+int ReductionBatch::addAnyTrue(bool flag)
+{
+  return p_add(Max, flag ? 1.0 : 0.0);
+}
+
+// Perform all queued reductions using a single collective operation
+void ReductionBatch::flush(void)
+{
+  start();
+  wait();
+}
+
+// Start all queued reductions without waiting for them to complete
+void ReductionBatch::start(void)
+{
+  if (p_pending) return;
+  int len = size();
+  p_recv.resize(p_send.size());
+  if (len == 0) {
+    p_reduced = true;
+    return;
+  }
+#if MPI_VERSION >= 3
+  MPI_Iallreduce(&p_send[0], &p_recv[0], len, s_type, s_op, p_comm,
+      &p_request);
+  p_pending = true;
+#else
+  MPI_Allreduce(&p_send[0], &p_recv[0], len, s_type, s_op, p_comm);
+  p_reduced = true;
+#endif
+}
+
+// Wait for reductions started with start to complete
+void ReductionBatch::wait(void)
+{
+  if (!p_pending) return;
+  MPI_Wait(&p_request, MPI_STATUS_IGNORE);
+  p_pending = false;
+  p_reduced = true;
+}
+
+// Check that handle refers to a value in a batch that has been flushed
+void ReductionBatch::p_checkHandle(int handle, int nvals) const
+{
+  if (!p_reduced || handle < 0 || handle+nvals > size()) {
+    char buf[256];
+    sprintf(buf,"ReductionBatch: illegal handle %d or batch not flushed\n",
+        handle);
+    printf("%s",buf);
+    throw gridpack::Exception(buf);
+  }
+}
+
+// Get the result of a reduction after the batch has been flushed
+double ReductionBatch::getDouble(int handle) const
+{
+  p_checkHandle(handle, 1);
+  return p_recv[2*handle+1];
+}
+
+int ReductionBatch::getInt(int handle) const
+{
+  p_checkHandle(handle, 1);
+  return static_cast<int>(p_recv[2*handle+1]);
+}
+
+bool ReductionBatch::getBool(int handle) const
+{
+  p_checkHandle(handle, 1);
+  return p_recv[2*handle+1] != 0.0;
+}
+
+void ReductionBatch::getValues(int handle, double *x, int nvals) const
+{
+  int i;
+  p_checkHandle(handle, nvals);
+  for (i=0; i<nvals; i++) x[i] = p_recv[2*(handle+i)+1];
+}
+
+void ReductionBatch::getValues(int handle, int *x, int nvals) const
+{
+  int i;
+  p_checkHandle(handle, nvals);
+  for (i=0; i<nvals; i++) x[i] = static_cast<int>(p_recv[2*(handle+i)+1]);
+}
+
+// Remove all values from the batch so that it can be reused
+void ReductionBatch::clear(void)
+{
+  if (p_pending) wait();
+  p_send.clear();
+  p_recv.clear();
+  p_reduced = false;
+}
+
+// Return number of values currently in the batch
+int ReductionBatch::size(void) const
+{
+  return p_send.size()/2;
+}
+
+} // namespace parallel
+} // namespace gridpack
@@ -0,0 +1,158 @@
+// Emacs Mode Line: -*- Mode:c++;-*-
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   reduction_batch.hpp
+ * 
+ * @brief  
+ * A utility for queueing up several global reductions (sums, maxima,
+ * minima and logical tests) and evaluating all of them with a single
+ * collective operation. Values are queued locally by each processor in the
+ * same order, the batch is flushed collectively and the reduced values can
+ * then be retrieved using the handles returned when the values were queued.
+ * 
+ */
+
+// -------------------------------------------------------------
+
+#ifndef _reduction_batch_hpp_
+#define _reduction_batch_hpp_
+
+#include <vector>
+#include "gridpack/utilities/uncopyable.hpp"
+#include "gridpack/parallel/communicator.hpp"
+
+namespace gridpack {
+namespace parallel {
+
+// -------------------------------------------------------------
+//  class ReductionBatch
+// -------------------------------------------------------------
+class ReductionBatch
+  : private utility::Uncopyable
+{
+public:
+
+  /// Types of reduction that can be queued
+  enum ReductionOp { Sum = 0, Max, Min };
+
+  /**
+   * Default constructor
+   * @param comm communicator over which reductions are performed
+   */
+  ReductionBatch(const Communicator &comm);
+
+  /**
+   * Default destructor
+   */
+  ~ReductionBatch(void);
+
+  /**
+   * Queue values for a global reduction. Integer values are carried as
+   * doubles so they must be smaller than 2^53 in magnitude
+   * @param x value (or vector of values) to be reduced
+   * @param nvals number of values in vector
+   * @return handle of (first) value in batch
+   */
+  int addSum(double x);
+  int addSum(int x);
+  int addSum(const double *x, int nvals);
+  int addSum(const int *x, int nvals);
+  int addMax(double x);
+  int addMax(int x);
+  int addMin(double x);
+  int addMin(int x);
+
+  /**
+   * Queue a logical test that is evaluated over all processors
+   * @param flag boolean flag on each processor
+   * @return handle of value in batch
+   */
+  int addAllTrue(bool flag);
+  int addAnyTrue(bool flag);
+
+  /**
+   * Perform all queued reductions using a single collective operation. This
+   * must be called on all processors in the communicator
+   */
+  void flush(void);
+
+  /**
+   * Start all queued reductions without waiting for them to complete. If
+   * non-blocking collectives are not available this is the same as flush.
+   * Results are not available until wait has been called
+   */
+  void start(void);
+
+  /**
+   * Wait for reductions started with start to complete
+   */
+  void wait(void);
+
+  /**
+   * Get the result of a reduction after the batch has been flushed
+   * @param handle handle returned when the value was queued
+   * @param x returned values
+   * @param nvals number of values in vector
+   * @return reduced value
+   */
+  double getDouble(int handle) const;
+  int getInt(int handle) const;
+  bool getBool(int handle) const;
+  void getValues(int handle, double *x, int nvals) const;
+  void getValues(int handle, int *x, int nvals) const;
+
+  /**
+   * Remove all values from the batch so that it can be reused
+   */
+  void clear(void);
+
+  /**
+   * @return number of values currently in the batch
+   */
+  int size(void) const;
+
+private:
+
+  /**
+   * Add a value to the batch
+   * @param op type of reduction
+   * @param x value
+   * @return handle of value
+   */
+  int p_add(ReductionOp op, double x);
+
+  /**
+   * Check that handle refers to a value in a batch that has been flushed
+   * @param handle handle of value
+   * @param nvals number of values starting at handle
+   */
+  void p_checkHandle(int handle, int nvals) const;
+
+  /// communicator for reductions
+  MPI_Comm p_comm;
+
+  /// packed (operation, value) pairs that are sent to the reduction
+  std::vector<double> p_send;
+
+  /// packed (operation, value) pairs containing the results
+  std::vector<double> p_recv;
+
+  /// true if the batch has been reduced and results are available
+  bool p_reduced;
+
+  /// true if a non-blocking reduction is outstanding
+  bool p_pending;
+
+  /// request handle for non-blocking reduction
+  MPI_Request p_request;
+};
+
+} // namespace parallel
+} // namespace gridpack
+
+#endif
@@ -20,6 +20,9 @@
 #ifndef _task_manager_hpp_
 #define _task_manager_hpp_
 
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include "gridpack/parallel/communicator.hpp"
 #include <ga.h>
 
@@ -29,6 +32,20 @@ namespace parallel {
 // -------------------------------------------------------------
 //  class TaskManager
 // -------------------------------------------------------------
+/**
+ * Dynamic distribution of tasks using shared GA counters. By default each
+ * call to nextTask takes one task from a single counter, in task order. The
+ * scheduling can be changed before calling set():
+ *  - setChunking() takes tasks from the counter in chunks. Guided chunks
+ *    start large and shrink as the remaining work decreases, so the
+ *    counter is accessed much less often without leaving a long tail
+ *  - set() with a list of costs hands out expensive tasks first and sizes
+ *    guided chunks by cost rather than number of tasks
+ *  - setQueues() splits the chunks between several counters, each serving
+ *    a block of processors. Processors that empty their own queue steal
+ *    chunks from the others
+ * All processors must use the same settings and costs.
+ */
 class TaskManager {
 public:
 
@@ -37,17 +54,7 @@ public:
    */
   TaskManager(void)
   {
-    p_grp = GA_Pgroup_get_world();
-
-    p_GAcounter = GA_Create_handle();
-    int one = 1;
-    GA_Set_data(p_GAcounter,one,&one,C_INT);
-    GA_Set_pgroup(p_GAcounter,p_grp);
-    if (!GA_Allocate(p_GAcounter)) {
-      // TODO: some kind of error
-    }
-    GA_Zero(p_GAcounter);
-    p_ntasks = 0;
+    p_initialize(GA_Pgroup_get_world());
   }
 
   /**
@@ -56,17 +63,7 @@ public:
    */
   TaskManager(Communicator &comm)
   {
-    p_grp = comm.getGroup();
-
-    p_GAcounter = GA_Create_handle();
-    int one = 1;
-    GA_Set_data(p_GAcounter,one,&one,C_INT);
-    GA_Set_pgroup(p_GAcounter,p_grp);
-    if (!GA_Allocate(p_GAcounter)) {
-      // TODO: some kind of error
-    }
-    GA_Zero(p_GAcounter);
-    p_ntasks = 0;
+    p_initialize(comm.getGroup());
   }
 
   /**
@@ -77,15 +74,115 @@ public:
     GA_Destroy(p_GAcounter);
   }
 
+  /**
+   * Take tasks from the counter in chunks. With guided chunking each chunk
+   * gets about 1/(factor*nprocs) of the remaining work, but at least
+   * minChunk tasks. If factor is zero or less every chunk has minChunk
+   * tasks. Takes effect at the next call to set()
+   * @param factor guided scheduling factor (typically 1 or 2)
+   * @param minChunk smallest number of tasks in a chunk
+   */
+  void setChunking(double factor, int minChunk = 1)
+  {
+    p_factor = factor;
+    p_minChunk = (minChunk > 1 ? minChunk : 1);
+  }
+
+  /**
+   * Split the chunks between several queues. Processors are divided into
+   * nqueues contiguous blocks that take chunks from their own queue first
+   * and then steal from the others. Takes effect at the next call to set()
+   * @param nqueues number of queues (at most the number of processors)
+   */
+  void setQueues(int nqueues)
+  {
+    int nprocs = GA_Pgroup_nnodes(p_grp);
+    if (nqueues < 1) nqueues = 1;
+    if (nqueues > nprocs) nqueues = nprocs;
+    p_nqueues = nqueues;
+  }
+
   /**
    * Specify total number of tasks and set task manager to zero
    * @param ntasks total number of tasks
    */
   void set(int ntasks)
+  {
+    std::vector<double> costs;
+    set(ntasks, costs);
+  }
+
+  /**
+   * Specify total number of tasks along with an estimate of the cost of
+   * each one. Tasks are handed out in order of decreasing cost (ties in task
+   * order) and guided chunks are sized by cost
+   * @param ntasks total number of tasks
+   * @param costs relative cost of each task (ignored if empty)
+   */
+  void set(int ntasks, const std::vector<double> &costs)
   {
     GA_Zero(p_GAcounter);
     p_ntasks = ntasks;
     p_task_count = 0;
+    p_chunk_count = 0;
+    p_steal_count = 0;
+    p_bufNext = 0;
+    p_bufEnd = 0;
+    p_order.clear();
+    p_chunkStart.clear();
+
+    int i;
+    bool useCosts = (static_cast<int>(costs.size()) == ntasks && ntasks > 0);
+    if (useCosts) {
+      std::vector<std::pair<double,int> > ranked(ntasks);
+      for (i=0; i<ntasks; i++) {
+        ranked[i] = std::pair<double,int>(-costs[i],i);
+      }
+      std::sort(ranked.begin(), ranked.end());
+      p_order.resize(ntasks);
+      for (i=0; i<ntasks; i++) p_order[i] = ranked[i].second;
+    }
+
+    // Chunks of fixed size are computed on the fly. Guided chunks are
+    // worked out here, the same way on every processor
+    if (p_factor > 0.0 && ntasks > 0) {
+      int nprocs = GA_Pgroup_nnodes(p_grp);
+      double remaining = 0.0;
+      for (i=0; i<ntasks; i++) {
+        remaining += (useCosts ? std::max(costs[p_order[i]],0.0) : 1.0);
+      }
+      int pos = 0;
+      while (pos < ntasks) {
+        p_chunkStart.push_back(pos);
+        double target = remaining/(p_factor*static_cast<double>(nprocs));
+        double work = 0.0;
+        int size = 0;
+        while (pos < ntasks && (size < p_minChunk || work < target)) {
+          double c = (useCosts ? std::max(costs[p_order[pos]],0.0) : 1.0);
+          work += c;
+          remaining -= c;
+          size++;
+          pos++;
+        }
+      }
+      p_chunkStart.push_back(ntasks);
+      p_nchunks = p_chunkStart.size()-1;
+    } else {
+      p_nchunks = (ntasks + p_minChunk - 1)/p_minChunk;
+    }
+
+    // Chunks are dealt out to queues round robin, so every queue sees
+    // expensive chunks first
+    int nprocs = GA_Pgroup_nnodes(p_grp);
+    int me = GA_Pgroup_nodeid(p_grp);
+    p_queueIndex.resize(p_nqueues);
+    p_queueSize.resize(p_nqueues);
+    p_queueDone.assign(p_nqueues, false);
+    for (i=0; i<p_nqueues; i++) {
+      p_queueIndex[i] = (i*nprocs)/p_nqueues;
+      p_queueSize[i] = (p_nchunks - i + p_nqueues - 1)/p_nqueues;
+    }
+    p_myQueue = (me*p_nqueues)/nprocs;
   }
   
   /**
@@ -96,10 +193,7 @@ public:
    * @return false if no other tasks are found
    */
   bool nextTask(int *next) {
-    int zero = 0;
-    long one = 1;
-    *next = static_cast<int>(NGA_Read_inc(p_GAcounter,&zero,one));
-    if (*next < p_ntasks) {
+    if (p_nextLocal(next)) {
       p_task_count++;
       return true;
     } else {
@@ -120,11 +214,12 @@ public:
    */
 
   bool nextTask(Communicator &comm, int *next) {
-    int zero = 0;
     long one = 1;
     int me = comm.rank();
+    // Only the first process in comm takes chunks from the counters, the
+    // others get the task from it
     if (me == 0) {
-      *next = static_cast<int>(NGA_Read_inc(p_GAcounter,&zero,one));
+      if (!p_nextLocal(next)) *next = p_ntasks;
     } else {
       *next = 0;
     }
@@ -148,8 +243,12 @@ public:
    * function or the counter will hang
    */
   void cancel(void) {
-    int zero = 0;
-    int n = static_cast<int>(NGA_Read_inc(p_GAcounter,&zero, p_ntasks));
+    int i;
+    for (i=0; i<p_nqueues; i++) {
+      long inc = p_queueSize[i];
+      NGA_Read_inc(p_GAcounter,&p_queueIndex[i],inc);
+    }
+    p_bufNext = p_bufEnd;
   }
 
   /**
@@ -158,28 +257,136 @@ public:
   void printStats() {
     int nprocs = GA_Pgroup_nnodes(p_grp);
     int me = GA_Pgroup_nodeid(p_grp);
-    int procs[nprocs];
+    int procs[3*nprocs];
     int i;
-    for (i=0; i<nprocs; i++) procs[i] = 0;
-    procs[GA_Pgroup_nodeid(p_grp)] = p_task_count;
+    for (i=0; i<3*nprocs; i++) procs[i] = 0;
+    procs[me] = p_task_count;
+    procs[nprocs+me] = p_chunk_count;
+    procs[2*nprocs+me] = p_steal_count;
     char plus[2];
     strcpy(plus,"+");
-    GA_Pgroup_igop(p_grp,procs,nprocs,plus);
+    GA_Pgroup_igop(p_grp,procs,3*nprocs,plus);
     // print out number of tasks evaluated on each processor
     if (me == 0) {
       printf("\nNumber of tasks per processors\n");
       for (i=0; i<nprocs; i++) {
-        printf("  Number of tasks on process %6d: %6d\n",i,procs[i]);
+        printf("  Number of tasks on process %6d: %6d (chunks %6d,"
+            " stolen %6d)\n",i,procs[i],procs[nprocs+i],procs[2*nprocs+i]);
       }
     }
   }
 
 protected:
+
+  /**
+   * Create counters and set default scheduling
+   * @param grp GA processor group
+   */
+  void p_initialize(int grp)
+  {
+    p_grp = grp;
+    // One counter per processor, so that the counter of each queue lives
+    // on a processor in the block that uses it
+    int nprocs = GA_Pgroup_nnodes(p_grp);
+    p_GAcounter = GA_Create_handle();
+    GA_Set_data(p_GAcounter,1,&nprocs,C_INT);
+    GA_Set_pgroup(p_GAcounter,p_grp);
+    if (!GA_Allocate(p_GAcounter)) {
+      // TODO: some kind of error
+    }
+    GA_Zero(p_GAcounter);
+    p_ntasks = 0;
+    p_task_count = 0;
+    p_chunk_count = 0;
+    p_steal_count = 0;
+    p_factor = 0.0;
+    p_minChunk = 1;
+    p_nqueues = 1;
+    p_nchunks = 0;
+    p_bufNext = 0;
+    p_bufEnd = 0;
+    p_myQueue = 0;
+    p_queueIndex.assign(1, 0);
+    p_queueSize.assign(1, 0);
+    p_queueDone.assign(1, false);
+  }
+
+  /**
+   * Get the next task on this processor, taking a new chunk from the
+   * counters when the current one is used up
+   * @param next index of next task
+   * @return false if all queues are empty
+   */
+  bool p_nextLocal(int *next)
+  {
+    if (p_bufNext >= p_bufEnd && !p_nextChunk()) return false;
+    *next = (p_order.empty() ? p_bufNext : p_order[p_bufNext]);
+    p_bufNext++;
+    return true;
+  }
+
+  /**
+   * Take a chunk from this processor's queue or, if it is empty, from
+   * another queue
+   * @return false if all queues are empty
+   */
+  bool p_nextChunk(void)
+  {
+    long one = 1;
+    int i;
+    for (i=0; i<p_nqueues; i++) {
+      int q = (p_myQueue+i)%p_nqueues;
+      if (p_queueDone[q]) continue;
+      int slot = static_cast<int>(NGA_Read_inc(p_GAcounter,
+            &p_queueIndex[q],one));
+      if (slot < p_queueSize[q]) {
+        int chunk = slot*p_nqueues + q;
+        if (p_chunkStart.empty()) {
+          p_bufNext = chunk*p_minChunk;
+          p_bufEnd = std::min(p_bufNext+p_minChunk, p_ntasks);
+        } else {
+          p_bufNext = p_chunkStart[chunk];
+          p_bufEnd = p_chunkStart[chunk+1];
+        }
+        p_chunk_count++;
+        if (i > 0) p_steal_count++;
+        return true;
+      }
+      // Counters only increase, so an empty queue stays empty
+      p_queueDone[q] = true;
+    }
+    return false;
+  }
   
   int p_GAcounter;
   int p_ntasks;
   int p_grp;
   int p_task_count;
+
+  // Scheduling parameters
+  double p_factor;
+  int p_minChunk;
+  int p_nqueues;
+
+  // Task order (empty for task order) and first task of each guided chunk
+  // (empty for fixed size chunks)
+  std::vector<int> p_order;
+  std::vector<int> p_chunkStart;
+  int p_nchunks;
+
+  // Counter element, number of chunks and status of each queue
+  std::vector<int> p_queueIndex;
+  std::vector<int> p_queueSize;
+  std::vector<bool> p_queueDone;
+  int p_myQueue;
+
+  // Positions in task order of the rest of the current chunk
+  int p_bufNext;
+  int p_bufEnd;
+
+  // Statistics
+  int p_chunk_count;
+  int p_steal_count;
 };
 
 
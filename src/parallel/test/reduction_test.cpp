@@ -0,0 +1,151 @@
+/*
+ *     Copyright (c) 2013 Battelle Memorial Institute
+ *     Licensed under modified BSD License. A copy of this license can be found
+ *     in the LICENSE file in the top level directory of this distribution.
+ */
+// -------------------------------------------------------------
+/**
+ * @file   reduction_test.cpp
+ * 
+ * @brief  A simple test of batched global reductions
+ * 
+ * 
+ */
+// -------------------------------------------------------------
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/collectives.hpp>
+#define BOOST_TEST_NO_MAIN
+#define BOOST_TEST_ALTERNATIVE_INIT_API
+#include <boost/test/included/unit_test.hpp>
+
+#include <vector>
+#include "gridpack/parallel/parallel.hpp"
+#include "gridpack/parallel/reduction_batch.hpp"
+
+BOOST_AUTO_TEST_SUITE ( ReductionBatchTest ) 
+
+BOOST_AUTO_TEST_CASE( mixed_reductions )
+{
+  gridpack::parallel::Communicator world;
+  int me = world.rank();
+  int nprocs = world.size();
+
+  gridpack::parallel::ReductionBatch batch(world);
+  int h_sum = batch.addSum(me+1);
+  int h_dsum = batch.addSum(0.5);
+  int h_max = batch.addMax(me);
+  int h_min = batch.addMin(static_cast<double>(me)+2.0);
+  int h_all = batch.addAllTrue(me != 0);
+  int h_any = batch.addAnyTrue(me == nprocs-1);
+  int vec[3];
+  vec[0] = 1;
+  vec[1] = me;
+  vec[2] = 2*me;
+  int h_vec = batch.addSum(vec,3);
+  BOOST_CHECK_EQUAL(batch.size(), 9);
+  batch.flush();
+
+  BOOST_CHECK_EQUAL(batch.getInt(h_sum), nprocs*(nprocs+1)/2);
+  BOOST_CHECK_CLOSE(batch.getDouble(h_dsum), 0.5*nprocs, 1.0e-12);
+  BOOST_CHECK_EQUAL(batch.getInt(h_max), nprocs-1);
+  BOOST_CHECK_CLOSE(batch.getDouble(h_min), 2.0, 1.0e-12);
+  BOOST_CHECK(!batch.getBool(h_all));
+  BOOST_CHECK(batch.getBool(h_any));
+  int result[3];
+  batch.getValues(h_vec,result,3);
+  BOOST_CHECK_EQUAL(result[0], nprocs);
+  BOOST_CHECK_EQUAL(result[1], nprocs*(nprocs-1)/2);
+  BOOST_CHECK_EQUAL(result[2], nprocs*(nprocs-1));
+}
+
+BOOST_AUTO_TEST_CASE( nonblocking_reuse )
+{
+  gridpack::parallel::Communicator world;
+  int nprocs = world.size();
+
+  gridpack::parallel::ReductionBatch batch(world);
+  int h = batch.addSum(1);
+  batch.start();
+  batch.wait();
+  BOOST_CHECK_EQUAL(batch.getInt(h), nprocs);
+
+  batch.clear();
+  BOOST_CHECK_EQUAL(batch.size(), 0);
+  h = batch.addAllTrue(true);
+  batch.flush();
+  BOOST_CHECK(batch.getBool(h));
+}
+
+BOOST_AUTO_TEST_CASE( long_batches )
+{
+  // Batches of different lengths with the operations interleaved, so that
+  // any split of the buffer that does not respect the (operation, value)
+  // pairs gives wrong results
+  gridpack::parallel::Communicator world;
+  int me = world.rank();
+  int nprocs = world.size();
+
+  int lengths[] = {1, 2, 3, 4, 5, 7, 17, 64, 129, 1000, 4099};
+  int nlen = sizeof(lengths)/sizeof(int);
+  int l, i;
+  for (l=0; l<nlen; l++) {
+    int n = lengths[l];
+    gridpack::parallel::ReductionBatch batch(world);
+    std::vector<int> handles(n);
+    for (i=0; i<n; i++) {
+      switch (i%3) {
+        case 0:
+          handles[i] = batch.addSum(i+me);
+          break;
+        case 1:
+          handles[i] = batch.addMax(static_cast<double>(i*me));
+          break;
+        case 2:
+          handles[i] = batch.addMin(i-me);
+          break;
+      }
+    }
+    if (l%2 == 0) {
+      batch.flush();
+    } else {
+      batch.start();
+      batch.wait();
+    }
+    int nerr = 0;
+    for (i=0; i<n; i++) {
+      int expected = 0;
+      switch (i%3) {
+        case 0:
+          expected = nprocs*i + nprocs*(nprocs-1)/2;
+          break;
+        case 1:
+          expected = i*(nprocs-1);
+          break;
+        case 2:
+          expected = i-(nprocs-1);
+          break;
+      }
+      if (batch.getInt(handles[i]) != expected) nerr++;
+    }
+    BOOST_CHECK_EQUAL(nerr, 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END( )
+
+bool init_function(void)
+{
+  return true;
+}
+
+// -------------------------------------------------------------
+//  Main Program
+// -------------------------------------------------------------
+int
+main(int argc, char **argv)
+{
+  gridpack::parallel::Environment env(argc, argv);
+  return ::boost::unit_test::unit_test_main( &init_function, argc, argv );
+}
@@ -25,6 +25,7 @@
 // -------------------------------------------------------------
 
 #include <iostream>
+#include <vector>
 #include <ga.h>
 #include "gridpack/parallel/parallel.hpp"
 #include "gridpack/parallel/task_manager.hpp"
@@ -38,6 +39,7 @@ main(int argc, char **argv)
 {
   gridpack::parallel::Environment env(argc, argv);
   GA_Initialize();
+  int rc = 0;
   // Create an artificial scope so that all objects call their destructors
   // before GA_Terminate is called
   if (1) {
@@ -79,6 +81,38 @@ main(int argc, char **argv)
             itask,lcomm.rank(),me,lcomm.size());
       }
     }
+    // Guided chunks, cost ordering and work stealing. Every task must be
+    // evaluated exactly once
+    ntasks = 37*nprocs+5;
+    std::vector<double> costs(ntasks);
+    for (i=0; i<ntasks; i++) costs[i] = static_cast<double>((7*i)%13);
+    std::vector<int> count(ntasks, 0);
+    tskmgr.setChunking(1.0, 2);
+    tskmgr.setQueues(2);
+    tskmgr.set(ntasks, costs);
+    while(tskmgr.nextTask(&itask)) {
+      count[itask]++;
+    }
+    world.sum(&count[0], ntasks);
+    int nbad = 0;
+    for (i=0; i<ntasks; i++) {
+      if (count[i] != 1) nbad++;
+    }
+    if (me == 0) {
+      if (nbad == 0) {
+        printf("\nGuided scheduling evaluated all %d tasks once\n",ntasks);
+      } else {
+        printf("\nGuided scheduling failed for %d out of %d tasks\n",
+            nbad,ntasks);
+      }
+    }
+    if (nbad > 0) {
+      rc = 1;
+    }
+    tskmgr.printStats();
+    tskmgr.setChunking(0.0, 1);
+    tskmgr.setQueues(1);
+
     // Check performance of task manager. Create a very large number of tasks.
     ntasks = 1000000*nprocs;
     tskmgr.set(ntasks);
@@ -96,6 +130,6 @@ main(int argc, char **argv)
   }
 
   GA_Terminate();
-  return 0;
+  return rc;
 }
 